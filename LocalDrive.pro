@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -8,6 +8,10 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# gzip request/response bodies in cpp-httplib (see CompressionPolicy)
+DEFINES += CPPHTTPLIB_ZLIB_SUPPORT
+LIBS += -lz
+
 # Add include paths for external libraries
 INCLUDEPATH += $$PWD/cpp-httplib
 INCLUDEPATH += $$PWD/json
@@ -15,25 +19,67 @@ INCLUDEPATH += $$PWD/json
 SOURCES += \
     apiclient.cpp \
     apiLogin.cpp \
+    apimetrics.cpp \
+    asyncapiclient.cpp \
+    changenotifier.cpp \
+    compressionpolicy.cpp \
+    connectionpool.cpp \
+    contentchunker.cpp \
+    deltaencoder.cpp \
+    diagnosticsdialog.cpp \
+    downloadsink.cpp \
     filecardwidget.cpp \
+    filecatalog.cpp \
+    filehasher.cpp \
     filehierarchyview.cpp \
+    filetypes.cpp \
+    folderuploader.cpp \
+    listingcache.cpp \
+    listingparser.cpp \
     loginwindow.cpp \
     main.cpp \
     MainWindow.cpp \
+    ratelimitdialog.cpp \
+    ratelimiter.cpp \
+    retrypolicy.cpp \
     searchbar.cpp \
     sidebar.cpp \
-    toolbar.cpp
+    tarstream.cpp \
+    toolbar.cpp \
+    transfermanager.cpp \
+    transferpanel.cpp
 
 HEADERS += \
     MainWindow.h \
     apiclient.h \
     apiLogin.h \
+    apimetrics.h \
+    asyncapiclient.h \
+    changenotifier.h \
+    compressionpolicy.h \
+    connectionpool.h \
+    contentchunker.h \
+    deltaencoder.h \
+    diagnosticsdialog.h \
+    downloadsink.h \
     filecardwidget.h \
+    filecatalog.h \
+    filehasher.h \
     filehierarchyview.h \
+    filetypes.h \
+    folderuploader.h \
+    listingcache.h \
+    listingparser.h \
     loginwindow.h \
+    ratelimitdialog.h \
+    ratelimiter.h \
+    retrypolicy.h \
     searchbar.h \
     sidebar.h \
-    toolbar.h
+    tarstream.h \
+    toolbar.h \
+    transfermanager.h \
+    transferpanel.h
 
 FORMS += \
     loginwindow.ui
@@ -3,25 +3,47 @@
 #include "SearchBar.h"
 #include "Toolbar.h"
 #include "FileHierarchyView.h"
-#include "APIClient.h"
+#include "asyncapiclient.h"
+#include "transfermanager.h"
+#include "transferpanel.h"
+#include "folderuploader.h"
+#include "diagnosticsdialog.h"
+#include "ratelimitdialog.h"
+#include "changenotifier.h"
 
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QDebug>
 #include <QPalette>
 #include <QFileDialog>
+#include <QProgressDialog>
 #include <QFile>
 #include <QFileInfo>
 #include <QMessageBox>
 #include <QDateTime>
 #include <QSettings>
+#include <QShortcut>
+#include <QKeySequence>
+#include <QTimer>
+#include <algorithm>
+
+namespace {
+
+/// Minimum time between view refreshes while a listing streams in.
+constexpr int kListingRefreshMs = 500;
+
+} // namespace
 
 /**
  * @author Harshi Kamboj
  * @brief Constructs the MainWindow and sets up the full application UI.
  */
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), m_fileView(nullptr)
+    : QMainWindow(parent), m_fileView(nullptr), m_api(new AsyncAPIClient("http://localhost:8080", this)),
+      m_transfers(new TransferManager("http://localhost:8080", this)),
+      m_folderUploader(new FolderUploader("http://localhost:8080", this)),
+      m_notifier(new ChangeNotifier("http://localhost:8080", this)),
+      m_listingRefresh(new QTimer(this))
 {
     QPalette pal = palette();
     pal.setColor(QPalette::Window, Qt::white);
@@ -59,6 +81,9 @@ MainWindow::MainWindow(QWidget *parent)
 
     mainLayout->addLayout(contentLayout, 1);
 
+    TransferPanel *transferPanel = new TransferPanel(m_transfers, this);
+    mainLayout->addWidget(transferPanel, 0);
+
     connect(sidebar, &Sidebar::categorySelected, m_fileView, &FileHierarchyView::setCategory);
     connect(toolbar, &Toolbar::sortRequested, [this](int criteria){
         SortCriteria sc = static_cast<SortCriteria>(criteria);
@@ -70,8 +95,58 @@ MainWindow::MainWindow(QWidget *parent)
     connect(searchBar, &QLineEdit::textChanged, m_fileView, &FileHierarchyView::setSearchTerm);
     connect(toolbar, &Toolbar::uploadRequested, this, &MainWindow::onUploadRequested);
     connect(toolbar, &Toolbar::downloadRequested, this, &MainWindow::onDownloadRequested);
+    connect(toolbar, &Toolbar::uploadFolderRequested, this, &MainWindow::onUploadFolderRequested);
+    connect(m_folderUploader, &FolderUploader::filesUploaded, this, &MainWindow::onFolderFilesUploaded);
+
+    QShortcut *refresh = new QShortcut(QKeySequence("F5"), this);
+    connect(refresh, &QShortcut::activated, this, &MainWindow::onRefreshRequested);
+
+    QShortcut *diagnostics = new QShortcut(QKeySequence("Ctrl+Shift+D"), this);
+    connect(diagnostics, &QShortcut::activated, this, [this]() {
+        DiagnosticsDialog dialog(this);
+        dialog.exec();
+    });
+
+    QShortcut *limits = new QShortcut(QKeySequence("Ctrl+Shift+L"), this);
+    connect(limits, &QShortcut::activated, this, [this]() {
+        RateLimitDialog dialog(this);
+        dialog.exec();
+    });
+    connect(m_folderUploader, &FolderUploader::progress, this, [this](int processed, int found, bool walkDone) {
+        if (!m_folderProgress)
+            return;
+        // Until the walk finishes the total is unknown; show a busy indicator.
+        m_folderProgress->setMaximum(walkDone ? found : 0);
+        m_folderProgress->setValue(processed);
+        m_folderProgress->setLabelText(QString("Uploaded %1 of %2%3 files")
+                                           .arg(processed).arg(found).arg(walkDone ? "" : "+"));
+    });
+    connect(m_folderUploader, &FolderUploader::finished, this, [this](int succeeded, int failed) {
+        if (m_folderProgress) {
+            m_folderProgress->deleteLater();
+            m_folderProgress = nullptr;
+        }
+        if (failed > 0)
+            QMessageBox::warning(this, "Folder Upload",
+                                 QString("%1 files uploaded, %2 failed.").arg(succeeded).arg(failed));
+    });
     connect(m_fileView, &FileHierarchyView::selectionInfoChanged,
             toolbar, &Toolbar::onSelectionInfoChanged);
+    connect(m_api, &AsyncAPIClient::filesListed, this, &MainWindow::onFilesListed);
+    connect(m_api, &AsyncAPIClient::listingFinished, this, &MainWindow::onListingFinished);
+    connect(m_api, &AsyncAPIClient::changesFetched, this, &MainWindow::onChangesFetched);
+    connect(m_notifier, &ChangeNotifier::changesPushed, this, &MainWindow::onChangesPushed);
+    connect(m_notifier, &ChangeNotifier::resyncRequired, this, [this]() {
+        if (!m_refreshing)
+            loadStoredFiles();
+    });
+    m_listingRefresh->setSingleShot(true);
+    m_listingRefresh->setInterval(kListingRefreshMs);
+    connect(m_listingRefresh, &QTimer::timeout, this, [this]() {
+        if (m_fileView)
+            m_fileView->updateView();
+    });
+    connect(m_transfers, &TransferManager::jobFinished, this, &MainWindow::onTransferFinished);
 
     setWindowTitle("Local Drive Client");
     resize(1000, 600);
@@ -94,102 +169,185 @@ void MainWindow::loadUserPreferences() {
 }
 
 /**
- * @brief Maps a file extension to its corresponding icon filename.
- * @param extension The file extension (e.g., ".pdf").
- * @return A QString representing the icon filename.
+ * @brief Requests the list of files stored on the API server.
+ *
+ * The request runs in the background; onFilesListed() fills in the view.
+ * Any files already shown are dropped first.
  */
-QString MainWindow::getIconForExtension(const QString &extension) {
-    QString ext = extension.toLower();
-    if(ext == ".pdf")
-        return "pdf.png";
-    else if(ext == ".doc" || ext == ".docx")
-        return "word.png";
-    else if(ext == ".xls" || ext == ".xlsx")
-        return "excel.png";
-    else if(ext == ".ppt" || ext == ".pptx")
-        return "ppt.png";
-    else if(ext == ".mp3" || ext == ".wav" || ext == ".flac" || ext == ".aac" || ext == ".m4a" || ext == ".ogg")
-        return "music.png";
-    else if(ext == ".mp4" || ext == ".avi" || ext == ".mkv" || ext == ".mov" || ext == ".wmv" || ext == ".flv")
-        return "video.png";
-    else if(ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".gif" || ext == ".bmp" ||
-             ext == ".svg" || ext == ".tiff" || ext == ".webp" || ext == ".heif")
-        return "image.png";
-    else if(ext == ".txt" || ext == ".html" || ext == ".rtf" || ext == ".csv")
-        return "doc.png";
-    else
-        return "random.png";
+void MainWindow::loadStoredFiles() {
+    if (!allFiles.isEmpty()) {
+        allFiles.clear();
+        if (m_fileView)
+            m_fileView->updateView();
+    }
+    m_notifier->stop();
+    m_listingShown = false;
+    m_refreshing = true;
+    m_changeSeq = -1;
+    m_api->listFiles();
 }
 
 /**
- * @brief Loads the list of files stored on the API server and updates the UI.
+ * @brief Adds the server's files to the list and updates the UI.
  *
  * Also loads persisted favorite file names from QSettings.
  */
-void MainWindow::loadStoredFiles() {
-    APIClient apiClient;
-    std::vector<QString> storedFiles = apiClient.listFiles();
-
+void MainWindow::onFilesListed(const QList<APIClient::RemoteFile> &storedFiles) {
     // Load the list of favorite file names from QSettings.
     QSettings settings("YourCompany", "LocalDrive");
     QStringList favorites = settings.value("favorites").toStringList();
 
-    for (const auto &filename : storedFiles) {
-        if (filename == ".DS_Store")
+    for (const auto &stored : storedFiles) {
+        if (stored.name == ".DS_Store")
             continue;
+        allFiles.append(FileCatalog::fileDataFor(stored, favorites));
+    }
+    if (!m_listingShown) {
+        m_listingShown = true;
+        if (m_fileView)
+            m_fileView->updateView();
+    } else if (!m_listingRefresh->isActive()) {
+        m_listingRefresh->start();
+    }
+}
 
-        FileData fileData;
-        fileData.fileName = filename;
-        int dotIndex = filename.lastIndexOf('.');
-        fileData.extension = (dotIndex != -1) ? filename.mid(dotIndex).toLower() : "";
-        fileData.dateModified = QDateTime::currentDateTime(); // Placeholder
-        fileData.iconName = getIconForExtension(fileData.extension);
+/**
+ * @brief Flushes the pending refresh so the view shows the complete listing.
+ */
+void MainWindow::onListingFinished(bool success, qint64 sequence) {
+    if (!success)
+        qDebug() << "File listing ended early; showing" << allFiles.size() << "files";
+    m_refreshing = false;
+    // An incomplete list cannot be patched; the next refresh relists.
+    m_changeSeq = success ? sequence : -1;
+    m_listingRefresh->stop();
+    if (m_fileView)
+        m_fileView->updateView();
+    // Servers without a change journal have nothing to push.
+    if (m_changeSeq >= 0)
+        m_notifier->start(m_changeSeq);
+}
 
-        // Mark as favorite if found in settings.
-        fileData.isFavorite = favorites.contains(filename);
+/**
+ * @brief Asks for the changes since the last sync, or relists if there is no sequence yet.
+ */
+void MainWindow::onRefreshRequested() {
+    if (m_refreshing)
+        return;
+    if (m_changeSeq < 0) {
+        loadStoredFiles();
+        return;
+    }
+    m_refreshing = true;
+    m_api->fetchChanges(m_changeSeq);
+}
 
-        allFiles.append(fileData);
+/**
+ * @brief Patches the list from the journal; an unchanged server costs no UI work.
+ */
+void MainWindow::onChangesFetched(APIClient::ChangesResult result, const QList<APIClient::FileChange> &changes,
+                                  qint64 latest) {
+    m_refreshing = false;
+    switch (result) {
+    case APIClient::ChangesResult::Ok:
+        // Pushed changes may already have moved past the fetched range.
+        m_changeSeq = std::max(m_changeSeq, latest);
+        if (!changes.isEmpty())
+            applyChanges(changes);
+        break;
+    case APIClient::ChangesResult::Expired:
+        loadStoredFiles();
+        break;
+    case APIClient::ChangesResult::Failed:
+        qDebug() << "Refresh failed; the file list may be out of date";
+        break;
     }
-    if(m_fileView)
-        m_fileView->updateView();
+}
+
+/**
+ * @brief Patches the list from a pushed change set unless F5 already covered it.
+ *
+ * ChangeNotifier times this handler as part of the push delivery metric.
+ */
+void MainWindow::onChangesPushed(const QList<APIClient::FileChange> &changes, qint64 sequence) {
+    if (m_changeSeq < 0 || sequence <= m_changeSeq)
+        return;
+    m_changeSeq = sequence;
+    if (changes.isEmpty())
+        return;
+    applyChanges(changes);
+}
+
+/**
+ * @brief Patches allFiles from the journal with the saved favorites, then updates the changed cards.
+ */
+void MainWindow::applyChanges(const QList<APIClient::FileChange> &changes) {
+    QSettings settings("YourCompany", "LocalDrive");
+    FileCatalog::applyChanges(allFiles, changes, settings.value("favorites").toStringList());
+    if (m_fileView)
+        m_fileView->refreshCards();
 }
 
 /**
  * @brief Handles the Upload button click.
  *
- * Opens a file dialog to select a file, uploads it via the API, and adds its metadata to the list.
+ * Opens a file dialog to select a file and queues it for upload.
  */
 void MainWindow::onUploadRequested() {
     QString filePath = QFileDialog::getOpenFileName(this, "Select File to Upload");
     if(filePath.isEmpty())
         return;
 
-    APIClient apiClient;
-    bool success = apiClient.uploadFile(filePath);
-    if(success) {
-        QMessageBox::information(this, "Upload", "File uploaded successfully!");
-
-        QFileInfo fileInfo(filePath);
-        FileData newFile;
-        newFile.fileName = fileInfo.fileName();
-        newFile.extension = "." + fileInfo.suffix().toLower();
-        newFile.dateModified = QDateTime::currentDateTime();
-        newFile.iconName = getIconForExtension(newFile.extension);
+    // Re-uploading a name the server already has only sends what changed.
+    QString fileName = QFileInfo(filePath).fileName();
+    bool replaces = std::any_of(allFiles.begin(), allFiles.end(), [&fileName](const FileData &file) {
+        return file.fileName == fileName;
+    });
+    m_transfers->enqueueUpload(filePath, 0, replaces);
+}
 
-        allFiles.append(newFile);
-        if(m_fileView)
-            m_fileView->updateView();
+/**
+ * @brief Handles the Upload Folder button click.
+ *
+ * Opens a directory dialog and starts a background folder upload with a
+ * cancellable progress dialog.
+ */
+void MainWindow::onUploadFolderRequested() {
+    if (m_folderUploader->isRunning()) {
+        QMessageBox::information(this, "Folder Upload", "A folder upload is already in progress.");
+        return;
     }
-    else {
-        QMessageBox::warning(this, "Upload", "File upload failed.");
+    QString directory = QFileDialog::getExistingDirectory(this, "Select Folder to Upload");
+    if (directory.isEmpty() || !m_folderUploader->start(directory))
+        return;
+
+    m_folderProgress = new QProgressDialog("Scanning folder...", "Cancel", 0, 0, this);
+    m_folderProgress->setWindowTitle("Folder Upload");
+    m_folderProgress->setMinimumDuration(500);
+    connect(m_folderProgress, &QProgressDialog::canceled, m_folderUploader, &FolderUploader::cancel);
+}
+
+/**
+ * @brief Adds each stored file from a folder upload to the file list.
+ */
+void MainWindow::onFolderFilesUploaded(const QStringList &remoteNames) {
+    for (const QString &name : remoteNames) {
+        FileData fileData;
+        fileData.fileName = name;
+        fileData.extension = "." + QFileInfo(name).suffix().toLower();
+        fileData.dateModified = QDateTime::currentDateTime();
+        fileData.iconName = FileCatalog::iconForExtension(fileData.extension);
+        allFiles.append(fileData);
     }
+    if(m_fileView)
+        m_fileView->updateView();
 }
 
 /**
  * @brief Handles the Download button click.
  *
  * Ensures exactly one file is selected, prompts the user for a save location,
- * and downloads the file via the API.
+ * and queues the download.
  */
 void MainWindow::onDownloadRequested() {
     // Ensure exactly one file is selected.
@@ -211,10 +369,42 @@ void MainWindow::onDownloadRequested() {
     if(savePath.isEmpty())
         return;
 
-    APIClient apiClient;
-    bool success = apiClient.downloadFile(fileName, savePath);
-    if(success)
-        QMessageBox::information(this, "Download", "File downloaded successfully.");
-    else
-        QMessageBox::warning(this, "Download", "Failed to download file.");
+    // The listed size lets the queue pick a segmented download for large files.
+    const qint64 size = std::max<qint64>(0, allFiles[selectedIndex].size);
+    m_transfers->enqueueDownload(fileName, savePath, size);
+}
+
+/**
+ * @brief Handles a transfer leaving the running state.
+ *
+ * Progress and failures are shown in the transfer panel; a completed upload
+ * also adds its metadata to the file list.
+ */
+void MainWindow::onTransferFinished(int jobId, bool success) {
+    TransferJob job = m_transfers->job(jobId);
+    if (!success || job.type != TransferJob::Type::Upload)
+        return;
+
+    QFileInfo fileInfo(job.localPath);
+    for (FileData &file : allFiles) {
+        if (file.fileName == fileInfo.fileName()) {
+            file.dateModified = QDateTime::currentDateTime();
+            file.size = fileInfo.size();
+            file.contentHash.clear();
+            if(m_fileView)
+                m_fileView->updateView();
+            return;
+        }
+    }
+
+    FileData newFile;
+    newFile.fileName = fileInfo.fileName();
+    newFile.extension = "." + fileInfo.suffix().toLower();
+    newFile.dateModified = QDateTime::currentDateTime();
+    newFile.size = fileInfo.size();
+    newFile.iconName = FileCatalog::iconForExtension(newFile.extension);
+
+    allFiles.append(newFile);
+    if(m_fileView)
+        m_fileView->updateView();
 }
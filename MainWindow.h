@@ -5,7 +5,10 @@
 #include <QDateTime>
 #include <QList>
 #include <QString>
+#include <QStringList>
 #include <QWidget>
+#include "APIClient.h"
+#include "filecatalog.h"
 
 
 /**
@@ -22,16 +25,13 @@ enum class SortCriteria {
     TypeDesc     ///< Sort by file type descending
 };
 
-struct FileData {
-    QString iconName;         ///< Icon used for display (e.g., "pdf.png")
-    QString fileName;         ///< File name shown to user
-    QString extension;        ///< File extension/type
-    bool isFavorite = false;  ///< Whether marked as favorite
-    bool isSelected = false;  ///< Whether currently selected
-    QDateTime dateModified;   ///< Last modified date
-};
-
 class FileHierarchyView;
+class AsyncAPIClient;
+class TransferManager;
+class FolderUploader;
+class ChangeNotifier;
+class QProgressDialog;
+class QTimer;
 
 /**
  * @class MainWindow
@@ -63,12 +63,79 @@ private slots:
     void onUploadRequested();
     void onDownloadRequested();  // New slot for downloading
 
+    /**
+     * @brief Asks for a directory and uploads its whole tree in the background.
+     */
+    void onUploadFolderRequested();
+
+    /**
+     * @brief Adds files stored by a folder upload to the view.
+     * @param remoteNames Server names, relative to the uploaded folder's parent.
+     */
+    void onFolderFilesUploaded(const QStringList &remoteNames);
+
+    /**
+     * @brief Adds one batch of the server listing to the file list.
+     *
+     * The first batch is shown at once; later ones are folded into a periodic
+     * refresh so a long listing does not rebuild the view for every batch.
+     * @param storedFiles Entries reported by the server.
+     */
+    void onFilesListed(const QList<APIClient::RemoteFile> &storedFiles);
+
+    /**
+     * @brief Shows whatever the listing left pending once it ends.
+     * @param sequence Change sequence the listing reflects, or -1 if the server has no journal.
+     */
+    void onListingFinished(bool success, qint64 sequence);
+
+    /**
+     * @brief Brings the file list up to date (F5).
+     *
+     * Patches the list from the server's change journal when a sequence is
+     * known, and falls back to a full listing otherwise.
+     */
+    void onRefreshRequested();
+
+    /**
+     * @brief Applies fetched journal changes, or relists if the journal expired.
+     */
+    void onChangesFetched(APIClient::ChangesResult result, const QList<APIClient::FileChange> &changes,
+                          qint64 latest);
+
+    /**
+     * @brief Applies a change set pushed by the server.
+     */
+    void onChangesPushed(const QList<APIClient::FileChange> &changes, qint64 sequence);
+
+    /**
+     * @brief Adds a file to the view once its queued upload completes.
+     * @param jobId The finished transfer job.
+     * @param success Whether the transfer completed.
+     */
+    void onTransferFinished(int jobId, bool success);
+
 private:
     QList<FileData> allFiles;
     FileHierarchyView *m_fileView;
+    AsyncAPIClient *m_api;           ///< Runs server requests off the GUI thread
+    TransferManager *m_transfers;    ///< Background queue for uploads and downloads
+    FolderUploader *m_folderUploader; ///< Walks and uploads directory trees
+    ChangeNotifier *m_notifier;      ///< Streams other devices' changes once a listing is loaded
+    QProgressDialog *m_folderProgress = nullptr; ///< Progress of the running folder upload
+    QTimer *m_listingRefresh;        ///< Coalesces view refreshes while a listing streams in
+    bool m_listingShown = false;     ///< Whether the running listing has been shown yet
+    bool m_refreshing = false;       ///< A listing or change fetch is in flight
+    qint64 m_changeSeq = -1;         ///< Server change sequence allFiles reflects, or -1 if unknown
 
-    QString getIconForExtension(const QString &extension);
     void loadStoredFiles();
+
+    /**
+     * @brief Patches allFiles in place, keeping favorite and selection state.
+     *
+     * The view is updated card by card rather than rebuilt.
+     */
+    void applyChanges(const QList<APIClient::FileChange> &changes);
 };
 
 #endif // MAINWINDOW_H
@@ -1,78 +1,1381 @@
 #include "APIClient.h"
+#include "apimetrics.h"
+#include "connectionpool.h"
+#include "contentchunker.h"
+#include "deltaencoder.h"
+#include "listingcache.h"
+#include "listingparser.h"
+#include "downloadsink.h"
+#include "ratelimiter.h"
+#include "retrypolicy.h"
+#include "tarstream.h"
 #include <QFile>
 #include <QFileInfo>
 #include <QByteArray>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QTemporaryFile>
+#include <QThreadPool>
 #include <QUrl>
+#include <QUuid>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 #include "cpp-httplib/httplib.h"
 #include "json/json.hpp"
+#ifdef Q_OS_LINUX
+#include <sys/mman.h>
+#endif
 
 /**
  * @brief Constructs the API client with the given server URL.
+ *
+ * The client is cheap to create: connections come from the shared ConnectionPool.
  */
 APIClient::APIClient(const QString &serverUrl)
     : m_serverUrl(serverUrl)
 {
 }
 
+namespace {
+
+/**
+ * @brief Runs one request under a RequestTimer, counting @p bytesOut and the response body.
+ *
+ * A transport failure leaves the connection in an unknown state, so @p lease
+ * is discarded rather than returned to the pool.
+ */
+template <typename Send>
+httplib::Result timed(ConnectionPool::Lease &lease, const std::string &endpoint, qint64 bytesOut, Send send) {
+    RequestTimer timer(endpoint);
+    timer.addBytesOut(bytesOut);
+    httplib::Result res = send();
+    timer.finish(res ? res->status : 0, res ? static_cast<qint64>(res->body.size()) : 0);
+    if (!res) {
+        lease.discard();
+    }
+    return res;
+}
+
+/**
+ * @brief Returns true for transport failures worth another attempt; a cancel is final.
+ */
+bool isTransientError(httplib::Error error) {
+    switch (error) {
+    case httplib::Error::Connection:
+    case httplib::Error::Read:
+    case httplib::Error::Write:
+    case httplib::Error::ConnectionTimeout:
+    case httplib::Error::SSLConnection:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Sends a request under @p policy, timing each attempt and backing off after transient failures.
+ *
+ * @p send is called again for every attempt, so it must rebuild any per-attempt
+ * state such as a content provider's position. Mutating requests pass the same
+ * Idempotency-Key header on every attempt.
+ */
+template <typename Send>
+httplib::Result retried(RetryPolicy::Operation operation, ConnectionPool::Lease &lease, const std::string &endpoint,
+                        qint64 bytesOut, Send send) {
+    const RetryPolicy policy = RetryPolicy::forOperation(operation);
+    std::chrono::milliseconds waited(0);
+    for (int attempt = 1;; ++attempt) {
+        httplib::Result res = timed(lease, endpoint, bytesOut, send);
+        bool transient = res ? RetryPolicy::isTransientStatus(res->status) : isTransientError(res.error());
+        if (!transient) {
+            return res;
+        }
+        std::chrono::milliseconds retryAfter(0);
+        if (res) {
+            retryAfter = RetryPolicy::parseRetryAfter(res->get_header_value("Retry-After"));
+        }
+        std::chrono::milliseconds delay = policy.delayFor(attempt, retryAfter);
+        if (!policy.allows(attempt, waited, delay)) {
+            return res;
+        }
+        APIMetrics::instance().recordRetry(endpoint);
+        std::this_thread::sleep_for(delay);
+        waited += delay;
+    }
+}
+
+/**
+ * @brief Returns headers carrying a fresh Idempotency-Key, to be reused on every attempt.
+ */
+httplib::Headers idempotencyHeaders() {
+    return { { "Idempotency-Key", RetryPolicy::newIdempotencyKey() } };
+}
+
+/// Longest a background transfer waits for interactive requests before sending its next block.
+constexpr std::chrono::microseconds kMaxYield(250000);
+
+/**
+ * @brief Returns the steady clock in microseconds, for timestamps kept in atomics.
+ */
+qint64 steadyMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+/**
+ * @brief Installs per-client token buckets; a zero rate removes that cap.
+ */
+void APIClient::setRateLimits(qint64 uploadBytesPerSecond, qint64 downloadBytesPerSecond) {
+    setRateLimiters(uploadBytesPerSecond > 0 ? std::make_shared<RateLimiter>(uploadBytesPerSecond) : nullptr,
+                    downloadBytesPerSecond > 0 ? std::make_shared<RateLimiter>(downloadBytesPerSecond) : nullptr);
+}
+
+/**
+ * @brief Shares the caller's buckets, so their rate can follow changes made during a transfer.
+ */
+void APIClient::setRateLimiters(std::shared_ptr<RateLimiter> upload, std::shared_ptr<RateLimiter> download) {
+    m_uploadLimiter = std::move(upload);
+    m_downloadLimiter = std::move(download);
+}
+
+/**
+ * @brief Updates the shared buckets and remembers the caps for the next start.
+ */
+void APIClient::setGlobalRateLimits(qint64 uploadBytesPerSecond, qint64 downloadBytesPerSecond) {
+    RateLimiter::globalUpload().setRate(uploadBytesPerSecond);
+    RateLimiter::globalDownload().setRate(downloadBytesPerSecond);
+    QSettings settings("YourCompany", "LocalDrive");
+    settings.setValue("limits/upload", uploadBytesPerSecond);
+    settings.setValue("limits/download", downloadBytesPerSecond);
+}
+
+/**
+ * @brief Yields to interactive traffic if this is a background client, then takes tokens.
+ *
+ * Bytes are charged to the global bucket first and then to this client's own
+ * cap, so a transfer runs at the lower of the two.
+ *
+ * The time since the previous block approximates how long that block spent on
+ * the wire. With n interactive requests in flight the background client waits
+ * n times that long, so it keeps roughly 1/(n+1) of the link instead of
+ * stalling; each wait is capped at kMaxYield.
+ */
+void APIClient::throttle(Direction direction, qint64 bytes) const {
+    if (m_transferClass == TransferClass::Background) {
+        const int interactive = RateLimiter::interactiveCount();
+        const qint64 previous = m_lastBlockEnd.load();
+        if (interactive > 0 && previous >= 0) {
+            std::chrono::microseconds busy(std::max<qint64>(0, steadyMicros() - previous));
+            std::this_thread::sleep_for(std::min(busy * interactive, kMaxYield));
+        }
+    }
+    if (direction == Direction::Upload) {
+        RateLimiter::globalUpload().consume(bytes);
+        if (m_uploadLimiter) {
+            m_uploadLimiter->consume(bytes);
+        }
+    } else {
+        RateLimiter::globalDownload().consume(bytes);
+        if (m_downloadLimiter) {
+            m_downloadLimiter->consume(bytes);
+        }
+    }
+    m_lastBlockEnd.store(steadyMicros());
+}
+
+/**
+ * @brief Returns a callback that throttles on the growth of the reported byte count.
+ *
+ * Growth is measured from @p start, the offset a resumed transfer begins at,
+ * so the first block is charged like any other. A count that goes backwards
+ * means a retry restarted the body from the top, and the new count is charged
+ * from zero.
+ */
+APIClient::ProgressCallback APIClient::throttled(Direction direction, const ProgressCallback &progress,
+                                                 qint64 start) const {
+    auto last = std::make_shared<qint64>(start);
+    return [this, direction, progress, last](qint64 transferred, qint64 total) {
+        const qint64 from = transferred < *last ? 0 : *last;
+        if (transferred > from) {
+            throttle(direction, transferred - from);
+        }
+        *last = transferred;
+        return !progress || progress(transferred, total);
+    };
+}
+
+/**
+ * @brief Marks interactive transfers so background ones yield to them.
+ */
+std::unique_ptr<RateLimiter::InteractiveScope> APIClient::markInteractive() const {
+    if (m_transferClass == TransferClass::Interactive) {
+        return std::make_unique<RateLimiter::InteractiveScope>();
+    }
+    return nullptr;
+}
+
+namespace {
+
+/// Size of each block read from disk while streaming an upload body.
+constexpr qint64 kUploadChunkSize = 64 * 1024;
+
+/// Size of each block handed to the socket straight from a memory-mapped file.
+constexpr qint64 kMappedChunkSize = 256 * 1024;
+
+/**
+ * @brief Maps a whole file for one sequential pass, or returns nullptr to use buffered reads.
+ *
+ * Writing from the mapping sends page-cache pages to the socket without first
+ * copying them into a user-space buffer. Only enabled on Linux, where the
+ * sequential-access hint makes the kernel read ahead aggressively.
+ */
+const uchar *mapForStreaming(QFile &file) {
+#ifdef Q_OS_LINUX
+    if (file.size() <= 0) {
+        return nullptr;
+    }
+    uchar *data = file.map(0, file.size());
+    if (data) {
+        madvise(data, static_cast<size_t>(file.size()), MADV_SEQUENTIAL);
+    }
+    return data;
+#else
+    Q_UNUSED(file);
+    return nullptr;
+#endif
+}
+
+/**
+ * @brief A single-file multipart/form-data body that is read from disk on demand.
+ *
+ * The multipart envelope is small and kept in memory. On Linux the file is
+ * memory-mapped and its pages are written to the socket directly; elsewhere, or
+ * if mapping fails, the contents go through a reusable fixed-size buffer. Either
+ * way peak memory does not depend on the size of the file.
+ */
+class MultipartFileBody {
+public:
+    MultipartFileBody(QFile &file, const QString &fileName, const APIClient::ProgressCallback &progress)
+        : m_file(file), m_fileSize(file.size()), m_mapped(mapForStreaming(file)), m_progress(progress)
+    {
+        if (!m_mapped) {
+            m_buffer.resize(kUploadChunkSize);
+        }
+        m_boundary = "LocalDriveBoundary" + QUuid::createUuid().toString(QUuid::Id128).toStdString();
+
+        // Quotes would terminate the filename parameter early.
+        std::string safeName = fileName.toStdString();
+        std::string::size_type pos = 0;
+        while ((pos = safeName.find('"', pos)) != std::string::npos) {
+            safeName.replace(pos, 1, "%22");
+        }
+
+        m_head = "--" + m_boundary + "\r\n"
+                 "Content-Disposition: form-data; name=\"file\"; filename=\"" + safeName + "\"\r\n"
+                 "Content-Type: application/octet-stream\r\n\r\n";
+        m_tail = "\r\n--" + m_boundary + "--\r\n";
+    }
+
+    std::string contentType() const { return "multipart/form-data; boundary=" + m_boundary; }
+
+    size_t contentLength() const {
+        return m_head.size() + static_cast<size_t>(m_fileSize) + m_tail.size();
+    }
+
+    /**
+     * @brief Writes the next piece of the body starting at @p offset into @p sink.
+     * @return false if the file could not be read or the connection was closed.
+     */
+    bool provide(size_t offset, httplib::DataSink &sink) {
+        if (offset < m_head.size()) {
+            return sink.write(m_head.data() + offset, m_head.size() - offset);
+        }
+
+        qint64 fileOffset = static_cast<qint64>(offset - m_head.size());
+        if (fileOffset < m_fileSize && m_mapped) {
+            qint64 length = std::min<qint64>(kMappedChunkSize, m_fileSize - fileOffset);
+            if (!sink.write(reinterpret_cast<const char *>(m_mapped + fileOffset), static_cast<size_t>(length))) {
+                return false;
+            }
+            return !m_progress || m_progress(fileOffset + length, m_fileSize);
+        }
+        if (fileOffset < m_fileSize) {
+            if (m_file.pos() != fileOffset && !m_file.seek(fileOffset)) {
+                return false;
+            }
+            qint64 toRead = std::min<qint64>(kUploadChunkSize, m_fileSize - fileOffset);
+            qint64 bytesRead = m_file.read(m_buffer.data(), toRead);
+            if (bytesRead <= 0 || !sink.write(m_buffer.data(), static_cast<size_t>(bytesRead))) {
+                return false;
+            }
+            return !m_progress || m_progress(fileOffset + bytesRead, m_fileSize);
+        }
+
+        size_t tailOffset = static_cast<size_t>(fileOffset - m_fileSize);
+        return sink.write(m_tail.data() + tailOffset, m_tail.size() - tailOffset);
+    }
+
+private:
+    QFile &m_file;
+    qint64 m_fileSize;
+    const uchar *m_mapped;      ///< Whole-file mapping, or nullptr for buffered reads
+    std::vector<char> m_buffer; ///< Read buffer used when the file is not mapped
+    APIClient::ProgressCallback m_progress;
+    std::string m_boundary;
+    std::string m_head;
+    std::string m_tail;
+};
+
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+std::mutex s_gzipBodiesMutex;
+std::map<std::string, bool> s_gzipBodies; ///< Per server: whether it decodes gzip request bodies
+
+/**
+ * @brief Returns true if the server at @p host has said it decodes gzip request bodies.
+ *
+ * Servers list the codings they accept for request bodies in an Accept-Encoding
+ * response header (RFC 7694). The first upload to a server asks for it with an
+ * OPTIONS probe and the answer is kept for the rest of the process; a server
+ * that does not advertise gzip gets uncompressed bodies.
+ */
+bool acceptsGzipBodies(httplib::Client &cli, const std::string &host) {
+    {
+        std::lock_guard<std::mutex> lock(s_gzipBodiesMutex);
+        auto known = s_gzipBodies.find(host);
+        if (known != s_gzipBodies.end()) {
+            return known->second;
+        }
+    }
+    auto res = cli.Options("/api/upload");
+    if (!res) {
+        return false;  // Unreachable for now; ask again next time.
+    }
+    bool accepted = false;
+    // e.g. "gzip, br;q=0.5"
+    for (const QString &coding : QString::fromStdString(res->get_header_value("Accept-Encoding")).split(',')) {
+        accepted = accepted || coding.trimmed().startsWith("gzip", Qt::CaseInsensitive);
+    }
+    std::lock_guard<std::mutex> lock(s_gzipBodiesMutex);
+    s_gzipBodies[host] = accepted;
+    return accepted;
+}
+
+/**
+ * @brief Records that @p host refused a gzip body, so later uploads go out as-is.
+ */
+void rejectGzipBodies(const std::string &host) {
+    std::lock_guard<std::mutex> lock(s_gzipBodiesMutex);
+    s_gzipBodies[host] = false;
+}
+#endif
+
+} // namespace
+
 /**
  * @brief Uploads a file to the API server.
+ *
+ * The file is streamed from disk in fixed-size chunks rather than loaded into
+ * memory, so large uploads use a constant amount of RAM. A compressible file is
+ * gzip-encoded only for servers that advertise support, and is sent again
+ * uncompressed if the server still refuses the encoded body.
+ */
+bool APIClient::uploadFile(const QString &filePath, const ProgressCallback &progress, const QString &remoteName) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    auto interactive = markInteractive();
+    QFileInfo fileInfo(filePath);
+    MultipartFileBody body(file, remoteName.isEmpty() ? fileInfo.fileName() : remoteName,
+                           throttled(Direction::Upload, progress));
+    const qint64 cpuStart = CompressionPolicy::threadCpuMicros();
+    m_lastCompression = CompressionReport();
+    m_lastCompression.rawBytes = static_cast<qint64>(body.contentLength());
+    m_lastCompression.wireBytes = m_lastCompression.rawBytes;
+
+    const std::string host = m_serverUrl.toStdString();
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(host);
+    httplib::Client &cli = lease.client();
+    httplib::Result res;
+    httplib::Headers headers = idempotencyHeaders();
+    bool compress = false;
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+    compress = CompressionPolicy::shouldCompressFile(filePath) && acceptsGzipBodies(cli, host);
+    if (compress) {
+        // The compressed length is unknown up front, so the body goes out chunked.
+        m_lastCompression.compressed = true;
+        const size_t rawLength = body.contentLength();
+        httplib::Headers gzipHeaders = headers;
+        gzipHeaders.emplace("Content-Encoding", "gzip");
+        res = retried(RetryPolicy::Operation::Transfer, lease, "/api/upload", 0, [&]() {
+            // Every attempt starts a fresh gzip stream from the top of the body.
+            m_lastCompression.wireBytes = 0;
+            httplib::detail::gzip_compressor compressor;
+            size_t rawOffset = 0;
+            return cli.Post("/api/upload", gzipHeaders,
+                           [&](size_t /*offset*/, httplib::DataSink &sink) {
+                               httplib::DataSink raw;
+                               raw.is_writable = sink.is_writable;
+                               raw.write = [&](const char *data, size_t length) {
+                                   rawOffset += length;
+                                   return compressor.compress(data, length, rawOffset == rawLength,
+                                       [&](const char *packed, size_t packedLength) {
+                                           m_lastCompression.wireBytes += static_cast<qint64>(packedLength);
+                                           return sink.write(packed, packedLength);
+                                       });
+                               };
+                               if (!body.provide(rawOffset, raw)) {
+                                   return false;
+                               }
+                               if (rawOffset == rawLength) {
+                                   sink.done();
+                               }
+                               return true;
+                           },
+                           body.contentType());
+        });
+        APIMetrics::instance().endpoint("/api/upload").bytesOut.fetch_add(m_lastCompression.wireBytes,
+                                                                          std::memory_order_relaxed);
+        // The server could not decode the body after all. It applied nothing, so the
+        // body goes out once more as-is as a new operation with a key of its own.
+        if (res && (res->status == 400 || res->status == 411 || res->status == 415)) {
+            rejectGzipBodies(host);
+            headers = idempotencyHeaders();
+            compress = false;
+            m_lastCompression.compressed = false;
+            m_lastCompression.wireBytes += static_cast<qint64>(body.contentLength());
+        }
+    }
+#endif
+    if (!compress) {
+        res = retried(RetryPolicy::Operation::Transfer, lease, "/api/upload", static_cast<qint64>(body.contentLength()), [&]() {
+            return cli.Post("/api/upload", headers, body.contentLength(),
+                            [&body](size_t offset, size_t /*length*/, httplib::DataSink &sink) {
+                                return body.provide(offset, sink);
+                            },
+                            body.contentType());
+        });
+    }
+    m_lastCompression.cpuMicros = CompressionPolicy::threadCpuMicros() - cpuStart;
+    file.close();
+    return (res && res->status == 200);
+}
+
+namespace {
+
+/// Size of each chunk sent in a resumable upload session.
+constexpr qint64 kSessionChunkSize = 4 * 1024 * 1024;
+
+/**
+ * @brief Returns the QSettings group that remembers the upload session for a local file.
+ */
+QString sessionSettingsGroup(const QFileInfo &fileInfo) {
+    QByteArray key = QCryptographicHash::hash(fileInfo.absoluteFilePath().toUtf8(),
+                                              QCryptographicHash::Md5).toHex();
+    return "uploadSessions/" + QString::fromLatin1(key);
+}
+
+/**
+ * @brief Reads the acknowledged offset from a session JSON response.
+ * @return The offset, or -1 if the body could not be parsed.
+ */
+qint64 sessionOffset(const std::string &body) {
+    try {
+        return nlohmann::json::parse(body).value("offset", qint64(-1));
+    } catch (...) {
+        return -1;
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Uploads a file through a resumable chunked upload session.
+ *
+ * Opens (or resumes) a session, PUTs fixed-size chunks tagged with their byte
+ * offset, and commits once the server has acknowledged every byte. The session
+ * id is remembered in QSettings, so a later call after a failure continues from
+ * the last acknowledged chunk instead of starting over.
  */
-bool APIClient::uploadFile(const QString &filePath) {
+bool APIClient::uploadFileChunked(const QString &filePath, const ProgressCallback &progress) {
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly)) {
         return false;
     }
-    QByteArray fileData = file.readAll();
-    file.close();
 
-    QFileInfo fileInfo(filePath);
-    QString fileName = fileInfo.fileName();
+    QFileInfo fileInfo(filePath);
+    const qint64 fileSize = file.size();
+    const qint64 lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(m_serverUrl.toStdString());
+    httplib::Client &cli = lease.client();
+    QSettings settings("YourCompany", "LocalDrive");
+    settings.beginGroup(sessionSettingsGroup(fileInfo));
+
+    // Resume a previous session only if the local file is unchanged.
+    std::string sessionId;
+    qint64 offset = -1;
+    if (settings.value("size").toLongLong() == fileSize &&
+        settings.value("modified").toLongLong() == lastModified) {
+        sessionId = settings.value("id").toString().toStdString();
+    }
+    if (!sessionId.empty()) {
+        auto res = retried(RetryPolicy::Operation::Metadata, lease, "/api/upload/session/{id}", 0, [&]() {
+            return cli.Get("/api/upload/session/" + sessionId);
+        });
+        if (res && res->status == 200) {
+            offset = sessionOffset(res->body);
+        }
+    }
+
+    if (offset < 0) {
+        nlohmann::json request = {
+            { "name", fileInfo.fileName().toStdString() },
+            { "size", fileSize }
+        };
+        const std::string body = request.dump();
+        const httplib::Headers headers = idempotencyHeaders();
+        auto res = retried(RetryPolicy::Operation::Metadata, lease, "/api/upload/session", static_cast<qint64>(body.size()),
+                           [&]() { return cli.Post("/api/upload/session", headers, body, "application/json"); });
+        if (!res || res->status != 200) {
+            settings.endGroup();
+            // Servers without session support still accept a plain upload.
+            if (res && (res->status == 404 || res->status == 405)) {
+                file.close();
+                return uploadFile(filePath, progress);
+            }
+            return false;
+        }
+        try {
+            auto jsonData = nlohmann::json::parse(res->body);
+            sessionId = jsonData.at("id").get<std::string>();
+            offset = jsonData.value("offset", qint64(0));
+        } catch (...) {
+            settings.endGroup();
+            return false;
+        }
+        settings.setValue("id", QString::fromStdString(sessionId));
+        settings.setValue("size", fileSize);
+        settings.setValue("modified", lastModified);
+    }
+
+    auto interactive = markInteractive();
+    const std::string sessionPath = "/api/upload/session/" + sessionId;
+    const uchar *mapped = mapForStreaming(file);
+    std::vector<char> buffer(mapped ? 0 : static_cast<size_t>(kSessionChunkSize));
+    const RetryPolicy policy = RetryPolicy::forOperation(RetryPolicy::Operation::Transfer);
+    std::chrono::milliseconds waited(0);
+    int failures = 0;
+
+    while (offset < fileSize) {
+        if (progress && !progress(offset, fileSize)) {
+            settings.endGroup();
+            return false;
+        }
+
+        qint64 length = std::min(kSessionChunkSize, fileSize - offset);
+        const char *chunk = mapped ? reinterpret_cast<const char *>(mapped + offset) : buffer.data();
+        if (!mapped && (!file.seek(offset) || file.read(buffer.data(), length) != length)) {
+            settings.endGroup();
+            return false;
+        }
+
+        // A content provider lets httplib write the chunk as-is instead of copying it into the request.
+        std::string chunkPath = sessionPath + "?offset=" + std::to_string(offset);
+        auto res = timed(lease, "/api/upload/session/{id}?offset", length, [&]() {
+            return cli.Put(chunkPath, static_cast<size_t>(length),
+                           [chunk](size_t chunkOffset, size_t chunkLength, httplib::DataSink &sink) {
+                               return sink.write(chunk + chunkOffset, chunkLength);
+                           },
+                           "application/octet-stream");
+        });
+        if (res && res->status == 200) {
+            // Charged per chunk sent, so a resumed session pays only for what goes out now.
+            throttle(Direction::Upload, length);
+            qint64 acknowledged = sessionOffset(res->body);
+            offset = (acknowledged >= 0) ? acknowledged : offset + length;
+            failures = 0;
+            continue;
+        }
+
+        // A chunk PUT names its offset, so repeating it is harmless; only a cancel is final.
+        std::chrono::milliseconds delay = policy.delayFor(++failures);
+        if ((!res && res.error() == httplib::Error::Canceled) || !policy.allows(failures, waited, delay)) {
+            settings.endGroup();
+            return false;
+        }
+        APIMetrics::instance().recordRetry("/api/upload/session/{id}?offset");
+        std::this_thread::sleep_for(delay);
+        waited += delay;
+        // Ask the server what it actually has before sending anything else.
+        auto status = timed(lease, "/api/upload/session/{id}", 0, [&]() { return cli.Get(sessionPath); });
+        if (status && status->status == 200) {
+            qint64 acknowledged = sessionOffset(status->body);
+            if (acknowledged >= 0) {
+                offset = acknowledged;
+            }
+        }
+    }
+    file.close();
+
+    if (progress) {
+        progress(fileSize, fileSize);
+    }
+
+    const httplib::Headers commitHeaders = idempotencyHeaders();
+    auto res = retried(RetryPolicy::Operation::Metadata, lease, "/api/upload/session/{id}/commit", 0, [&]() {
+        return cli.Post(sessionPath + "/commit", commitHeaders, std::string(), std::string());
+    });
+    bool committed = (res && res->status == 200);
+    if (committed) {
+        settings.remove("");
+    }
+    settings.endGroup();
+    return committed;
+}
+
+/**
+ * @brief Uploads a file as content-defined chunks, skipping those the server already has.
+ *
+ * Protocol:
+ *   POST /api/dedup/missing {"hashes":[...]}             -> {"missing":[...]}
+ *   PUT  /api/dedup/chunk/<sha256>  (raw chunk bytes)
+ *   POST /api/dedup/commit {"name","size","chunks":[...]}
+ * The commit lists every chunk hash in file order, including repeats, so the
+ * server can assemble the file from its chunk store.
+ */
+bool APIClient::uploadFileDeduplicated(const QString &filePath, const ProgressCallback &progress,
+                                       DedupStats *stats) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    ContentChunker chunker;
+    std::vector<ContentChunker::Chunk> chunks;
+    const qint64 fileSize = file.size();
+    // Chunking a large file takes a while; a pause or cancel stops it between chunks.
+    if (!chunker.chunk(file, chunks, [&progress, fileSize](qint64) { return !progress || progress(0, fileSize); })) {
+        return false;
+    }
+    // The commit claims fileSize bytes, so the chunks must cover exactly that.
+    const qint64 chunked = chunks.empty() ? 0 : chunks.back().offset + chunks.back().length;
+    if (chunked != fileSize) {
+        return false;
+    }
+
+    nlohmann::json hashes = nlohmann::json::array();
+    std::set<std::string> seen;
+    for (const auto &chunk : chunks) {
+        if (seen.insert(chunk.hash.toStdString()).second) {
+            hashes.push_back(chunk.hash.toStdString());
+        }
+    }
+
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(m_serverUrl.toStdString());
+    httplib::Client &cli = lease.client();
+
+    nlohmann::json query = { { "hashes", hashes } };
+    const std::string queryBody = query.dump();
+    auto res = retried(RetryPolicy::Operation::Metadata, lease, "/api/dedup/missing", static_cast<qint64>(queryBody.size()), [&]() {
+        return cli.Post("/api/dedup/missing", queryBody, "application/json");
+    });
+    if (!res || res->status != 200) {
+        // Servers without a chunk store still take a session upload.
+        if (res && (res->status == 404 || res->status == 405)) {
+            file.close();
+            return uploadFileChunked(filePath, progress);
+        }
+        return false;
+    }
+
+    std::set<std::string> missing;
+    try {
+        for (const auto &hash : nlohmann::json::parse(res->body).at("missing")) {
+            missing.insert(hash.get<std::string>());
+        }
+    } catch (...) {
+        return false;
+    }
+
+    DedupStats result;
+    result.totalBytes = fileSize;
+    result.totalChunks = static_cast<int>(chunks.size());
+
+    // Bytes the server already holds count as progress straight away.
+    qint64 covered = 0;
+    for (const auto &chunk : chunks) {
+        if (!missing.count(chunk.hash.toStdString())) {
+            covered += chunk.length;
+        }
+    }
+
+    auto interactive = markInteractive();
+    std::vector<char> buffer(chunker.maxSize());
+    for (const auto &chunk : chunks) {
+        std::string hash = chunk.hash.toStdString();
+        // A chunk repeated within the file is only sent the first time.
+        if (!missing.erase(hash)) {
+            continue;
+        }
+        if (progress && !progress(covered, fileSize)) {
+            return false;
+        }
+        if (!file.seek(chunk.offset) || file.read(buffer.data(), chunk.length) != chunk.length) {
+            return false;
+        }
+
+        // Chunks are addressed by their hash, so a repeated PUT stores nothing twice.
+        auto put = retried(RetryPolicy::Operation::Transfer, lease, "/api/dedup/chunk/{hash}", chunk.length, [&]() {
+            return cli.Put("/api/dedup/chunk/" + hash, buffer.data(),
+                           static_cast<size_t>(chunk.length), "application/octet-stream");
+        });
+        if (!put || put->status != 200) {
+            return false;
+        }
+        // Only chunks that were sent are charged; those the server had cost nothing.
+        throttle(Direction::Upload, chunk.length);
+        covered += chunk.length;
+        result.sentBytes += chunk.length;
+        result.sentChunks++;
+    }
+    file.close();
+
+    if (progress) {
+        progress(fileSize, fileSize);
+    }
+
+    nlohmann::json order = nlohmann::json::array();
+    for (const auto &chunk : chunks) {
+        order.push_back(chunk.hash.toStdString());
+    }
+    nlohmann::json commit = {
+        { "name", QFileInfo(filePath).fileName().toStdString() },
+        { "size", fileSize },
+        { "chunks", order }
+    };
+    const std::string commitBody = commit.dump();
+    const httplib::Headers commitHeaders = idempotencyHeaders();
+    res = retried(RetryPolicy::Operation::Metadata, lease, "/api/dedup/commit", static_cast<qint64>(commitBody.size()), [&]() {
+        return cli.Post("/api/dedup/commit", commitHeaders, commitBody, "application/json");
+    });
+    if (stats) {
+        *stats = result;
+    }
+    return (res && res->status == 200);
+}
+
+/**
+ * @brief Streams the files as one tar archive to /api/upload/archive.
+ *
+ * The server replies with {"results": [{"ok": bool, "error": str}, ...]}, one
+ * entry per archive member in archive order. Files that could not be added
+ * (missing or not regular files) are reported as failed without being sent.
+ */
+std::vector<APIClient::BatchResult> APIClient::uploadArchive(const std::vector<std::pair<QString, QString>> &files,
+                                                             const ProgressCallback &progress) {
+    std::vector<BatchResult> results(files.size());
+    std::vector<size_t> members; // Index into files of each archive member
+    TarStream archive;
+    for (size_t i = 0; i < files.size(); ++i) {
+        results[i] = { files[i].second, false, QString() };
+        if (archive.addFile(files[i].first, files[i].second)) {
+            members.push_back(i);
+        } else {
+            results[i].error = "Not a readable file";
+        }
+    }
+    if (members.empty()) {
+        return results;
+    }
+
+    auto interactive = markInteractive();
+    archive.setProgress(throttled(Direction::Upload, progress));
+
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(m_serverUrl.toStdString());
+    httplib::Client &cli = lease.client();
+    const httplib::Headers headers = idempotencyHeaders();
+    auto res = retried(RetryPolicy::Operation::Transfer, lease, "/api/upload/archive", archive.contentLength(), [&]() {
+        return cli.Post("/api/upload/archive", headers, static_cast<size_t>(archive.contentLength()),
+                        [&archive](size_t offset, size_t /*length*/, httplib::DataSink &sink) {
+                            return archive.provide(static_cast<qint64>(offset), sink);
+                        },
+                        "application/x-tar");
+    });
+
+    if (res && (res->status == 404 || res->status == 405)) {
+        // No archive support: send the members one by one, keeping their paths.
+        for (size_t i : members) {
+            results[i].success = uploadFile(files[i].first, progress, files[i].second);
+        }
+        return results;
+    }
+
+    bool parsed = false;
+    if (res && res->status == 200) {
+        try {
+            auto replies = nlohmann::json::parse(res->body).at("results");
+            if (replies.size() == members.size()) {
+                for (size_t m = 0; m < members.size(); ++m) {
+                    BatchResult &result = results[members[m]];
+                    result.success = replies[m].value("ok", false);
+                    result.error = QString::fromStdString(replies[m].value("error", ""));
+                }
+                parsed = true;
+            }
+        } catch (...) {
+            // Reported below as a failed request.
+        }
+    }
+    if (!parsed) {
+        for (size_t i : members) {
+            results[i].error = "Archive upload failed";
+        }
+    }
+    // A member that changed while it was streamed went out zero-padded; never report it as stored.
+    for (size_t m : archive.unreadable()) {
+        results[members[m]].success = false;
+        results[members[m]].error = "File changed while uploading";
+    }
+    return results;
+}
+
+namespace {
+
+/// Block size of the delta stream buffer sent to the server.
+constexpr qint64 kDeltaSendChunk = 256 * 1024;
+
+/**
+ * @brief Parses a signature response: {"blockSize","etag","blocks":[[weak,"md5hex"],...]}.
+ * @return false if the body is malformed.
+ */
+bool parseSignature(const std::string &body, size_t &blockSize, std::string &etag,
+                    std::vector<DeltaEncoder::Block> &blocks) {
+    try {
+        auto jsonData = nlohmann::json::parse(body);
+        blockSize = jsonData.at("blockSize").get<size_t>();
+        etag = jsonData.value("etag", std::string());
+        const auto &entries = jsonData.at("blocks");
+        blocks.reserve(entries.size());
+        for (const auto &entry : entries) {
+            QByteArray strong = QByteArray::fromHex(QByteArray::fromStdString(entry.at(1).get<std::string>()));
+            blocks.push_back({ entry.at(0).get<uint32_t>(), strong });
+        }
+    } catch (...) {
+        return false;
+    }
+    return blockSize > 0;
+}
+
+} // namespace
+
+/**
+ * @brief Uploads the difference between the local file and the server's copy.
+ *
+ * Protocol:
+ *   GET  /api/delta/signature/<name>?block=N  -> {"blockSize","etag","blocks":[[weak,"md5"],...]}
+ *   POST /api/delta/apply/<name>  (If-Match: etag, body: DeltaEncoder stream)
+ * The delta is written to a temporary file first so its length is known and the
+ * new file is never held in memory.
+ */
+bool APIClient::uploadFileDelta(const QString &filePath, const ProgressCallback &progress, DeltaStats *stats) {
+    QElapsedTimer timer;
+    timer.start();
+    DeltaStats result;
+
+    // alreadyReported is the progress a rejected delta already reached; the
+    // re-send counts on from there so progress never runs backwards.
+    auto fullUpload = [&](qint64 alreadyReported) {
+        m_lastCompression = CompressionReport();
+        ProgressCallback resend = progress;
+        if (progress && alreadyReported > 0) {
+            resend = [&progress, alreadyReported](qint64 sent, qint64 total) {
+                return progress(alreadyReported + sent, alreadyReported + total);
+            };
+        }
+        bool success = uploadFile(filePath, resend);
+        // The request body as sent: multipart framing, gzip-encoded when compressible.
+        result.wireBytes += m_lastCompression.wireBytes;
+        result.literalBytes = result.fileSize;
+        result.elapsedMs = timer.elapsed();
+        if (stats) {
+            *stats = result;
+        }
+        return success;
+    };
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    result.fileSize = file.size();
+
+    const std::string encodedName = QString(QUrl::toPercentEncoding(QFileInfo(filePath).fileName())).toStdString();
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(m_serverUrl.toStdString());
+    httplib::Client &cli = lease.client();
+
+    std::string signaturePath = "/api/delta/signature/" + encodedName + "?block=" +
+                                std::to_string(DeltaEncoder::blockSizeForFile(result.fileSize));
+    auto res = retried(RetryPolicy::Operation::Metadata, lease, "/api/delta/signature/{name}", 0,
+                       [&]() { return cli.Get(signaturePath); });
+    if (!res || res->status != 200) {
+        // No server copy to diff against, or no delta support.
+        if (res && (res->status == 404 || res->status == 405)) {
+            file.close();
+            return fullUpload(0);
+        }
+        return false;
+    }
+    result.wireBytes += static_cast<qint64>(res->body.size());
+
+    size_t blockSize = 0;
+    std::string etag;
+    std::vector<DeltaEncoder::Block> blocks;
+    if (!parseSignature(res->body, blockSize, etag, blocks)) {
+        return false;
+    }
 
-    std::string stdFileData = fileData.toStdString();
-    std::string stdFileName = fileName.toStdString();
+    // Mapping lets the rolling checksum look back and ahead without buffer juggling.
+    const uchar *data = result.fileSize > 0 ? file.map(0, result.fileSize) : nullptr;
+    if (result.fileSize > 0 && !data) {
+        file.close();
+        return fullUpload(0);
+    }
 
-    httplib::Client cli(m_serverUrl.toStdString().c_str());
-    httplib::MultipartFormDataItems items = {
-        { "file", stdFileData, stdFileName, "application/octet-stream" }
+    QTemporaryFile delta;
+    if (!delta.open()) {
+        return false;
+    }
+    DeltaEncoder encoder(blockSize, std::move(blocks));
+    DeltaEncoder::Stats encodeStats;
+    // Encoding covers the first half of the reported progress, sending the second.
+    auto encodeProgress = [&](qint64 scanned, qint64 total) {
+        return !progress || progress(scanned / 2, total);
     };
+    if (!encoder.encode(data, result.fileSize, delta, encodeProgress, &encodeStats) || !delta.flush()) {
+        return false;
+    }
+    file.close();
+
+    auto interactive = markInteractive();
+    const qint64 deltaSize = encodeStats.deltaBytes;
+    std::vector<char> buffer(static_cast<size_t>(kDeltaSendChunk));
+    httplib::Headers headers = idempotencyHeaders();
+    if (!etag.empty()) {
+        headers.emplace("If-Match", etag);
+    }
+    res = retried(RetryPolicy::Operation::Transfer, lease, "/api/delta/apply/{name}", deltaSize, [&]() {
+        return cli.Post("/api/delta/apply/" + encodedName, headers, static_cast<size_t>(deltaSize),
+                       [&](size_t offset, size_t length, httplib::DataSink &sink) {
+                           if (!delta.seek(static_cast<qint64>(offset))) {
+                               return false;
+                           }
+                           qint64 toRead = std::min<qint64>(kDeltaSendChunk, static_cast<qint64>(length));
+                           qint64 bytesRead = delta.read(buffer.data(), toRead);
+                           if (bytesRead <= 0 || !sink.write(buffer.data(), static_cast<size_t>(bytesRead))) {
+                               return false;
+                           }
+                           throttle(Direction::Upload, bytesRead);
+                           qint64 sent = static_cast<qint64>(offset) + bytesRead;
+                           return !progress || deltaSize == 0 ||
+                                  progress(result.fileSize / 2 + sent * (result.fileSize - result.fileSize / 2) / deltaSize,
+                                           result.fileSize);
+                       },
+                       "application/x-localdrive-delta");
+    });
+
+    // The delta went out whether or not the server took it.
+    result.wireBytes += deltaSize;
+
+    // The server copy changed after the signature was taken; the delta is stale.
+    // The full re-send adds to the bytes and progress of the rejected attempt.
+    if (res && res->status == 412) {
+        return fullUpload(result.fileSize);
+    }
 
-    auto res = cli.Post("/api/upload", items);
+    result.usedDelta = true;
+    result.literalBytes = encodeStats.literalBytes;
+    result.elapsedMs = timer.elapsed();
+    if (stats) {
+        *stats = result;
+    }
     return (res && res->status == 200);
 }
 
+/**
+ * @brief Sends a have-hash preflight; the server answers {"linked": true} when it reused content.
+ *
+ * A 404 means either the server has no such content or no such endpoint; both
+ * simply mean the caller has to upload.
+ */
+bool APIClient::linkExistingContent(const QString &filePath, const QByteArray &contentHash) {
+    QFileInfo fileInfo(filePath);
+    nlohmann::json request = {
+        { "name", fileInfo.fileName().toStdString() },
+        { "size", fileInfo.size() },
+        { "algorithm", "xxh64" },
+        { "hash", contentHash.toStdString() }
+    };
+
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(m_serverUrl.toStdString());
+    httplib::Client &cli = lease.client();
+    const std::string body = request.dump();
+    const httplib::Headers headers = idempotencyHeaders();
+    auto res = retried(RetryPolicy::Operation::Metadata, lease, "/api/have", static_cast<qint64>(body.size()), [&]() {
+        return cli.Post("/api/have", headers, body, "application/json");
+    });
+    if (!res || res->status != 200) {
+        return false;
+    }
+    try {
+        return nlohmann::json::parse(res->body).value("linked", false);
+    } catch (...) {
+        return false;
+    }
+}
+
+namespace {
+
+/// Names requested per listing page.
+constexpr int kListingPageSize = 5000;
+
+/// Names parsed before they are handed to the caller.
+constexpr size_t kListingBatchSize = 1000;
+
+/// Most received listing bytes held ahead of the parser.
+constexpr size_t kListingBufferBytes = 1024 * 1024;
+
+/**
+ * @brief Stream buffer fed by an HTTP content receiver on another thread.
+ *
+ * push() blocks while the reader is more than kListingBufferBytes behind and
+ * fails once the reader has abandoned the stream; underflow() blocks until
+ * data arrives or the writer calls finish().
+ */
+class ReceiveBuffer : public std::streambuf {
+public:
+    bool push(const char *data, size_t length) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() { return m_abandoned || m_queued < kListingBufferBytes; });
+        if (m_abandoned) {
+            return false;
+        }
+        m_chunks.emplace_back(data, length);
+        m_queued += length;
+        m_cv.notify_all();
+        return true;
+    }
+
+    void finish() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished = true;
+        m_cv.notify_all();
+    }
+
+    void abandon() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_abandoned = true;
+        m_chunks.clear();
+        m_cv.notify_all();
+    }
+
+protected:
+    int_type underflow() override {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() { return m_finished || m_abandoned || !m_chunks.empty(); });
+        if (m_chunks.empty()) {
+            return traits_type::eof();
+        }
+        m_current = std::move(m_chunks.front());
+        m_chunks.pop_front();
+        m_queued -= m_current.size();
+        m_cv.notify_all();
+        setg(&m_current[0], &m_current[0], &m_current[0] + m_current.size());
+        return traits_type::to_int_type(m_current[0]);
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::string> m_chunks;
+    std::string m_current;     ///< Chunk the reader is consuming
+    size_t m_queued = 0;       ///< Bytes in m_chunks
+    bool m_finished = false;
+    bool m_abandoned = false;
+};
+
+/**
+ * @brief Outcome of streaming one listing response through a ListingParser.
+ */
+struct ListingFetch {
+    bool parsed = false;                              ///< Whole body received and parsed
+    bool cbor = false;                                ///< Body was application/cbor rather than JSON
+    int status = 0;                                   ///< HTTP status, or 0 if none arrived
+    std::string etag;                                 ///< ETag response header, if any
+    httplib::Error error = httplib::Error::Success;   ///< Transport error, if any
+};
+
+/**
+ * @brief GETs @p path and feeds the body to @p parser while it is still arriving.
+ *
+ * The request runs on a helper thread that pushes received data into a
+ * ReceiveBuffer; the calling thread parses from it, so entries reach the
+ * parser's callback after the first few kilobytes rather than after the
+ * whole body. CBOR is preferred; the response's Content-Type picks the decoder.
+ * A non-empty @p ifNoneMatch makes the request conditional; a 304 answer
+ * comes back with parsed == false and status == 304.
+ */
+ListingFetch streamListing(const std::string &host, const std::string &path, ListingParser &parser,
+                           const std::string &ifNoneMatch = std::string()) {
+    ReceiveBuffer buffer;
+    ListingFetch fetch;
+    std::thread receiver([&]() {
+        ConnectionPool::Lease lease = ConnectionPool::instance().acquire(host);
+        httplib::Client &cli = lease.client();
+        RequestTimer timer("/api/files");
+        httplib::Headers headers = { { "Accept", "application/cbor, application/json;q=0.5" } };
+        // httplib only asks for compression itself when it buffers the body.
+        headers.emplace("Accept-Encoding", "gzip, deflate");
+        if (!ifNoneMatch.empty()) {
+            headers.emplace("If-None-Match", ifNoneMatch);
+        }
+        auto res = cli.Get(path, headers,
+            [&](const httplib::Response &response) {
+                fetch.status = response.status;
+                fetch.etag = response.get_header_value("ETag");
+                fetch.cbor = response.get_header_value("Content-Type").rfind("application/cbor", 0) == 0;
+                return response.status == 200;
+            },
+            [&](const char *data, size_t length) {
+                timer.addBytesIn(static_cast<qint64>(length));
+                return buffer.push(data, length);
+            });
+        fetch.error = res ? httplib::Error::Success : res.error();
+        if (!res) {
+            lease.discard();  // A cut-off body leaves the connection unusable.
+        }
+        timer.finish(res ? res->status : fetch.status);
+        buffer.finish();
+    });
+
+    // Block until the headers and first bytes are in, so the format is known.
+    buffer.sgetc();
+    std::istream in(&buffer);
+    const auto format = fetch.cbor ? nlohmann::json::input_format_t::cbor : nlohmann::json::input_format_t::json;
+    bool parsed = nlohmann::json::sax_parse(in, &parser, format) && parser.flush();
+    buffer.abandon();
+    receiver.join();
+    fetch.parsed = parsed && fetch.status == 200 && fetch.error == httplib::Error::Success;
+    return fetch;
+}
+
+} // namespace
+
 /**
  * @brief Retrieves the list of files stored on the API server.
  */
 std::vector<QString> APIClient::listFiles() {
     std::vector<QString> result;
-    httplib::Client cli(m_serverUrl.toStdString().c_str());
-    auto res = cli.Get("/api/files");
-    if (res && res->status == 200) {
+    listFilesPaged([&result](std::vector<RemoteFile> &files) {
+        for (const RemoteFile &file : files) {
+            result.push_back(file.name);
+        }
+        return true;
+    });
+    return result;
+}
+
+/**
+ * @brief Walks the listing page by page, handing entries over as they are parsed.
+ *
+ * A page that fails before any of its entries were delivered is retried under
+ * the metadata RetryPolicy; a failure part-way through a page is reported, as
+ * retrying it would deliver entries twice.
+ *
+ * The last complete listing is kept in a ListingCache. The first page is
+ * requested with the cached ETag as If-None-Match; the server derives its
+ * ETag from the state of the whole listing, so a 304 means the cached copy
+ * is current and it is replayed instead of downloading every page again.
+ */
+bool APIClient::listFilesPaged(const ListingCallback &onBatch, int pageSize, qint64 *sequence) {
+    RateLimiter::InteractiveScope interactive;
+    const std::string host = m_serverUrl.toStdString();
+    const RetryPolicy policy = RetryPolicy::forOperation(RetryPolicy::Operation::Metadata);
+    if (pageSize <= 0) {
+        pageSize = kListingPageSize;
+    }
+    if (sequence) {
+        *sequence = -1;
+    }
+
+    ListingCache cache(m_serverUrl);
+    const std::string cachedEtag = cache.etag();
+    bool caching = cache.beginWrite();
+    // Entries are copied into the new cache before the callback may move them.
+    const ListingCallback forward = [&](std::vector<RemoteFile> &files) {
+        if (caching) {
+            cache.append(files);
+        }
+        return onBatch(files);
+    };
+
+    std::string cursor;
+    std::string etag;
+    qint64 firstSequence = -1;
+    bool firstPage = true;
+    do {
+        std::string path = "/api/files?limit=" + std::to_string(pageSize);
+        if (!cursor.empty()) {
+            path += "&cursor=" + QUrl::toPercentEncoding(QString::fromStdString(cursor)).toStdString();
+        }
+
+        const std::string ifNoneMatch = firstPage ? cachedEtag : std::string();
+        ListingParser parser(forward, kListingBatchSize);
+        ListingFetch fetch = streamListing(host, path, parser, ifNoneMatch);
+        std::chrono::milliseconds waited(0);
+        for (int attempt = 1; !fetch.parsed && parser.count() == 0; ++attempt) {
+            bool transient = fetch.status != 0 ? RetryPolicy::isTransientStatus(fetch.status)
+                                               : isTransientError(fetch.error);
+            std::chrono::milliseconds delay = policy.delayFor(attempt);
+            if (!transient || !policy.allows(attempt, waited, delay)) {
+                break;
+            }
+            APIMetrics::instance().recordRetry("/api/files");
+            std::this_thread::sleep_for(delay);
+            waited += delay;
+            parser = ListingParser(forward, kListingBatchSize);
+            fetch = streamListing(host, path, parser, ifNoneMatch);
+        }
+        if (firstPage && fetch.status == 304) {
+            const qint64 cachedSequence = cache.sequence();
+            size_t replayed = 0;
+            bool complete = cache.replay([&](std::vector<RemoteFile> &files) {
+                replayed += files.size();
+                return onBatch(files);
+            });
+            if (complete) {
+                if (sequence) {
+                    *sequence = cachedSequence;
+                }
+                return true;
+            }
+            cache.clear();
+            if (replayed != 0) {
+                return false;
+            }
+            // The cached copy is unreadable; fetch the page again without the condition.
+            caching = cache.beginWrite();
+            parser = ListingParser(forward, kListingBatchSize);
+            fetch = streamListing(host, path, parser);
+        }
+        if (!fetch.parsed) {
+            return false;
+        }
+        // Changes made while later pages load are replayed from the first page's sequence.
+        if (firstPage) {
+            etag = fetch.etag;
+            firstSequence = parser.sequence();
+            if (sequence) {
+                *sequence = firstSequence;
+            }
+        }
+        firstPage = false;
+        // A server without pagination sent everything as one plain array.
+        cursor = parser.paginated() ? parser.nextCursor() : std::string();
+    } while (!cursor.empty());
+
+    // Without an ETag the copy could never be revalidated, so none is kept.
+    if (!caching || etag.empty() || !cache.commit(etag, firstSequence)) {
+        cache.clear();
+    }
+    return true;
+}
+
+namespace {
+
+/// Most journal requests made by one fetchChanges() call.
+constexpr int kMaxChangeRequests = 64;
+
+} // namespace
+
+/**
+ * @brief Pulls journal entries after @p since until the server reports no more.
+ */
+APIClient::ChangesResult APIClient::fetchChanges(qint64 since, std::vector<FileChange> &changes, qint64 &latest) {
+    RateLimiter::InteractiveScope interactive;
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(m_serverUrl.toStdString());
+    httplib::Client &cli = lease.client();
+    latest = since;
+
+    for (int request = 0; request < kMaxChangeRequests; ++request) {
+        const std::string path = "/api/changes?since=" + std::to_string(latest);
+        auto res = retried(RetryPolicy::Operation::Metadata, lease, "/api/changes", 0, [&]() { return cli.Get(path); });
+        if (res && (res->status == 404 || res->status == 410)) {
+            return ChangesResult::Expired;
+        }
+        if (!res || res->status != 200) {
+            return ChangesResult::Failed;
+        }
+
+        bool more = false;
         try {
-            auto jsonData = nlohmann::json::parse(res->body);
-            for (const auto &item : jsonData) {
-                std::string fileStr = item.get<std::string>();
-                result.push_back(QString::fromStdString(fileStr));
+            auto reply = nlohmann::json::parse(res->body);
+            qint64 seq = reply.at("seq").get<qint64>();
+            for (const auto &entry : reply.value("changes", nlohmann::json::array())) {
+                FileChange change;
+                if (ListingParser::changeFromJson(entry, change)) {
+                    changes.push_back(std::move(change));
+                }
+            }
+            // A server going backwards has lost its journal.
+            if (seq < latest) {
+                return ChangesResult::Expired;
             }
+            more = reply.value("more", false) && seq > latest;
+            latest = seq;
         } catch (...) {
-            // Parsing failed.
+            return ChangesResult::Failed;
+        }
+        if (!more) {
+            return ChangesResult::Ok;
         }
     }
-    return result;
+    return ChangesResult::Ok;
 }
 
 /**
  * @brief Renames a file on the API server.
  */
 bool APIClient::renameFile(const QString &oldName, const QString &newName) {
-    httplib::Client cli(m_serverUrl.toStdString().c_str());
+    RateLimiter::InteractiveScope interactive;
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(m_serverUrl.toStdString());
+    httplib::Client &cli = lease.client();
     // URL-encode the file names to handle spaces and special characters.
     QString encodedOld = QUrl::toPercentEncoding(oldName);
     QString encodedNew = QUrl::toPercentEncoding(newName);
     std::string body = "old=" + encodedOld.toStdString() + "&new=" + encodedNew.toStdString();
 
-    auto res = cli.Post("/api/rename", body, "application/x-www-form-urlencoded");
+    const httplib::Headers headers = idempotencyHeaders();
+    auto res = retried(RetryPolicy::Operation::Metadata, lease, "/api/rename", static_cast<qint64>(body.size()), [&]() {
+        return cli.Post("/api/rename", headers, body, "application/x-www-form-urlencoded");
+    });
     return (res && res->status == 200);
 }
 
@@ -80,30 +1383,662 @@ bool APIClient::renameFile(const QString &oldName, const QString &newName) {
  * @brief Deletes a file from the API server.
  */
 bool APIClient::deleteFile(const QString &filename) {
-    httplib::Client cli(m_serverUrl.toStdString().c_str());
+    RateLimiter::InteractiveScope interactive;
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(m_serverUrl.toStdString());
+    httplib::Client &cli = lease.client();
     std::string body = "file=" + filename.toStdString();
-    auto res = cli.Post("/api/delete", body, "application/x-www-form-urlencoded");
+    const httplib::Headers headers = idempotencyHeaders();
+    auto res = retried(RetryPolicy::Operation::Metadata, lease, "/api/delete", static_cast<qint64>(body.size()), [&]() {
+        return cli.Post("/api/delete", headers, body, "application/x-www-form-urlencoded");
+    });
     return (res && res->status == 200);
 }
 
+namespace {
+
+/// Maximum number of items sent in one batch request.
+constexpr size_t kBatchSize = 1000;
+
+/**
+ * @brief Sends @p items to a batch endpoint in groups of kBatchSize.
+ *
+ * The server answers each request with {"results": [{"ok": bool, "error": str}, ...]}
+ * in request order. If the server has no batch endpoint, the remaining items are
+ * sent one at a time through @p single instead.
+ */
+template <typename Item, typename ToJson, typename NameOf, typename Single>
+std::vector<APIClient::BatchResult> runBatches(ConnectionPool::Lease &lease, const std::string &endpoint, const char *key,
+                                               const std::vector<Item> &items, ToJson toJson, NameOf nameOf,
+                                               Single single) {
+    httplib::Client &cli = lease.client();
+    std::vector<APIClient::BatchResult> results;
+    results.reserve(items.size());
+    bool batchSupported = true;
+
+    for (size_t start = 0; start < items.size(); start += kBatchSize) {
+        const size_t end = std::min(items.size(), start + kBatchSize);
+
+        if (batchSupported) {
+            nlohmann::json request;
+            request[key] = nlohmann::json::array();
+            for (size_t i = start; i < end; ++i) {
+                request[key].push_back(toJson(items[i]));
+            }
+
+            const std::string body = request.dump();
+            const httplib::Headers headers = idempotencyHeaders();
+            auto res = retried(RetryPolicy::Operation::Batch, lease, endpoint, static_cast<qint64>(body.size()), [&]() {
+                return cli.Post(endpoint, headers, body, "application/json");
+            });
+            if (res && res->status == 200) {
+                try {
+                    auto replies = nlohmann::json::parse(res->body).at("results");
+                    if (replies.size() == end - start) {
+                        for (size_t i = start; i < end; ++i) {
+                            const auto &reply = replies[i - start];
+                            results.push_back({ nameOf(items[i]), reply.value("ok", false),
+                                                QString::fromStdString(reply.value("error", "")) });
+                        }
+                        continue;
+                    }
+                } catch (...) {
+                    // Fall through and report the whole group as failed.
+                }
+            }
+            if (res && (res->status == 404 || res->status == 405)) {
+                batchSupported = false;
+            } else {
+                for (size_t i = start; i < end; ++i) {
+                    results.push_back({ nameOf(items[i]), false, "Batch request failed" });
+                }
+                continue;
+            }
+        }
+
+        for (size_t i = start; i < end; ++i) {
+            results.push_back({ nameOf(items[i]), single(items[i]), QString() });
+        }
+    }
+    return results;
+}
+
+} // namespace
+
+/**
+ * @brief Deletes many files using as few requests as possible.
+ */
+std::vector<APIClient::BatchResult> APIClient::deleteFiles(const std::vector<QString> &filenames) {
+    RateLimiter::InteractiveScope interactive;
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(m_serverUrl.toStdString());
+    return runBatches(lease, "/api/batch/delete", "files", filenames,
+        [](const QString &name) { return nlohmann::json(name.toStdString()); },
+        [](const QString &name) { return name; },
+        [this](const QString &name) { return deleteFile(name); });
+}
+
+/**
+ * @brief Renames many files using as few requests as possible.
+ */
+std::vector<APIClient::BatchResult> APIClient::renameFiles(const std::vector<std::pair<QString, QString>> &renames) {
+    RateLimiter::InteractiveScope interactive;
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(m_serverUrl.toStdString());
+    return runBatches(lease, "/api/batch/rename", "renames", renames,
+        [](const std::pair<QString, QString> &rename) {
+            return nlohmann::json{ { "old", rename.first.toStdString() }, { "new", rename.second.toStdString() } };
+        },
+        [](const std::pair<QString, QString> &rename) { return rename.first; },
+        [this](const std::pair<QString, QString> &rename) { return renameFile(rename.first, rename.second); });
+}
+
+namespace {
+
+/// How many bytes may be received between journal updates.
+constexpr qint64 kJournalInterval = 8 * 1024 * 1024;
+
+/**
+ * @brief Sidecar state for a partially downloaded file.
+ *
+ * Stored next to the ".part" file so an interrupted download can be resumed
+ * with a Range request, even after the application restarts.
+ */
+struct DownloadJournal {
+    std::string file;   ///< Remote file name the partial data belongs to
+    std::string etag;   ///< Validator reported by the server, if any
+    qint64 offset = 0;  ///< Number of bytes safely written to the .part file
+    qint64 size = 0;    ///< Total size of the remote file, or 0 if unknown
+};
+
+bool loadJournal(const QString &path, DownloadJournal &journal) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    try {
+        auto jsonData = nlohmann::json::parse(file.readAll().toStdString());
+        journal.file = jsonData.value("file", "");
+        journal.etag = jsonData.value("etag", "");
+        journal.offset = jsonData.value("offset", qint64(0));
+        journal.size = jsonData.value("size", qint64(0));
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+void saveJournal(const QString &path, const DownloadJournal &journal) {
+    nlohmann::json jsonData = {
+        { "file", journal.file },
+        { "etag", journal.etag },
+        { "offset", journal.offset },
+        { "size", journal.size }
+    };
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(QByteArray::fromStdString(jsonData.dump()));
+    }
+}
+
+/**
+ * @brief Sidecar state for a segmented download: the ranges and how far each got.
+ */
+struct SegmentJournal {
+    /**
+     * @brief One segment's byte range.
+     */
+    struct Range {
+        qint64 first = 0;   ///< First byte of the segment
+        qint64 last = 0;    ///< Last byte of the segment, inclusive
+        qint64 stored = 0;  ///< Next byte to fetch; everything before it is flushed to disk
+    };
+
+    std::string file;   ///< Remote file name the data belongs to
+    std::string etag;   ///< Validator reported by the server, if any
+    qint64 size = 0;    ///< Total size of the remote file
+    std::vector<Range> ranges;
+};
+
+bool loadSegmentJournal(const QString &path, SegmentJournal &journal) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    try {
+        auto jsonData = nlohmann::json::parse(file.readAll().toStdString());
+        journal.file = jsonData.value("file", "");
+        journal.etag = jsonData.value("etag", "");
+        journal.size = jsonData.value("size", qint64(0));
+        journal.ranges.clear();
+        for (const auto &range : jsonData.at("ranges")) {
+            SegmentJournal::Range entry{ range.at(0).get<qint64>(), range.at(1).get<qint64>(),
+                                         range.at(2).get<qint64>() };
+            if (entry.stored < entry.first || entry.stored > entry.last + 1) {
+                return false;
+            }
+            journal.ranges.push_back(entry);
+        }
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+void saveSegmentJournal(const QString &path, const SegmentJournal &journal) {
+    nlohmann::json ranges = nlohmann::json::array();
+    for (const SegmentJournal::Range &range : journal.ranges) {
+        ranges.push_back({ range.first, range.last, range.stored });
+    }
+    nlohmann::json jsonData = {
+        { "file", journal.file },
+        { "etag", journal.etag },
+        { "size", journal.size },
+        { "ranges", ranges }
+    };
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(QByteArray::fromStdString(jsonData.dump()));
+    }
+}
+
+/**
+ * @brief Returns the pool that runs download segments, shared by all segmented downloads.
+ */
+QThreadPool *segmentPool() {
+    static QThreadPool *pool = [] {
+        QThreadPool *threadPool = new QThreadPool();
+        threadPool->setMaxThreadCount(APIClient::kMaxSegments);
+        return threadPool;
+    }();
+    return pool;
+}
+
+/**
+ * @brief Parses a "bytes first-last/total" Content-Range value.
+ * @return The first byte position, or -1 if the value is malformed.
+ */
+qint64 parseContentRange(const std::string &value, qint64 &total) {
+    long long first = -1, last = -1, length = 0;
+    if (std::sscanf(value.c_str(), "bytes %lld-%lld/%lld", &first, &last, &length) < 2) {
+        return -1;
+    }
+    total = length;
+    return first;
+}
+
+} // namespace
+
 /**
  * @brief Downloads a file from the API server.
+ *
+ * The response body is written into "<destination>.part" through a DownloadSink,
+ * which preallocates the file from the announced length and writes behind the
+ * network on its own thread. A sidecar journal records how far the transfer got, so a dropped or
+ * cancelled download resumes with a Range request and only fetches the missing
+ * bytes. The part file is renamed into place once the last byte is written.
  */
-bool APIClient::downloadFile(const QString &filename, const QString &destinationPath) {
-    httplib::Client cli(m_serverUrl.toStdString().c_str());
+bool APIClient::downloadFile(const QString &filename, const QString &destinationPath,
+                             const ProgressCallback &progress) {
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(m_serverUrl.toStdString());
+    httplib::Client &cli = lease.client();
     // URL-encode the filename to safely include it in the URL.
     QString encodedFilename = QUrl::toPercentEncoding(filename);
     std::string endpoint = "/api/download/" + encodedFilename.toStdString();
 
-    auto res = cli.Get(endpoint.c_str());
-    if (res && res->status == 200) {
-        QFile file(destinationPath);
-        if (!file.open(QIODevice::WriteOnly)) {
+    const QString partPath = destinationPath + ".part";
+    const QString journalPath = partPath + ".json";
+
+    auto interactive = markInteractive();
+    const qint64 cpuStart = CompressionPolicy::threadCpuMicros();
+    m_lastCompression = CompressionReport();
+    const bool acceptCompressed = CompressionPolicy::classify(filename) != CompressionPolicy::Decision::Skip;
+
+    DownloadJournal journal;
+    if (!loadJournal(journalPath, journal) || journal.file != filename.toStdString()) {
+        journal = DownloadJournal();
+        journal.file = filename.toStdString();
+    }
+
+    DownloadSink sink(partPath);
+    if (!sink.open()) {
+        return false;
+    }
+
+    // Only trust bytes that are both on disk and acknowledged by the journal.
+    qint64 offset = std::min(sink.size(), journal.offset);
+    if (!sink.reset(offset)) {
+        return false;
+    }
+    const ProgressCallback paced = throttled(Direction::Download, progress, offset);
+
+    const RetryPolicy policy = RetryPolicy::forOperation(RetryPolicy::Operation::Transfer);
+    std::chrono::milliseconds waited(0);
+    bool complete = false;
+    for (int attempt = 0; attempt < policy.maxAttempts() && !complete; ++attempt) {
+        if (attempt > 0) {
+            std::chrono::milliseconds delay = policy.delayFor(attempt);
+            if (!policy.allows(attempt, waited, delay)) {
+                break;
+            }
+            APIMetrics::instance().recordRetry("/api/download/{name}");
+            std::this_thread::sleep_for(delay);
+            waited += delay;
+        }
+
+        httplib::Headers headers;
+        if (offset > 0) {
+            headers.insert(httplib::make_range_header({ { offset, -1 } }));
+            if (!journal.etag.empty()) {
+                headers.emplace("If-Range", journal.etag);
+            }
+        } else if (acceptCompressed) {
+            // Ranges address the encoded bytes, so compression is only asked for
+            // on a fresh download; an encoded body restarts rather than resumes.
+            headers.emplace("Accept-Encoding", "gzip, deflate");
+        }
+
+        bool restart = false;
+        bool rangeRejected = false;
+        bool writeFailed = false;
+        bool encoded = false;
+        qint64 journaledAt = offset;
+
+        RequestTimer timer("/api/download/{name}");
+        auto res = cli.Get(endpoint, headers,
+            [&](const httplib::Response &response) {
+                std::string etag = response.get_header_value("ETag");
+                if (response.status == 206) {
+                    qint64 total = 0;
+                    qint64 first = parseContentRange(response.get_header_value("Content-Range"), total);
+                    bool changed = !journal.etag.empty() && !etag.empty() && etag != journal.etag;
+                    if (first != offset || changed) {
+                        restart = true;
+                        return false;
+                    }
+                    journal.size = total;
+                    sink.preallocate(total);
+                } else if (response.status == 200) {
+                    // The server sent the whole file, either because no range was
+                    // requested or because the remote copy changed.
+                    offset = 0;
+                    if (!sink.reset(0)) {
+                        writeFailed = true;
+                        return false;
+                    }
+                    journal.size = static_cast<qint64>(response.get_header_value_u64("Content-Length"));
+                    std::string encoding = response.get_header_value("Content-Encoding");
+                    encoded = !encoding.empty() && encoding != "identity";
+                    m_lastCompression.compressed = encoded;
+                    if (encoded) {
+                        m_lastCompression.wireBytes = journal.size;
+                        journal.size = 0;
+                    } else {
+                        sink.preallocate(journal.size);
+                    }
+                } else {
+                    rangeRejected = (response.status == 416 && offset > 0);
+                    return false;
+                }
+                journal.etag = etag;
+                journal.offset = offset;
+                saveJournal(journalPath, journal);
+                return true;
+            },
+            [&](const char *data, size_t length) {
+                if (!sink.write(data, length)) {
+                    writeFailed = true;
+                    return false;
+                }
+                timer.addBytesIn(static_cast<qint64>(length));
+                offset += static_cast<qint64>(length);
+                // Journal what the writer thread has already stored, not what is still buffered.
+                qint64 stored = sink.written();
+                if (!encoded && stored - journaledAt >= kJournalInterval) {
+                    journal.offset = stored;
+                    saveJournal(journalPath, journal);
+                    journaledAt = stored;
+                }
+                return paced(offset, journal.size);
+            });
+        timer.finish(res ? res->status : 0);
+        if (!res) {
+            lease.discard();
+        }
+
+        if (res && (res->status == 200 || res->status == 206)) {
+            complete = true;
+        } else if (rangeRejected && journal.size > 0 && offset == journal.size) {
+            // Everything was already on disk when the previous attempt stopped.
+            complete = true;
+        } else if (restart || rangeRejected) {
+            offset = 0;
+            journal = DownloadJournal();
+            journal.file = filename.toStdString();
+            if (!sink.reset(0)) {
+                break;
+            }
+        } else if (writeFailed || (!res && res.error() == httplib::Error::Canceled)) {
+            break;
+        } else if (res) {
+            // An HTTP error such as 404 will not go away by retrying.
+            break;
+        } else if (encoded) {
+            // A dropped encoded stream has to start over.
+            offset = 0;
+            if (!sink.reset(0)) {
+                break;
+            }
+        }
+    }
+
+    if (!sink.flush()) {
+        complete = false;
+        offset = sink.written();
+    }
+    m_lastCompression.rawBytes = offset;
+    if (!m_lastCompression.compressed) {
+        m_lastCompression.wireBytes = offset;
+    }
+    m_lastCompression.cpuMicros = CompressionPolicy::threadCpuMicros() - cpuStart;
+    if (!complete) {
+        // Decoded offsets cannot be resumed with a byte range.
+        journal.offset = m_lastCompression.compressed ? 0 : offset;
+        saveJournal(journalPath, journal);
+        return false;
+    }
+
+    if (!sink.finish()) {
+        return false;
+    }
+    if (QFile::exists(destinationPath)) {
+        QFile::remove(destinationPath);
+    }
+    if (!QFile::rename(partPath, destinationPath)) {
+        return false;
+    }
+    QFile::remove(journalPath);
+    return true;
+}
+
+/**
+ * @brief Chooses how many parallel segments to use for a file of the given size.
+ *
+ * Small files are not worth the extra connections; larger files get one segment
+ * per kMinSegmentSize bytes, up to kMaxSegments.
+ */
+int APIClient::segmentCountForSize(qint64 size) {
+    if (size < 2 * kMinSegmentSize) {
+        return 1;
+    }
+    return static_cast<int>(std::min<qint64>(kMaxSegments, size / kMinSegmentSize));
+}
+
+/**
+ * @brief Downloads a file over several concurrent connections.
+ *
+ * Probes the file size and ETag with a one-byte Range request, then has each
+ * segment fetch its own byte range on a separate pooled connection, writing
+ * straight to that range's offset in "<destination>.segments". Segment
+ * workers run on a shared pool capped at kMaxSegments threads. A worker whose
+ * connection drops resumes from where it stopped; the range boundaries and the
+ * bytes each segment has flushed are journaled next to the data, so a paused,
+ * cancelled or crashed download continues where it left off on the next call
+ * as long as the server's copy is unchanged. Falls back to downloadFile() when
+ * the server does not honour Range requests, the file is too small, or a
+ * single-stream download of it is already part-way through.
+ */
+bool APIClient::downloadFileSegmented(const QString &filename, const QString &destinationPath,
+                                      int segments, const ProgressCallback &progress) {
+    const std::string host = m_serverUrl.toStdString();
+    QString encodedFilename = QUrl::toPercentEncoding(filename);
+    const std::string endpoint = "/api/download/" + encodedFilename.toStdString();
+    const QString dataPath = destinationPath + ".segments";
+    const QString journalPath = dataPath + ".json";
+
+    // Learn the total size and validator from a one-byte range probe.
+    qint64 totalSize = 0;
+    std::string etag;
+    {
+        ConnectionPool::Lease lease = ConnectionPool::instance().acquire(host);
+        httplib::Client &cli = lease.client();
+        httplib::Headers headers = { httplib::make_range_header({ { 0, 0 } }) };
+        RequestTimer timer("/api/download/{name}?probe");
+        auto res = cli.Get(endpoint, headers,
+            [&totalSize, &etag](const httplib::Response &response) {
+                if (response.status == 206) {
+                    parseContentRange(response.get_header_value("Content-Range"), totalSize);
+                    etag = response.get_header_value("ETag");
+                }
+                return false;
+            },
+            [](const char *, size_t) { return true; });
+        // The probe aborts itself once the headers arrive, so only the transport result matters.
+        timer.finish(res || res.error() == httplib::Error::Canceled ? 206 : 0);
+        if (!res) {
+            lease.discard();  // The rest of the body is still on the wire.
+        }
+    }
+
+    SegmentJournal journal;
+    bool resuming = loadSegmentJournal(journalPath, journal) && journal.file == filename.toStdString() &&
+                    journal.size == totalSize && journal.etag == etag && !journal.ranges.empty() &&
+                    QFileInfo(dataPath).size() == totalSize;
+    if (!resuming) {
+        QFile::remove(journalPath);
+        QFile::remove(dataPath);
+        // Keep a single-stream download that is already under way rather than discard its bytes.
+        if (QFile::exists(destinationPath + ".part.json")) {
+            return downloadFile(filename, destinationPath, progress);
+        }
+        if (segments <= 0) {
+            segments = segmentCountForSize(totalSize);
+        }
+        if (totalSize <= 0 || segments <= 1) {
+            return downloadFile(filename, destinationPath, progress);
+        }
+
+        QFile file(dataPath);
+        if (!file.open(QIODevice::WriteOnly) || !file.resize(totalSize)) {
             return false;
         }
-        file.write(QByteArray::fromStdString(res->body));
-        file.close();
-        return true;
+        journal.file = filename.toStdString();
+        journal.etag = etag;
+        journal.size = totalSize;
+        const qint64 segmentSize = (totalSize + segments - 1) / segments;
+        for (qint64 first = 0; first < totalSize; first += segmentSize) {
+            journal.ranges.push_back({ first, std::min(totalSize, first + segmentSize) - 1, first });
+        }
+        saveSegmentJournal(journalPath, journal);
+    }
+
+    auto interactive = markInteractive();
+    std::mutex journalMutex;  // Guards journal.ranges[].stored and the journal file
+    std::mutex progressMutex;
+    std::atomic<bool> cancelled(false);
+    std::atomic<bool> changed(false);
+    qint64 alreadyStored = 0;
+    for (const SegmentJournal::Range &range : journal.ranges) {
+        alreadyStored += range.stored - range.first;
+    }
+    std::atomic<qint64> received(alreadyStored);
+    std::vector<char> segmentOk(journal.ranges.size(), 0);
+
+    auto fetchSegment = [&](size_t index) {
+        qint64 position;
+        qint64 last;
+        {
+            std::lock_guard<std::mutex> lock(journalMutex);
+            position = journal.ranges[index].stored;
+            last = journal.ranges[index].last;
+        }
+        QFile file(dataPath);
+        if (position <= last && !file.open(QIODevice::ReadWrite)) {
+            cancelled = true;
+            return;
+        }
+
+        // Records what this segment has flushed so far.
+        qint64 journaledAt = position;
+        auto checkpoint = [&]() {
+            file.flush();
+            std::lock_guard<std::mutex> lock(journalMutex);
+            journal.ranges[index].stored = position;
+            saveSegmentJournal(journalPath, journal);
+            journaledAt = position;
+        };
+
+        ConnectionPool::Lease lease = ConnectionPool::instance().acquire(host);
+        httplib::Client &cli = lease.client();
+        const RetryPolicy policy = RetryPolicy::forOperation(RetryPolicy::Operation::Transfer);
+        std::chrono::milliseconds waited(0);
+        for (int attempt = 0; attempt < policy.maxAttempts() && position <= last && !cancelled; ++attempt) {
+            if (attempt > 0) {
+                std::chrono::milliseconds delay = policy.delayFor(attempt);
+                if (!policy.allows(attempt, waited, delay)) {
+                    break;
+                }
+                APIMetrics::instance().recordRetry("/api/download/{name}?segment");
+                std::this_thread::sleep_for(delay);
+                waited += delay;
+            }
+            if (!file.seek(position)) {
+                break;
+            }
+            httplib::Headers headers = { httplib::make_range_header({ { position, last } }) };
+            if (!journal.etag.empty()) {
+                headers.emplace("If-Range", journal.etag);
+            }
+            RequestTimer timer("/api/download/{name}?segment");
+            auto res = cli.Get(endpoint, headers,
+                [&](const httplib::Response &response) {
+                    qint64 total = 0;
+                    if (response.status == 200) {
+                        changed = true;  // If-Range failed: the remote file is a different version.
+                        return false;
+                    }
+                    return response.status == 206 &&
+                           parseContentRange(response.get_header_value("Content-Range"), total) == position;
+                },
+                [&](const char *data, size_t length) {
+                    if (cancelled || file.write(data, static_cast<qint64>(length)) != static_cast<qint64>(length)) {
+                        return false;
+                    }
+                    position += static_cast<qint64>(length);
+                    timer.addBytesIn(static_cast<qint64>(length));
+                    qint64 done = received += static_cast<qint64>(length);
+                    throttle(Direction::Download, static_cast<qint64>(length));
+                    if (position - journaledAt >= kJournalInterval) {
+                        checkpoint();
+                    }
+                    if (progress) {
+                        std::lock_guard<std::mutex> lock(progressMutex);
+                        if (!progress(done, totalSize)) {
+                            cancelled = true;
+                            return false;
+                        }
+                    }
+                    return true;
+                });
+            timer.finish(res ? res->status : 0);
+            if (!res) {
+                lease.discard();
+            }
+            if (changed) {
+                cancelled = true;
+                break;
+            }
+            if (res && res->status != 206) {
+                break;
+            }
+        }
+        if (file.isOpen()) {
+            checkpoint();
+        }
+        segmentOk[index] = (position > last);
+    };
+
+    std::vector<QFuture<void>> workers;
+    workers.reserve(journal.ranges.size());
+    for (size_t i = 0; i < journal.ranges.size(); ++i) {
+        workers.push_back(QtConcurrent::run(segmentPool(), fetchSegment, i));
+    }
+    for (auto &worker : workers) {
+        worker.waitForFinished();
+    }
+
+    if (changed) {
+        // The journaled bytes belong to an older version; the next attempt starts over.
+        QFile::remove(journalPath);
+        QFile::remove(dataPath);
+        return false;
+    }
+    bool complete = std::all_of(segmentOk.begin(), segmentOk.end(), [](char ok) { return ok != 0; });
+    if (!complete) {
+        // Keep the data and journal so the next call resumes every segment.
+        return false;
+    }
+
+    QFile::remove(journalPath);
+    if (QFile::exists(destinationPath)) {
+        QFile::remove(destinationPath);
     }
-    return false;
+    return QFile::rename(dataPath, destinationPath);
 }
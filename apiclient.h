@@ -2,6 +2,12 @@
 #define APICLIENT_H
 
 #include <QString>
+#include "compressionpolicy.h"
+#include "ratelimiter.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <utility>
 #include <vector>
 
 /**
@@ -9,30 +15,335 @@
  * @brief Encapsulates API communications with the backend.
  *
  * Provides methods for uploading, renaming, deleting, listing, and downloading files.
+ * Transient network failures are retried with backoff under RetryPolicy, and
+ * mutating requests carry an Idempotency-Key so a retry is never applied twice.
  */
 class APIClient {
 public:
+    /**
+     * @brief Reports transfer progress; returning false cancels the transfer.
+     * @param transferred Bytes transferred so far.
+     * @param total Total bytes expected, or 0 if the server did not say.
+     */
+    using ProgressCallback = std::function<bool(qint64 transferred, qint64 total)>;
+
+    /**
+     * @brief Outcome of one item in a batch operation.
+     */
+    struct BatchResult {
+        QString name;      ///< The file the item refers to (the old name for renames)
+        bool success;      ///< Whether the server applied the operation
+        QString error;     ///< Server-supplied reason when success is false
+    };
+
+    /**
+     * @brief Scheduling class of the transfers made by a client.
+     *
+     * Background transfers hold back while any interactive request is in flight,
+     * so listings and small operations stay responsive during bulk traffic.
+     */
+    enum class TransferClass { Interactive, Background };
+
     /**
      * @brief Constructs the API client with a default server URL.
      * @param serverUrl The base URL of the API server (default: "http://localhost:8080").
      */
     APIClient(const QString &serverUrl = "http://localhost:8080");
 
-    bool uploadFile(const QString &filePath);
+    /**
+     * @brief Uploads a file to the API server as a multipart form post.
+     *
+     * The file is streamed from disk in fixed-size chunks, so memory use does not grow with file size.
+     * Bodies that CompressionPolicy considers compressible are gzip-encoded on the fly
+     * when the server advertises gzip in an Accept-Encoding header on OPTIONS /api/upload;
+     * a 400, 411 or 415 answer to the encoded body makes the client send it once more as-is.
+     * @param filePath The local path of the file to upload.
+     * @param progress Optional callback invoked after each chunk is handed to the socket.
+     * @param remoteName Name to store the file under, which may contain '/' for subfolders
+     *                   as in uploadArchive(); empty to use the local file name.
+     * @return true if the upload succeeded; false otherwise.
+     */
+    bool uploadFile(const QString &filePath, const ProgressCallback &progress = nullptr,
+                    const QString &remoteName = QString());
+
+    /**
+     * @brief Uploads a file in fixed-size chunks through a resumable upload session.
+     *
+     * If a previous attempt for the same unchanged file was interrupted, the upload
+     * resumes from the last chunk the server acknowledged. Falls back to uploadFile()
+     * when the server has no session endpoint.
+     * @param filePath The local path of the file to upload.
+     * @param progress Optional callback invoked before each chunk is sent.
+     * @return true if the upload was committed; false otherwise.
+     */
+    bool uploadFileChunked(const QString &filePath, const ProgressCallback &progress = nullptr);
+
+    /**
+     * @brief Byte and chunk counts from a deduplicated upload.
+     */
+    struct DedupStats {
+        qint64 totalBytes = 0;     ///< Size of the local file
+        qint64 sentBytes = 0;      ///< Chunk bytes actually sent to the server
+        int totalChunks = 0;       ///< Number of chunks the file was split into
+        int sentChunks = 0;        ///< Number of chunks the server did not already have
+    };
+
+    /**
+     * @brief Uploads only the content-defined chunks the server does not already store.
+     *
+     * The file is split with ContentChunker, the server is asked which chunk hashes
+     * it is missing, only those chunks are sent, and the file is then assembled from
+     * its chunk list. An interrupted upload is naturally resumable because chunks
+     * that already arrived are no longer missing. Falls back to uploadFileChunked()
+     * when the server has no dedup endpoint.
+     * @param filePath The local path of the file to upload.
+     * @param progress Optional callback reporting bytes covered (sent or already present).
+     * @param stats Optional output for transfer statistics.
+     * @return true if the file was committed; false otherwise.
+     */
+    bool uploadFileDeduplicated(const QString &filePath, const ProgressCallback &progress = nullptr,
+                                DedupStats *stats = nullptr);
+
+    /**
+     * @brief Uploads many files in a single request as a streamed tar archive.
+     *
+     * The server unpacks the archive into its storage directory as it arrives, so
+     * thousands of small files cost one request instead of one each. Falls back to
+     * uploadFile() per file when the server has no archive endpoint.
+     * @param files Pairs of (local path, name on the server); names may contain '/' for subfolders.
+     * @param progress Optional callback reporting archive bytes sent.
+     * @return One result per file, in the same order.
+     */
+    std::vector<BatchResult> uploadArchive(const std::vector<std::pair<QString, QString>> &files,
+                                           const ProgressCallback &progress = nullptr);
+
+    /**
+     * @brief Wire and timing figures from a delta upload.
+     */
+    struct DeltaStats {
+        qint64 fileSize = 0;     ///< Size of the new local file
+        qint64 wireBytes = 0;    ///< Signature received plus delta sent, plus any full re-send
+        qint64 literalBytes = 0; ///< New data sent verbatim inside the delta
+        qint64 elapsedMs = 0;    ///< Wall time from signature request to server acknowledgement
+        bool usedDelta = false;  ///< false if the call fell back to a full upload
+    };
+
+    /**
+     * @brief Uploads a modified file by sending only what differs from the server's copy.
+     *
+     * Fetches the rsync-style block signature of the server's current version, encodes
+     * the local file against it with DeltaEncoder, and posts the delta for the server
+     * to rebuild the new version. Falls back to uploadFile() when the server has no
+     * copy, no delta endpoint, or its copy changed between signature and apply.
+     * @param filePath The local path of the file to upload.
+     * @param progress Optional callback reporting encoding and sending progress.
+     * @param stats Optional output for wire bytes and elapsed time.
+     * @return true if the server holds the new version; false otherwise.
+     */
+    bool uploadFileDelta(const QString &filePath, const ProgressCallback &progress = nullptr,
+                         DeltaStats *stats = nullptr);
+
+    /**
+     * @brief Asks the server to create a file from identical content it already stores.
+     *
+     * Sends the file's name, size and FileHasher digest to /api/have. The server links
+     * or copies its existing content under the new name if it has a match.
+     * @param filePath The local file being uploaded.
+     * @param contentHash The file's hex digest from FileHasher::hashFile().
+     * @return true if the server now has the file and no upload is needed; false otherwise.
+     */
+    bool linkExistingContent(const QString &filePath, const QByteArray &contentHash);
+
+    /**
+     * @brief One entry of the server's file listing.
+     *
+     * Servers that only send names leave the other fields at their defaults.
+     */
+    struct RemoteFile {
+        QString name;           ///< File name on the server
+        qint64 size = -1;       ///< Size in bytes, or -1 if unknown
+        qint64 modified = 0;    ///< Last modification in ms since the Unix epoch, or 0 if unknown
+        QString contentHash;    ///< Hex content digest, or empty
+        QString mimeType;       ///< MIME type, or empty
+    };
+
+    /**
+     * @brief Receives a batch of entries from a listing; returning false stops it.
+     * @param files The entries, which the callback may move from.
+     */
+    using ListingCallback = std::function<bool(std::vector<RemoteFile> &files)>;
+
+    /**
+     * @brief Returns every file name on the server; a wrapper around listFilesPaged().
+     */
     std::vector<QString> listFiles();
+
+    /**
+     * @brief Streams the server's file list in cursor-based pages.
+     *
+     * Requests /api/files?limit=<pageSize>&cursor=<next> until the server returns
+     * no "next" cursor. Pages are requested as CBOR, which carries the size,
+     * modification time, hash and MIME type of every file in fewer bytes than
+     * JSON and decodes faster; servers that only speak JSON are read as JSON. Each response
+     * is parsed incrementally with ListingParser while it downloads, and entries
+     * are passed to @p onBatch in small batches, so the caller can show the first
+     * files long before a large listing completes. Servers that answer with a
+     * plain array of names are treated as a single page. The last complete
+     * listing is cached on disk (ListingCache) and revalidated with If-None-Match;
+     * when the server answers 304 the cached entries are replayed instead.
+     * @param onBatch Called on this thread with each batch of entries.
+     * @param pageSize Names per page, or 0 for the default.
+     * @param sequence Optional output for the change sequence the listing starts at
+     *                 (see fetchChanges()), or -1 if the server has no change journal.
+     * @return true if the whole listing was received; false on failure or when stopped.
+     */
+    bool listFilesPaged(const ListingCallback &onBatch, int pageSize = 0, qint64 *sequence = nullptr);
+
+    /**
+     * @brief One entry of the server's change journal.
+     */
+    struct FileChange {
+        enum class Type { Added, Removed, Renamed };
+        Type type = Type::Added;
+        RemoteFile file;      ///< The file as it now is; only the name is set for removals
+        QString oldName;      ///< Previous name, for renames
+    };
+
+    /**
+     * @brief Outcome of fetchChanges().
+     */
+    enum class ChangesResult {
+        Ok,       ///< The changes were fetched and the catalog can be patched
+        Expired,  ///< The server cannot answer from that sequence; relist everything
+        Failed    ///< The request failed; try again later
+    };
+
+    /**
+     * @brief Fetches what changed on the server since a listing or an earlier call.
+     *
+     * Requests /api/changes?since=<since> and follows "more" until caught up. The
+     * server keeps a monotonically increasing change sequence and answers
+     *   {"seq": <latest>, "more": bool, "changes": [
+     *       {"op": "add", "file": {...}},
+     *       {"op": "remove", "name": "..."},
+     *       {"op": "rename", "from": "...", "to": "..."}]}
+     * where "file" has the listing entry format. When nothing changed the reply is
+     * a few dozen bytes. A 410 (journal truncated) or 404 (no journal) means the
+     * client must fall back to a full listing.
+     * @param since Sequence from listFilesPaged() or a previous call.
+     * @param changes Receives the changes, oldest first.
+     * @param latest Receives the sequence to pass next time.
+     */
+    ChangesResult fetchChanges(qint64 since, std::vector<FileChange> &changes, qint64 &latest);
     bool renameFile(const QString &oldName, const QString &newName);
     bool deleteFile(const QString &filename);
 
     /**
-     * @brief Downloads a file from the API server.
+     * @brief Deletes many files in one or a few batch requests.
+     *
+     * Falls back to one request per file when the server has no batch endpoint.
+     * @param filenames The files to delete.
+     * @return One result per file, in the same order.
+     */
+    std::vector<BatchResult> deleteFiles(const std::vector<QString> &filenames);
+
+    /**
+     * @brief Renames many files in one or a few batch requests.
+     * @param renames Pairs of (old name, new name).
+     * @return One result per pair, in the same order.
+     */
+    std::vector<BatchResult> renameFiles(const std::vector<std::pair<QString, QString>> &renames);
+
+    /**
+     * @brief Downloads a file from the API server, streaming it straight to disk.
+     *
+     * Data is written to "<destinationPath>.part" and renamed into place when complete.
+     * An interrupted or cancelled download leaves the part file and its journal behind,
+     * and the next call for the same destination resumes where it stopped.
      * @param filename The name of the file to download.
      * @param destinationPath The full path (including filename) where the file will be saved.
+     * @param progress Optional callback invoked after each received chunk.
      * @return true if the download succeeded; false otherwise.
      */
-    bool downloadFile(const QString &filename, const QString &destinationPath);
+    bool downloadFile(const QString &filename, const QString &destinationPath,
+                      const ProgressCallback &progress = nullptr);
+
+    /**
+     * @brief Downloads a file as several byte ranges fetched over concurrent connections.
+     *
+     * Data goes to "<destinationPath>.segments" with per-segment progress in
+     * "<destinationPath>.segments.json"; both are kept when the download stops
+     * early so the next call resumes it.
+     * @param filename The name of the file to download.
+     * @param destinationPath The full path (including filename) where the file will be saved.
+     * @param segments Number of parallel connections; 0 picks a count from the file size.
+     * @param progress Optional callback, serialized across workers, reporting combined progress.
+     * @return true if every segment was downloaded; false otherwise.
+     */
+    bool downloadFileSegmented(const QString &filename, const QString &destinationPath,
+                               int segments = 0, const ProgressCallback &progress = nullptr);
+
+    /**
+     * @brief Returns the number of parallel segments used for a file of the given size.
+     */
+    static int segmentCountForSize(qint64 size);
+
+    static constexpr qint64 kMinSegmentSize = 32 * 1024 * 1024; ///< Smallest range worth its own connection
+    static constexpr int kMaxSegments = 8;                       ///< Upper bound on parallel connections
+
+    /**
+     * @brief Returns how compression affected the last uploadFile() or downloadFile() call.
+     */
+    const CompressionReport &lastCompression() const { return m_lastCompression; }
+
+    /**
+     * @brief Limits the transfers made through this client, on top of the global limits.
+     * @param uploadBytesPerSecond Upload cap, or 0 for no per-transfer cap.
+     * @param downloadBytesPerSecond Download cap, or 0 for no per-transfer cap.
+     */
+    void setRateLimits(qint64 uploadBytesPerSecond, qint64 downloadBytesPerSecond);
+
+    /**
+     * @brief Paces this client's transfers with buckets owned by the caller, on top of the global limits.
+     *
+     * The caller may change the buckets' rates while a transfer runs; null removes that cap.
+     */
+    void setRateLimiters(std::shared_ptr<RateLimiter> upload, std::shared_ptr<RateLimiter> download);
+
+    /**
+     * @brief Sets the process-wide upload and download caps shared by all clients (0 = unlimited).
+     *
+     * Takes effect for transfers already running and is saved for the next start.
+     */
+    static void setGlobalRateLimits(qint64 uploadBytesPerSecond, qint64 downloadBytesPerSecond);
+
+    void setTransferClass(TransferClass transferClass) { m_transferClass = transferClass; }
 
 private:
+    enum class Direction { Upload, Download };
+
+    /**
+     * @brief Paces @p bytes against the global and per-client buckets, yielding first if background.
+     */
+    void throttle(Direction direction, qint64 bytes) const;
+
+    /**
+     * @brief Wraps a progress callback so each reported advance is paced by throttle().
+     * @param start Byte count the transfer starts from: the resume offset, or 0 for a fresh body.
+     */
+    ProgressCallback throttled(Direction direction, const ProgressCallback &progress, qint64 start = 0) const;
+
+    /**
+     * @brief Returns a guard marking an interactive transfer in flight, or null for background clients.
+     */
+    std::unique_ptr<RateLimiter::InteractiveScope> markInteractive() const;
+
     QString m_serverUrl;
+    CompressionReport m_lastCompression; ///< Filled by uploadFile() and downloadFile()
+    TransferClass m_transferClass = TransferClass::Interactive;
+    std::shared_ptr<RateLimiter> m_uploadLimiter;   ///< Per-client upload cap, or null
+    std::shared_ptr<RateLimiter> m_downloadLimiter; ///< Per-client download cap, or null
+    mutable std::atomic<qint64> m_lastBlockEnd{-1}; ///< When throttle() last returned, in steady-clock microseconds
 };
 
 #endif
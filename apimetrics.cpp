@@ -0,0 +1,215 @@
+#include "apimetrics.h"
+#include <algorithm>
+
+/**
+ * @brief Creates an empty histogram.
+ */
+LatencyHistogram::LatencyHistogram()
+{
+    for (auto &bucket : m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Maps a value to its bucket: exact below 32, then 16 linear steps per power of two.
+ */
+int LatencyHistogram::bucketFor(qint64 micros)
+{
+    if (micros < kLinearBuckets)
+        return static_cast<int>(std::max<qint64>(0, micros));
+
+    int msb = 0;
+    for (quint64 v = static_cast<quint64>(micros); v > 1; v >>= 1)
+        msb++;
+    // msb >= 5 here; keep the four bits below the leading one as the sub-bucket.
+    int shift = msb - 4;
+    int sub = static_cast<int>((micros >> shift) - kSubBuckets);
+    int bucket = kLinearBuckets + (msb - 5) * kSubBuckets + sub;
+    return std::min(bucket, kBucketCount - 1);
+}
+
+/**
+ * @brief Returns the largest value that falls into a bucket.
+ */
+qint64 LatencyHistogram::upperBound(int bucket)
+{
+    if (bucket < kLinearBuckets)
+        return bucket;
+    int octave = (bucket - kLinearBuckets) / kSubBuckets;
+    int sub = (bucket - kLinearBuckets) % kSubBuckets;
+    int shift = octave + 1;
+    return ((static_cast<qint64>(kSubBuckets + sub + 1)) << shift) - 1;
+}
+
+/**
+ * @brief Adds one sample; safe to call from any thread.
+ */
+void LatencyHistogram::record(qint64 micros)
+{
+    m_buckets[bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(micros, std::memory_order_relaxed);
+    qint64 seen = m_max.load(std::memory_order_relaxed);
+    while (micros > seen && !m_max.compare_exchange_weak(seen, micros, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Walks the buckets to the requested rank; the result is capped at the recorded maximum.
+ */
+qint64 LatencyHistogram::percentile(double percentile) const
+{
+    quint64 total = count();
+    if (total == 0)
+        return 0;
+
+    quint64 rank = static_cast<quint64>(percentile / 100.0 * static_cast<double>(total) + 0.5);
+    rank = std::max<quint64>(1, std::min(rank, total));
+    quint64 seen = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return std::min(upperBound(i), max());
+    }
+    return max();
+}
+
+/**
+ * @brief Returns the mean sample in microseconds.
+ */
+double LatencyHistogram::mean() const
+{
+    quint64 total = count();
+    return total ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(total) : 0.0;
+}
+
+/**
+ * @brief Clears every bucket and summary counter.
+ */
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the shared metrics registry.
+ */
+APIMetrics &APIMetrics::instance()
+{
+    static APIMetrics metrics;
+    return metrics;
+}
+
+/**
+ * @brief Finds or creates an endpoint entry; entries are never removed, so references stay valid.
+ */
+APIMetrics::Endpoint &APIMetrics::endpoint(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &entry = m_endpoints[name];
+    if (!entry)
+        entry = std::make_unique<Endpoint>();
+    return *entry;
+}
+
+/**
+ * @brief Counts a pooled connection hand-out as reused or freshly opened.
+ */
+void APIMetrics::recordConnection(bool reused)
+{
+    (reused ? m_connectionsReused : m_connectionsOpened).fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Adds a retry to the endpoint's counters.
+ */
+void APIMetrics::recordRetry(const std::string &name)
+{
+    endpoint(name).retries.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Serialises all endpoints; latencies are reported in microseconds.
+ */
+nlohmann::json APIMetrics::toJson() const
+{
+    nlohmann::json endpoints = nlohmann::json::object();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &item : m_endpoints) {
+        const Endpoint &e = *item.second;
+        endpoints[item.first] = {
+            { "requests", e.requests.load() },
+            { "errors", e.errors.load() },
+            { "retries", e.retries.load() },
+            { "bytesIn", e.bytesIn.load() },
+            { "bytesOut", e.bytesOut.load() },
+            { "latencyUs", {
+                { "mean", e.latency.mean() },
+                { "p50", e.latency.percentile(50) },
+                { "p95", e.latency.percentile(95) },
+                { "p99", e.latency.percentile(99) },
+                { "max", e.latency.max() }
+            } }
+        };
+    }
+    return {
+        { "endpoints", endpoints },
+        { "connections", {
+            { "reused", m_connectionsReused.load() },
+            { "opened", m_connectionsOpened.load() }
+        } }
+    };
+}
+
+/**
+ * @brief Zeroes every counter, keeping the endpoint entries.
+ */
+void APIMetrics::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &item : m_endpoints) {
+        Endpoint &e = *item.second;
+        e.latency.reset();
+        e.requests = 0;
+        e.errors = 0;
+        e.retries = 0;
+        e.bytesIn = 0;
+        e.bytesOut = 0;
+    }
+    m_connectionsReused = 0;
+    m_connectionsOpened = 0;
+}
+
+/**
+ * @brief Looks up the endpoint entry and starts the clock.
+ */
+RequestTimer::RequestTimer(const std::string &endpoint)
+    : m_endpoint(APIMetrics::instance().endpoint(endpoint)), m_start(std::chrono::steady_clock::now())
+{
+}
+
+/**
+ * @brief Records the latency and outcome.
+ */
+RequestTimer::~RequestTimer()
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start);
+    m_endpoint.latency.record(elapsed.count());
+    m_endpoint.requests.fetch_add(1, std::memory_order_relaxed);
+    if (m_status == 0 || m_status >= 400)
+        m_endpoint.errors.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Stores the status for the destructor and counts the response body.
+ */
+void RequestTimer::finish(int status, qint64 bytesIn)
+{
+    m_status = status;
+    if (bytesIn > 0)
+        addBytesIn(bytesIn);
+}
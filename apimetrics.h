@@ -0,0 +1,137 @@
+#ifndef APIMETRICS_H
+#define APIMETRICS_H
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "json/json.hpp"
+
+/**
+ * @class LatencyHistogram
+ * @brief Lock-free log-linear latency histogram in the style of HdrHistogram.
+ *
+ * Values are microseconds. Each power of two is split into 16 linear
+ * sub-buckets, so any reported percentile is within about 6% of the true value,
+ * while the whole histogram is a fixed array of counters updated with relaxed
+ * atomic increments.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(qint64 micros);
+
+    /**
+     * @brief Returns the value at or below which @p percentile percent of samples fall.
+     */
+    qint64 percentile(double percentile) const;
+
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    qint64 max() const { return m_max.load(std::memory_order_relaxed); }
+    double mean() const;
+    void reset();
+
+private:
+    static constexpr int kLinearBuckets = 32;   ///< Exact buckets for 0..31 us
+    static constexpr int kSubBuckets = 16;      ///< Sub-buckets per power of two above that
+    static constexpr int kBucketCount = kLinearBuckets + 40 * kSubBuckets;
+
+    static int bucketFor(qint64 micros);
+    static qint64 upperBound(int bucket);
+
+    std::array<std::atomic<quint64>, kBucketCount> m_buckets;
+    std::atomic<quint64> m_count{0};
+    std::atomic<qint64> m_sum{0};
+    std::atomic<qint64> m_max{0};
+};
+
+/**
+ * @class APIMetrics
+ * @brief Process-wide request statistics, grouped by endpoint.
+ *
+ * Records latency, request, error and retry counts and bytes in and out for
+ * every endpoint, plus how often the ConnectionPool reused a connection. All
+ * counters are atomics; the only lock is taken to find an endpoint's entry,
+ * once per request.
+ */
+class APIMetrics {
+public:
+    /**
+     * @brief Counters for one endpoint.
+     */
+    struct Endpoint {
+        LatencyHistogram latency;
+        std::atomic<quint64> requests{0};
+        std::atomic<quint64> errors{0};    ///< Transport failures and 4xx/5xx responses
+        std::atomic<quint64> retries{0};
+        std::atomic<quint64> bytesIn{0};
+        std::atomic<quint64> bytesOut{0};
+    };
+
+    static APIMetrics &instance();
+
+    /**
+     * @brief Returns the entry for an endpoint label, creating it on first use.
+     */
+    Endpoint &endpoint(const std::string &name);
+
+    void recordConnection(bool reused);
+
+    /**
+     * @brief Counts one retry of a request to @p name.
+     */
+    void recordRetry(const std::string &name);
+
+    /**
+     * @brief Returns every counter and the p50/p95/p99 latencies as JSON.
+     */
+    nlohmann::json toJson() const;
+
+    void reset();
+
+private:
+    APIMetrics() = default;
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::unique_ptr<Endpoint>> m_endpoints;
+    std::atomic<quint64> m_connectionsReused{0};
+    std::atomic<quint64> m_connectionsOpened{0};
+};
+
+/**
+ * @class RequestTimer
+ * @brief Times one request and adds it to APIMetrics when destroyed.
+ *
+ * A request that is never given a status through finish() counts as an error.
+ */
+class RequestTimer {
+public:
+    explicit RequestTimer(const std::string &endpoint);
+    ~RequestTimer();
+
+    RequestTimer(const RequestTimer &) = delete;
+    RequestTimer &operator=(const RequestTimer &) = delete;
+
+    /**
+     * @brief Records the outcome.
+     * @param status HTTP status, or 0 if the request failed before a response.
+     * @param bytesIn Response body bytes not already counted with addBytesIn().
+     */
+    void finish(int status, qint64 bytesIn = 0);
+
+    void addBytesIn(qint64 bytes) { m_endpoint.bytesIn.fetch_add(bytes, std::memory_order_relaxed); }
+    void addBytesOut(qint64 bytes) { m_endpoint.bytesOut.fetch_add(bytes, std::memory_order_relaxed); }
+    void retry() { m_endpoint.retries.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    APIMetrics::Endpoint &m_endpoint;
+    std::chrono::steady_clock::time_point m_start;
+    int m_status = 0;
+};
+
+#endif // APIMETRICS_H
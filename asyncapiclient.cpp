@@ -0,0 +1,337 @@
+#include "asyncapiclient.h"
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <functional>
+#include <mutex>
+
+namespace {
+
+/// Number of network operations allowed to run at the same time.
+constexpr int kNetworkThreads = 4;
+
+/// Minimum time between two transferProgress signals for one transfer.
+constexpr qint64 kProgressIntervalMs = 100;
+
+} // namespace
+
+/**
+ * @brief Forwards work results from network threads to the owning object.
+ *
+ * The owner clears the pointer under the mutex when it is destroyed, after which
+ * nothing more is posted; events already queued are discarded by Qt along with
+ * the receiver.
+ */
+struct AsyncAPIClient::Relay {
+    std::mutex mutex;
+    AsyncAPIClient *client = nullptr;
+
+    /**
+     * @brief Queues @p deliver to run on the owner's thread.
+     * @return false if the owner no longer exists.
+     */
+    bool post(std::function<void(AsyncAPIClient *)> deliver) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!client) {
+            return false;
+        }
+        AsyncAPIClient *target = client;
+        QMetaObject::invokeMethod(target, [target, deliver]() { deliver(target); }, Qt::QueuedConnection);
+        return true;
+    }
+};
+
+/**
+ * @brief Constructs the asynchronous client for the given server.
+ */
+AsyncAPIClient::AsyncAPIClient(const QString &serverUrl, QObject *parent)
+    : QObject(parent), m_serverUrl(serverUrl), m_relay(std::make_shared<Relay>())
+{
+    m_relay->client = this;
+}
+
+/**
+ * @brief Detaches from in-flight work so late results are dropped.
+ */
+AsyncAPIClient::~AsyncAPIClient()
+{
+    std::lock_guard<std::mutex> lock(m_relay->mutex);
+    m_relay->client = nullptr;
+}
+
+/**
+ * @brief Returns the dedicated pool that runs network calls off the GUI thread.
+ */
+QThreadPool *AsyncAPIClient::networkPool()
+{
+    static QThreadPool *pool = [] {
+        QThreadPool *threadPool = new QThreadPool();
+        threadPool->setMaxThreadCount(kNetworkThreads);
+        return threadPool;
+    }();
+    return pool;
+}
+
+/**
+ * @brief Runs @p work on the network pool and hands its result to @p deliver on this object's thread.
+ *
+ * @p work receives a progress callback that throttles transferProgress signals and
+ * cancels the transfer once this object is gone.
+ */
+template <typename T, typename Work, typename Deliver>
+QFuture<T> AsyncAPIClient::run(Work work, Deliver deliver)
+{
+    std::shared_ptr<Relay> relay = m_relay;
+    return QtConcurrent::run(networkPool(), [relay, work, deliver]() -> T {
+        QElapsedTimer sinceLastReport;
+        sinceLastReport.start();
+        auto progress = [relay, &sinceLastReport](const QString &name, qint64 transferred, qint64 total) {
+            if (sinceLastReport.elapsed() < kProgressIntervalMs && transferred != total) {
+                std::lock_guard<std::mutex> lock(relay->mutex);
+                return relay->client != nullptr;
+            }
+            sinceLastReport.restart();
+            return relay->post([name, transferred, total](AsyncAPIClient *client) {
+                emit client->transferProgress(name, transferred, total);
+            });
+        };
+
+        T result = work(progress);
+        relay->post([deliver, result](AsyncAPIClient *client) { deliver(client, result); });
+        return result;
+    });
+}
+
+/**
+ * @brief Uploads a file in the background; emits uploadFinished().
+ */
+QFuture<bool> AsyncAPIClient::uploadFile(const QString &filePath)
+{
+    QString serverUrl = m_serverUrl;
+    return run<bool>(
+        [serverUrl, filePath](auto &progress) {
+            return APIClient(serverUrl).uploadFile(filePath, [&](qint64 sent, qint64 total) {
+                return progress(filePath, sent, total);
+            });
+        },
+        [filePath](AsyncAPIClient *client, bool success) { emit client->uploadFinished(filePath, success); });
+}
+
+/**
+ * @brief Uploads a file through a resumable session in the background; emits uploadFinished().
+ */
+QFuture<bool> AsyncAPIClient::uploadFileChunked(const QString &filePath)
+{
+    QString serverUrl = m_serverUrl;
+    return run<bool>(
+        [serverUrl, filePath](auto &progress) {
+            return APIClient(serverUrl).uploadFileChunked(filePath, [&](qint64 sent, qint64 total) {
+                return progress(filePath, sent, total);
+            });
+        },
+        [filePath](AsyncAPIClient *client, bool success) { emit client->uploadFinished(filePath, success); });
+}
+
+/**
+ * @brief Uploads only the chunks the server is missing in the background; emits uploadFinished().
+ */
+QFuture<bool> AsyncAPIClient::uploadFileDeduplicated(const QString &filePath)
+{
+    QString serverUrl = m_serverUrl;
+    return run<bool>(
+        [serverUrl, filePath](auto &progress) {
+            return APIClient(serverUrl).uploadFileDeduplicated(filePath, [&](qint64 sent, qint64 total) {
+                return progress(filePath, sent, total);
+            });
+        },
+        [filePath](AsyncAPIClient *client, bool success) { emit client->uploadFinished(filePath, success); });
+}
+
+/**
+ * @brief Uploads only what changed since the server's copy in the background; emits uploadFinished().
+ */
+QFuture<bool> AsyncAPIClient::uploadFileDelta(const QString &filePath)
+{
+    QString serverUrl = m_serverUrl;
+    return run<bool>(
+        [serverUrl, filePath](auto &progress) {
+            return APIClient(serverUrl).uploadFileDelta(filePath, [&](qint64 sent, qint64 total) {
+                return progress(filePath, sent, total);
+            });
+        },
+        [filePath](AsyncAPIClient *client, bool success) { emit client->uploadFinished(filePath, success); });
+}
+
+/**
+ * @brief Uploads many files as one archive in the background; emits archiveUploadFinished().
+ *
+ * Progress is reported under the first file's local path, since the archive has no name of its own.
+ */
+QFuture<std::vector<APIClient::BatchResult>> AsyncAPIClient::uploadArchive(
+    const std::vector<std::pair<QString, QString>> &files)
+{
+    QString serverUrl = m_serverUrl;
+    QString name = files.empty() ? QString() : files.front().first;
+    return run<std::vector<APIClient::BatchResult>>(
+        [serverUrl, files, name](auto &progress) {
+            return APIClient(serverUrl).uploadArchive(files, [&](qint64 sent, qint64 total) {
+                return progress(name, sent, total);
+            });
+        },
+        [](AsyncAPIClient *client, const std::vector<APIClient::BatchResult> &results) {
+            emit client->archiveUploadFinished(results);
+        });
+}
+
+/**
+ * @brief Offers a file's digest to the server in the background; emits contentLinked().
+ */
+QFuture<bool> AsyncAPIClient::linkExistingContent(const QString &filePath, const QByteArray &contentHash)
+{
+    QString serverUrl = m_serverUrl;
+    return run<bool>(
+        [serverUrl, filePath, contentHash](auto &) {
+            return APIClient(serverUrl).linkExistingContent(filePath, contentHash);
+        },
+        [filePath](AsyncAPIClient *client, bool linked) { emit client->contentLinked(filePath, linked); });
+}
+
+/**
+ * @brief Fetches the server file list in the background.
+ *
+ * Each batch is posted as filesListed() as soon as it is parsed, so the view
+ * fills in while the rest of the listing is still downloading. The listing
+ * stops early once this object is gone.
+ */
+QFuture<bool> AsyncAPIClient::listFiles()
+{
+    QString serverUrl = m_serverUrl;
+    std::shared_ptr<Relay> relay = m_relay;
+    auto sequence = std::make_shared<qint64>(-1);
+    return run<bool>(
+        [serverUrl, relay, sequence](auto &) {
+            return APIClient(serverUrl).listFilesPaged([&relay](std::vector<APIClient::RemoteFile> &entries) {
+                QList<APIClient::RemoteFile> files;
+                files.reserve(static_cast<int>(entries.size()));
+                for (APIClient::RemoteFile &entry : entries) {
+                    files.append(std::move(entry));
+                }
+                return relay->post([files](AsyncAPIClient *client) { emit client->filesListed(files); });
+            }, 0, sequence.get());
+        },
+        [sequence](AsyncAPIClient *client, bool success) { emit client->listingFinished(success, *sequence); });
+}
+
+/**
+ * @brief Fetches the change journal in the background; emits changesFetched().
+ */
+QFuture<bool> AsyncAPIClient::fetchChanges(qint64 since)
+{
+    QString serverUrl = m_serverUrl;
+    std::shared_ptr<Relay> relay = m_relay;
+    return run<bool>(
+        [serverUrl, relay, since](auto &) {
+            std::vector<APIClient::FileChange> fetched;
+            qint64 latest = since;
+            APIClient::ChangesResult result = APIClient(serverUrl).fetchChanges(since, fetched, latest);
+            QList<APIClient::FileChange> changes;
+            if (result == APIClient::ChangesResult::Ok) {
+                changes.reserve(static_cast<int>(fetched.size()));
+                for (APIClient::FileChange &change : fetched) {
+                    changes.append(std::move(change));
+                }
+            }
+            relay->post([result, changes, latest](AsyncAPIClient *client) {
+                emit client->changesFetched(result, changes, latest);
+            });
+            return result == APIClient::ChangesResult::Ok;
+        },
+        [](AsyncAPIClient *, bool) {});
+}
+
+/**
+ * @brief Renames a file in the background; emits renameFinished().
+ */
+QFuture<bool> AsyncAPIClient::renameFile(const QString &oldName, const QString &newName)
+{
+    QString serverUrl = m_serverUrl;
+    return run<bool>(
+        [serverUrl, oldName, newName](auto &) { return APIClient(serverUrl).renameFile(oldName, newName); },
+        [oldName, newName](AsyncAPIClient *client, bool success) {
+            emit client->renameFinished(oldName, newName, success);
+        });
+}
+
+/**
+ * @brief Deletes a file in the background; emits deleteFinished().
+ */
+QFuture<bool> AsyncAPIClient::deleteFile(const QString &filename)
+{
+    QString serverUrl = m_serverUrl;
+    return run<bool>(
+        [serverUrl, filename](auto &) { return APIClient(serverUrl).deleteFile(filename); },
+        [filename](AsyncAPIClient *client, bool success) { emit client->deleteFinished(filename, success); });
+}
+
+/**
+ * @brief Deletes many files in the background; emits deleteBatchFinished().
+ */
+QFuture<std::vector<APIClient::BatchResult>> AsyncAPIClient::deleteFiles(const QStringList &filenames)
+{
+    QString serverUrl = m_serverUrl;
+    std::vector<QString> names(filenames.begin(), filenames.end());
+    return run<std::vector<APIClient::BatchResult>>(
+        [serverUrl, names](auto &) { return APIClient(serverUrl).deleteFiles(names); },
+        [](AsyncAPIClient *client, const std::vector<APIClient::BatchResult> &results) {
+            emit client->deleteBatchFinished(results);
+        });
+}
+
+/**
+ * @brief Renames many files in the background; emits renameBatchFinished().
+ */
+QFuture<std::vector<APIClient::BatchResult>> AsyncAPIClient::renameFiles(
+    const std::vector<std::pair<QString, QString>> &renames)
+{
+    QString serverUrl = m_serverUrl;
+    return run<std::vector<APIClient::BatchResult>>(
+        [serverUrl, renames](auto &) { return APIClient(serverUrl).renameFiles(renames); },
+        [](AsyncAPIClient *client, const std::vector<APIClient::BatchResult> &results) {
+            emit client->renameBatchFinished(results);
+        });
+}
+
+/**
+ * @brief Downloads a file in the background; emits downloadFinished().
+ */
+QFuture<bool> AsyncAPIClient::downloadFile(const QString &filename, const QString &destinationPath)
+{
+    QString serverUrl = m_serverUrl;
+    return run<bool>(
+        [serverUrl, filename, destinationPath](auto &progress) {
+            return APIClient(serverUrl).downloadFile(filename, destinationPath, [&](qint64 received, qint64 total) {
+                return progress(filename, received, total);
+            });
+        },
+        [filename, destinationPath](AsyncAPIClient *client, bool success) {
+            emit client->downloadFinished(filename, destinationPath, success);
+        });
+}
+
+/**
+ * @brief Downloads a file over parallel connections in the background; emits downloadFinished().
+ */
+QFuture<bool> AsyncAPIClient::downloadFileSegmented(const QString &filename, const QString &destinationPath,
+                                                    int segments)
+{
+    QString serverUrl = m_serverUrl;
+    return run<bool>(
+        [serverUrl, filename, destinationPath, segments](auto &progress) {
+            return APIClient(serverUrl).downloadFileSegmented(filename, destinationPath, segments,
+                [&](qint64 received, qint64 total) { return progress(filename, received, total); });
+        },
+        [filename, destinationPath](AsyncAPIClient *client, bool success) {
+            emit client->downloadFinished(filename, destinationPath, success);
+        });
+}
@@ -0,0 +1,159 @@
+#ifndef ASYNCAPICLIENT_H
+#define ASYNCAPICLIENT_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QFuture>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "APIClient.h"
+
+class QThreadPool;
+
+/**
+ * @class AsyncAPIClient
+ * @brief Non-blocking front end for APIClient.
+ *
+ * Every call runs the matching APIClient method on a dedicated network thread
+ * pool and returns immediately with a QFuture. When the call completes, the
+ * corresponding signal is emitted on the thread that owns this object (the GUI
+ * thread), so slots can update widgets directly. Destroying the object cancels
+ * any transfer that reports progress and drops undelivered results.
+ */
+class AsyncAPIClient : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the asynchronous client.
+     * @param serverUrl The base URL of the API server.
+     * @param parent Optional parent QObject.
+     */
+    explicit AsyncAPIClient(const QString &serverUrl = "http://localhost:8080", QObject *parent = nullptr);
+    ~AsyncAPIClient() override;
+
+    /**
+     * @brief Returns the thread pool shared by all network calls.
+     */
+    static QThreadPool *networkPool();
+
+    QFuture<bool> uploadFile(const QString &filePath);
+    QFuture<bool> uploadFileChunked(const QString &filePath);
+    QFuture<bool> uploadFileDeduplicated(const QString &filePath);
+    QFuture<bool> uploadFileDelta(const QString &filePath);
+
+    /**
+     * @brief Uploads many files as one streamed tar archive; emits archiveUploadFinished().
+     * @param files Pairs of (local path, name on the server).
+     */
+    QFuture<std::vector<APIClient::BatchResult>> uploadArchive(const std::vector<std::pair<QString, QString>> &files);
+
+    /**
+     * @brief Asks the server to reuse content it already stores; emits contentLinked().
+     */
+    QFuture<bool> linkExistingContent(const QString &filePath, const QByteArray &contentHash);
+
+    /**
+     * @brief Streams the server file list, emitting filesListed() per batch and then listingFinished().
+     */
+    QFuture<bool> listFiles();
+
+    /**
+     * @brief Fetches the server's changes since @p since; emits changesFetched().
+     */
+    QFuture<bool> fetchChanges(qint64 since);
+
+    QFuture<bool> renameFile(const QString &oldName, const QString &newName);
+    QFuture<bool> deleteFile(const QString &filename);
+    QFuture<std::vector<APIClient::BatchResult>> deleteFiles(const QStringList &filenames);
+    QFuture<std::vector<APIClient::BatchResult>> renameFiles(const std::vector<std::pair<QString, QString>> &renames);
+    QFuture<bool> downloadFile(const QString &filename, const QString &destinationPath);
+    QFuture<bool> downloadFileSegmented(const QString &filename, const QString &destinationPath, int segments = 0);
+
+signals:
+    /**
+     * @brief Emitted when an upload started with any of the upload methods finishes.
+     */
+    void uploadFinished(const QString &filePath, bool success);
+
+    /**
+     * @brief Emitted with one result per file when uploadArchive() finishes.
+     */
+    void archiveUploadFinished(const std::vector<APIClient::BatchResult> &results);
+
+    /**
+     * @brief Emitted when linkExistingContent() finishes.
+     * @param linked true if the server created the file, false if it still needs uploading.
+     */
+    void contentLinked(const QString &filePath, bool linked);
+
+    /**
+     * @brief Emitted with each batch of server file entries while listFiles() runs.
+     */
+    void filesListed(const QList<APIClient::RemoteFile> &files);
+
+    /**
+     * @brief Emitted after the last filesListed() batch of a listing.
+     * @param success false if the listing stopped part-way or failed.
+     * @param sequence Change sequence to pass to fetchChanges(), or -1 if the server has no journal.
+     */
+    void listingFinished(bool success, qint64 sequence);
+
+    /**
+     * @brief Emitted when fetchChanges() finishes.
+     * @param result Whether the changes can be applied, or a full listing is needed.
+     * @param changes The changes, oldest first; empty unless @p result is Ok.
+     * @param latest Sequence to pass to the next fetchChanges().
+     */
+    void changesFetched(APIClient::ChangesResult result, const QList<APIClient::FileChange> &changes,
+                        qint64 latest);
+
+    /**
+     * @brief Emitted when renameFile() finishes.
+     */
+    void renameFinished(const QString &oldName, const QString &newName, bool success);
+
+    /**
+     * @brief Emitted when deleteFile() finishes.
+     */
+    void deleteFinished(const QString &filename, bool success);
+
+    /**
+     * @brief Emitted with one result per file when deleteFiles() finishes.
+     */
+    void deleteBatchFinished(const std::vector<APIClient::BatchResult> &results);
+
+    /**
+     * @brief Emitted with one result per rename when renameFiles() finishes.
+     */
+    void renameBatchFinished(const std::vector<APIClient::BatchResult> &results);
+
+    /**
+     * @brief Emitted when a download finishes.
+     */
+    void downloadFinished(const QString &filename, const QString &destinationPath, bool success);
+
+    /**
+     * @brief Emitted periodically while an upload or download is in flight.
+     * @param name The local path (uploads), remote file name (downloads), or first
+     *             local path of an archive upload.
+     * @param transferred Bytes transferred so far.
+     * @param total Total bytes, or 0 if unknown.
+     */
+    void transferProgress(const QString &name, qint64 transferred, qint64 total);
+
+private:
+    struct Relay;
+
+    template <typename T, typename Work, typename Deliver>
+    QFuture<T> run(Work work, Deliver deliver);
+
+    QString m_serverUrl;
+    std::shared_ptr<Relay> m_relay;  ///< Hands results from worker threads back to this object
+};
+
+#endif // ASYNCAPICLIENT_H
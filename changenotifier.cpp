@@ -0,0 +1,263 @@
+#include "changenotifier.h"
+#include "apimetrics.h"
+#include "listingparser.h"
+#include "retrypolicy.h"
+#include <QDebug>
+#include <QMetaObject>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include "cpp-httplib/httplib.h"
+#include "json/json.hpp"
+
+namespace {
+
+/// Time allowed to open the stream.
+constexpr std::chrono::seconds kConnectTimeout(5);
+
+/// Default longest silence tolerated on an open stream; the server sends a heartbeat more often.
+constexpr std::chrono::seconds kHeartbeatTimeout(45);
+
+/**
+ * @brief Splits a text/event-stream body into events as it arrives.
+ *
+ * Handles "event" and "data" fields, multi-line data and comment lines; "id"
+ * and "retry" are ignored since reconnects resume from the last "seq" and use
+ * RetryPolicy. Lines may end in LF or CRLF.
+ */
+class EventStreamReader {
+public:
+    /**
+     * @brief Receives an event's type (empty for the default) and data; returning false ends the stream.
+     */
+    using EventCallback = std::function<bool(const std::string &event, const std::string &data)>;
+
+    explicit EventStreamReader(EventCallback onEvent) : m_onEvent(std::move(onEvent)) {}
+
+    /**
+     * @brief Consumes received bytes, dispatching every event they complete.
+     */
+    bool feed(const char *data, size_t length) {
+        m_line.append(data, length);
+        size_t start = 0;
+        for (size_t end = m_line.find('\n'); end != std::string::npos; end = m_line.find('\n', start)) {
+            size_t lineEnd = (end > start && m_line[end - 1] == '\r') ? end - 1 : end;
+            bool keepGoing = line(m_line.substr(start, lineEnd - start));
+            start = end + 1;
+            if (!keepGoing) {
+                return false;
+            }
+        }
+        m_line.erase(0, start);
+        return true;
+    }
+
+private:
+    /**
+     * @brief Handles one complete line; a blank line ends the current event.
+     */
+    bool line(const std::string &text) {
+        if (text.empty()) {
+            bool keepGoing = true;
+            if (m_hasData) {
+                keepGoing = m_onEvent(m_event, m_data);
+            }
+            m_event.clear();
+            m_data.clear();
+            m_hasData = false;
+            return keepGoing;
+        }
+        if (text[0] == ':') {
+            return true;  // heartbeat
+        }
+        size_t colon = text.find(':');
+        std::string field = text.substr(0, colon);
+        std::string value;
+        if (colon != std::string::npos) {
+            value = text.substr(colon + 1);
+            if (!value.empty() && value[0] == ' ') {
+                value.erase(0, 1);
+            }
+        }
+        if (field == "event") {
+            m_event = value;
+        } else if (field == "data") {
+            if (m_hasData) {
+                m_data += '\n';
+            }
+            m_data += value;
+            m_hasData = true;
+        }
+        return true;
+    }
+
+    EventCallback m_onEvent;
+    std::string m_line;    ///< Bytes after the last complete line
+    std::string m_event;
+    std::string m_data;
+    bool m_hasData = false;
+};
+
+} // namespace
+
+/**
+ * @brief Stores the server address; nothing is opened until start().
+ */
+ChangeNotifier::ChangeNotifier(const QString &serverUrl, QObject *parent)
+    : QObject(parent), m_host(serverUrl.toStdString()),
+      m_heartbeatTimeoutMs(std::chrono::milliseconds(kHeartbeatTimeout).count())
+{
+}
+
+/**
+ * @brief Stops the stream before the object goes away.
+ */
+ChangeNotifier::~ChangeNotifier()
+{
+    stop();
+}
+
+/**
+ * @brief Replaces any running stream with one starting after @p since.
+ */
+void ChangeNotifier::start(qint64 since)
+{
+    stop();
+    m_stopping = false;
+    const quint64 generation = m_generation.load();
+    m_thread = std::thread([this, since, generation]() { run(since, generation); });
+}
+
+/**
+ * @brief Interrupts the open request or backoff wait and joins the thread.
+ */
+void ChangeNotifier::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        ++m_generation;
+        if (m_client) {
+            m_client->stop();
+        }
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+/**
+ * @brief Stores the read timeout used by connections opened from now on.
+ */
+void ChangeNotifier::setHeartbeatTimeout(std::chrono::milliseconds timeout)
+{
+    m_heartbeatTimeoutMs = timeout.count();
+}
+
+/**
+ * @brief Keeps a stream open, reconnecting after drops, until stopped or told to resync.
+ */
+void ChangeNotifier::run(qint64 since, quint64 generation)
+{
+    const RetryPolicy policy = RetryPolicy::forOperation(RetryPolicy::Operation::Transfer);
+    int attempt = 0;
+    while (!m_stopping) {
+        httplib::Client cli(m_host);
+        cli.set_connection_timeout(kConnectTimeout);
+        cli.set_read_timeout(std::chrono::milliseconds(m_heartbeatTimeoutMs.load()));
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) {
+                break;
+            }
+            m_client = &cli;
+        }
+
+        int status = 0;
+        bool expired = false;
+        EventStreamReader reader([&](const std::string &event, const std::string &data) {
+            if (event == "expired") {
+                expired = true;
+                return false;
+            }
+            if (event.empty() || event == "changes") {
+                since = deliver(data, since, generation);
+            }
+            return !m_stopping.load();
+        });
+        const std::string path = "/api/events?since=" + std::to_string(since);
+        const httplib::Headers headers = { { "Accept", "text/event-stream" }, { "Cache-Control", "no-cache" } };
+        cli.Get(path, headers,
+            [&](const httplib::Response &response) {
+                status = response.status;
+                if (status == 200) {
+                    attempt = 0;
+                }
+                return status == 200 && !m_stopping;
+            },
+            [&](const char *data, size_t length) { return reader.feed(data, length); });
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_client = nullptr;
+        }
+        if (m_stopping) {
+            break;
+        }
+        if (expired || status == 410) {
+            QMetaObject::invokeMethod(this, [this, generation]() {
+                if (generation == m_generation)
+                    emit resyncRequired();
+            }, Qt::QueuedConnection);
+            break;
+        }
+        if (status == 404) {
+            qDebug() << "Server has no change event stream; use F5 to refresh";
+            break;
+        }
+
+        APIMetrics::instance().recordRetry("/api/events");
+        attempt = std::min(attempt + 1, policy.maxAttempts());
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait_for(lock, policy.delayFor(attempt), [this]() { return m_stopping.load(); });
+    }
+}
+
+/**
+ * @brief Parses a change set and queues changesPushed() unless it was already seen.
+ *
+ * The delivery time is taken on the steady clock when the event is complete and
+ * again when the handlers return, so it never mixes the server's clock with ours.
+ */
+qint64 ChangeNotifier::deliver(const std::string &data, qint64 since, quint64 generation)
+{
+    const auto receivedAt = std::chrono::steady_clock::now();
+    try {
+        auto event = nlohmann::json::parse(data);
+        qint64 sequence = event.at("seq").get<qint64>();
+        if (sequence <= since) {
+            return since;
+        }
+        QList<APIClient::FileChange> changes;
+        for (const auto &entry : event.value("changes", nlohmann::json::array())) {
+            APIClient::FileChange change;
+            if (ListingParser::changeFromJson(entry, change)) {
+                changes.append(std::move(change));
+            }
+        }
+        QMetaObject::invokeMethod(this, [this, generation, changes, sequence, receivedAt]() {
+            if (generation != m_generation)
+                return;
+            emit changesPushed(changes, sequence);
+            auto elapsed = std::chrono::steady_clock::now() - receivedAt;
+            APIMetrics::Endpoint &metrics = APIMetrics::instance().endpoint(kDeliveryEndpoint);
+            metrics.requests.fetch_add(1, std::memory_order_relaxed);
+            metrics.latency.record(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+        }, Qt::QueuedConnection);
+        return sequence;
+    } catch (...) {
+        return since;
+    }
+}
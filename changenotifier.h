@@ -0,0 +1,109 @@
+#ifndef CHANGENOTIFIER_H
+#define CHANGENOTIFIER_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "APIClient.h"
+
+namespace httplib {
+class Client;
+}
+
+/**
+ * @class ChangeNotifier
+ * @brief Listens to the server's change event stream so other devices' changes appear without F5.
+ *
+ * Holds a Server-Sent Events request to /api/events?since=<sequence> open on
+ * its own thread (a long-lived request would otherwise tie up a network pool
+ * thread and a pooled connection). The server sends one event per journal
+ * commit, in the same form as an /api/changes reply:
+ *
+ *     id: 42
+ *     event: changes
+ *     data: {"seq": 42, "changes": [...]}
+ *
+ * and "event: expired" when it can no longer replay from the requested
+ * sequence. Comment lines are sent as heartbeats; a stream that stays silent
+ * for longer than the heartbeat timeout is treated as dropped. Dropped streams
+ * are reopened from the last sequence received, with backoff from RetryPolicy.
+ *
+ * Signals are emitted on the thread that owns the notifier. The time from an
+ * event's arrival to the return of its changesPushed() handlers is recorded in
+ * APIMetrics under kDeliveryEndpoint, measured on the client's steady clock.
+ */
+class ChangeNotifier : public QObject
+{
+    Q_OBJECT
+public:
+    /// Metrics label for the time from an event's arrival to its changes being applied.
+    static constexpr const char *kDeliveryEndpoint = "/api/events (received to applied)";
+
+    /**
+     * @brief Constructs an idle notifier.
+     * @param serverUrl The base URL of the API server.
+     * @param parent Optional parent QObject.
+     */
+    explicit ChangeNotifier(const QString &serverUrl = "http://localhost:8080", QObject *parent = nullptr);
+
+    /**
+     * @brief Closes the stream and waits for its thread.
+     */
+    ~ChangeNotifier() override;
+
+    /**
+     * @brief Starts (or restarts) listening for changes after sequence @p since.
+     */
+    void start(qint64 since);
+
+    /**
+     * @brief Closes the stream; no signals are emitted afterwards.
+     */
+    void stop();
+
+    /**
+     * @brief Sets the longest silence tolerated on an open stream; takes effect on the next connection.
+     */
+    void setHeartbeatTimeout(std::chrono::milliseconds timeout);
+
+signals:
+    /**
+     * @brief Emitted for each committed change set.
+     * @param changes The changes, oldest first.
+     * @param sequence Journal sequence after these changes.
+     */
+    void changesPushed(const QList<APIClient::FileChange> &changes, qint64 sequence);
+
+    /**
+     * @brief Emitted when the server cannot replay from the requested sequence; relist everything.
+     */
+    void resyncRequired();
+
+private:
+    /**
+     * @brief Reconnect loop run on m_thread until stop().
+     */
+    void run(qint64 since, quint64 generation);
+
+    /**
+     * @brief Decodes one "changes" event and posts it to the owner's thread.
+     * @return The event's sequence, or @p since if it was stale or malformed.
+     */
+    qint64 deliver(const std::string &data, qint64 since, quint64 generation);
+
+    std::string m_host;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;          ///< Cuts a reconnect backoff short on stop()
+    httplib::Client *m_client = nullptr;     ///< Client of the open stream, guarded by m_mutex
+    std::atomic<bool> m_stopping{false};
+    std::atomic<quint64> m_generation{0};    ///< Bumped by stop() so events queued before it are dropped
+    std::atomic<qint64> m_heartbeatTimeoutMs; ///< Read timeout of each stream connection
+};
+
+#endif // CHANGENOTIFIER_H
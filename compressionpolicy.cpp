@@ -0,0 +1,134 @@
+#include "compressionpolicy.h"
+#include "filetypes.h"
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace {
+
+/// Bodies smaller than this are never compressed; the gzip header would eat the gain.
+constexpr qint64 kMinCompressSize = 1024;
+
+/// Bytes read from each of the three sample positions.
+constexpr qint64 kSampleSize = 16 * 1024;
+
+/// Samples above this many bits per byte are treated as already compressed.
+constexpr double kEntropyThreshold = 7.5;
+
+/**
+ * @brief Category members that are stored uncompressed and shrink well.
+ */
+const QStringList &rawFormats()
+{
+    static const QStringList exts = { ".svg", ".bmp", ".tiff", ".wav", ".aiff", ".txt", ".html", ".rtf",
+                                      ".csv", ".doc", ".ppt", ".json", ".xml", ".md", ".log" };
+    return exts;
+}
+
+} // namespace
+
+/**
+ * @brief Maps an extension to a decision using the shared category tables.
+ *
+ * Every categorised type that is not listed as a raw format already carries its
+ * own compression, so it is skipped.
+ */
+CompressionPolicy::Decision CompressionPolicy::classify(const QString &fileName)
+{
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix.isEmpty())
+        return Decision::Unknown;
+    QString ext = "." + suffix;
+    if (rawFormats().contains(ext))
+        return Decision::Compress;
+    if (FileTypes::isKnown(ext))
+        return Decision::Skip;
+    return Decision::Unknown;
+}
+
+/**
+ * @brief Applies classify() and falls back to an entropy sample for unknown types.
+ */
+bool CompressionPolicy::shouldCompressFile(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < kMinCompressSize)
+        return false;
+
+    switch (classify(filePath)) {
+    case Decision::Compress:
+        return true;
+    case Decision::Skip:
+        return false;
+    case Decision::Unknown:
+        break;
+    }
+    return sampleEntropy(file) < kEntropyThreshold;
+}
+
+/**
+ * @brief Builds a byte histogram over up to three samples and returns its entropy.
+ *
+ * The device position is restored afterwards.
+ */
+double CompressionPolicy::sampleEntropy(QIODevice &device)
+{
+    std::array<qint64, 256> counts{};
+    qint64 total = 0;
+    const qint64 startPos = device.pos();
+    const qint64 size = device.size();
+
+    QByteArray buffer(static_cast<int>(kSampleSize), '\0');
+    for (qint64 offset : { qint64(0), (size - kSampleSize) / 2, size - kSampleSize }) {
+        offset = std::max<qint64>(0, offset);
+        if (!device.seek(offset))
+            continue;
+        qint64 bytesRead = device.read(buffer.data(), kSampleSize);
+        for (qint64 i = 0; i < bytesRead; ++i)
+            counts[static_cast<unsigned char>(buffer[static_cast<int>(i)])]++;
+        total += std::max<qint64>(0, bytesRead);
+        // Small files are covered by the first sample.
+        if (size <= kSampleSize)
+            break;
+    }
+    device.seek(startPos);
+
+    if (total == 0)
+        return 8.0;
+    double entropy = 0.0;
+    for (qint64 count : counts) {
+        if (count == 0)
+            continue;
+        double p = double(count) / double(total);
+        entropy -= p * std::log2(p);
+    }
+    return entropy;
+}
+
+/**
+ * @brief Reads the per-thread CPU clock.
+ */
+qint64 CompressionPolicy::threadCpuMicros()
+{
+#ifdef Q_OS_WIN
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0;
+    auto toMicros = [](const FILETIME &t) {
+        return ((qint64(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 10;
+    };
+    return toMicros(kernel) + toMicros(user);
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
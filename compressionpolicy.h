@@ -0,0 +1,58 @@
+#ifndef COMPRESSIONPOLICY_H
+#define COMPRESSIONPOLICY_H
+
+#include <QString>
+
+class QIODevice;
+
+/**
+ * @struct CompressionReport
+ * @brief What compression did for one transfer.
+ */
+struct CompressionReport {
+    bool compressed = false; ///< Whether the body travelled compressed
+    qint64 rawBytes = 0;     ///< Uncompressed body size
+    qint64 wireBytes = 0;    ///< Body size on the wire
+    qint64 cpuMicros = 0;    ///< CPU time spent by the transferring thread
+
+    /**
+     * @brief Returns raw / wire bytes, or 1.0 when nothing was compressed.
+     */
+    double ratio() const { return (compressed && wireBytes > 0) ? double(rawBytes) / double(wireBytes) : 1.0; }
+};
+
+/**
+ * @class CompressionPolicy
+ * @brief Decides whether a file body is worth compressing on the wire.
+ *
+ * Known text-like and raw formats are compressed, formats that already carry
+ * their own compression (JPEG, MP4, FLAC, Office zip containers, ...) are sent
+ * as-is, and anything unrecognised is judged from a small entropy sample.
+ */
+class CompressionPolicy {
+public:
+    enum class Decision { Compress, Skip, Unknown };
+
+    /**
+     * @brief Classifies a file by its extension alone.
+     */
+    static Decision classify(const QString &fileName);
+
+    /**
+     * @brief Decides for a local file, sampling its contents when the extension is not conclusive.
+     */
+    static bool shouldCompressFile(const QString &filePath);
+
+    /**
+     * @brief Estimates Shannon entropy in bits per byte from samples at the start, middle and end.
+     * @return A value between 0 and 8, or 8 if nothing could be read.
+     */
+    static double sampleEntropy(QIODevice &device);
+
+    /**
+     * @brief Returns the CPU time consumed by the calling thread, in microseconds.
+     */
+    static qint64 threadCpuMicros();
+};
+
+#endif // COMPRESSIONPOLICY_H
@@ -0,0 +1,143 @@
+#include "connectionpool.h"
+#include "apimetrics.h"
+#include "cpp-httplib/httplib.h"
+
+/**
+ * @brief Wraps a client checked out of the pool.
+ */
+ConnectionPool::Lease::Lease(ConnectionPool &pool, std::string host, std::unique_ptr<httplib::Client> client)
+    : m_pool(&pool), m_host(std::move(host)), m_client(std::move(client))
+{
+}
+
+/**
+ * @brief Transfers ownership of the client to a new lease.
+ */
+ConnectionPool::Lease::Lease(Lease &&other) noexcept
+    : m_pool(other.m_pool), m_host(std::move(other.m_host)), m_client(std::move(other.m_client)),
+      m_discarded(other.m_discarded)
+{
+    other.m_pool = nullptr;
+}
+
+/**
+ * @brief Returns the client to the pool unless it was discarded.
+ */
+ConnectionPool::Lease::~Lease()
+{
+    if (m_pool && m_client && !m_discarded) {
+        m_pool->release(m_host, std::move(m_client));
+    }
+}
+
+/**
+ * @brief Closes the socket and marks the client so the destructor drops it.
+ */
+void ConnectionPool::Lease::discard()
+{
+    m_discarded = true;
+    if (m_client) {
+        m_client->stop();
+    }
+}
+
+/**
+ * @brief Returns the process-wide pool.
+ */
+ConnectionPool &ConnectionPool::instance()
+{
+    static ConnectionPool pool;
+    return pool;
+}
+
+/**
+ * @brief Checks out the most recently used healthy client, or creates one.
+ *
+ * Stale entries found along the way are closed.
+ */
+ConnectionPool::Lease ConnectionPool::acquire(const std::string &host)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &idle = m_idle[host];
+        auto now = std::chrono::steady_clock::now();
+        while (!idle.empty()) {
+            IdleClient entry = std::move(idle.back());
+            idle.pop_back();
+            if (isHealthy(entry, now)) {
+                APIMetrics::instance().recordConnection(true);
+                return Lease(*this, host, std::move(entry.client));
+            }
+        }
+    }
+
+    auto client = std::make_unique<httplib::Client>(host);
+    client->set_keep_alive(true);
+    APIMetrics::instance().recordConnection(false);
+    return Lease(*this, host, std::move(client));
+}
+
+/**
+ * @brief Sets the idle connection cap per host, closing any surplus.
+ */
+void ConnectionPool::setMaxIdlePerHost(size_t count)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxIdlePerHost = count;
+    for (auto &entry : m_idle) {
+        while (entry.second.size() > m_maxIdlePerHost) {
+            entry.second.pop_front();
+        }
+    }
+}
+
+/**
+ * @brief Sets how long an idle connection is trusted to still be open.
+ */
+void ConnectionPool::setIdleTimeout(std::chrono::milliseconds timeout)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idleTimeout = timeout;
+}
+
+/**
+ * @brief Closes all idle connections.
+ */
+void ConnectionPool::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idle.clear();
+}
+
+/**
+ * @brief Puts a client back on the idle list, evicting the oldest if over the cap.
+ */
+void ConnectionPool::release(const std::string &host, std::unique_ptr<httplib::Client> client)
+{
+    // A client whose socket was closed (error, cancel, or "Connection: close")
+    // has nothing worth keeping.
+    if (!client->is_socket_open()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &idle = m_idle[host];
+    idle.push_back({ std::move(client), std::chrono::steady_clock::now() });
+    while (idle.size() > m_maxIdlePerHost) {
+        idle.pop_front();
+    }
+}
+
+/**
+ * @brief Health check for an idle client: still connected, not idle for too long, and not
+ *        closed by the server in the meantime.
+ *
+ * The last check peeks at the socket without blocking. A server that closed its end
+ * leaves the socket readable with nothing to read, and handing out that client would
+ * cost the next request a failed attempt.
+ */
+bool ConnectionPool::isHealthy(const IdleClient &idle, std::chrono::steady_clock::time_point now) const
+{
+    return idle.client->is_socket_open() && now - idle.idleSince < m_idleTimeout
+        && httplib::detail::is_socket_alive(idle.client->socket());
+}
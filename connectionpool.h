@@ -0,0 +1,102 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace httplib {
+class Client;
+}
+
+/**
+ * @class ConnectionPool
+ * @brief Process-wide pool of keep-alive HTTP clients shared by every APIClient.
+ *
+ * Reusing an idle client keeps its TCP connection open between requests, so bulk
+ * operations pay for one handshake instead of one per call. Idle clients are
+ * capped per host and dropped once they have been idle longer than the server is
+ * likely to keep the connection open.
+ */
+class ConnectionPool {
+public:
+    /**
+     * @class Lease
+     * @brief Exclusive use of one pooled client; returns it to the pool when destroyed.
+     */
+    class Lease {
+    public:
+        Lease(Lease &&other) noexcept;
+        Lease &operator=(Lease &&other) = delete;
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        ~Lease();
+
+        httplib::Client &client() const { return *m_client; }
+
+        /**
+         * @brief Closes the connection now and keeps the client out of the pool.
+         *
+         * The client stays usable for the rest of the lease; its next request
+         * opens a fresh connection.
+         */
+        void discard();
+
+    private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool &pool, std::string host, std::unique_ptr<httplib::Client> client);
+
+        ConnectionPool *m_pool;
+        std::string m_host;
+        std::unique_ptr<httplib::Client> m_client;
+        bool m_discarded = false;  ///< Closed after a failure; not returned to the pool
+    };
+
+    /**
+     * @brief Returns the shared pool instance.
+     */
+    static ConnectionPool &instance();
+
+    /**
+     * @brief Hands out an idle client for the host, or creates a new keep-alive client.
+     * @param host The server URL, e.g. "http://localhost:8080".
+     */
+    Lease acquire(const std::string &host);
+
+    /**
+     * @brief Sets how many idle connections are kept per host.
+     */
+    void setMaxIdlePerHost(size_t count);
+
+    /**
+     * @brief Sets how long a connection may sit idle before it is considered stale.
+     */
+    void setIdleTimeout(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Closes every idle connection.
+     */
+    void clear();
+
+private:
+    struct IdleClient {
+        std::unique_ptr<httplib::Client> client;
+        std::chrono::steady_clock::time_point idleSince;
+    };
+
+    ConnectionPool() = default;
+
+    void release(const std::string &host, std::unique_ptr<httplib::Client> client);
+    bool isHealthy(const IdleClient &idle, std::chrono::steady_clock::time_point now) const;
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, std::deque<IdleClient>> m_idle;
+    size_t m_maxIdlePerHost = 4;
+    // httplib servers close keep-alive connections after 5 seconds by default.
+    std::chrono::milliseconds m_idleTimeout{4000};
+};
+
+#endif // CONNECTIONPOOL_H
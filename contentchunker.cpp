@@ -0,0 +1,140 @@
+#include "contentchunker.h"
+#include <QCryptographicHash>
+#include <QIODevice>
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Builds the 256-entry gear table from a fixed seed with splitmix64.
+ *
+ * The table only has to be random-looking and identical across runs; the
+ * server never needs it because chunks are identified by their hashes.
+ */
+std::array<uint64_t, 256> makeGearTable() {
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0x4c6f63616c447276ULL;
+    for (auto &entry : table) {
+        state += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        entry = z ^ (z >> 31);
+    }
+    return table;
+}
+
+const std::array<uint64_t, 256> kGear = makeGearTable();
+
+/**
+ * @brief Returns a mask with the top @p bits bits set.
+ *
+ * The gear hash shifts left, so its high bits depend on the most bytes and give
+ * the best-distributed cut points.
+ */
+uint64_t topBitsMask(int bits) {
+    return bits <= 0 ? 0 : ~uint64_t(0) << (64 - bits);
+}
+
+int log2Floor(size_t value) {
+    int bits = 0;
+    while (value > 1) {
+        value >>= 1;
+        bits++;
+    }
+    return bits;
+}
+
+} // namespace
+
+/**
+ * @brief Creates a chunker; the two masks implement FastCDC normalization level 2.
+ */
+ContentChunker::ContentChunker(size_t minSize, size_t avgSize, size_t maxSize)
+    : m_minSize(minSize), m_avgSize(avgSize), m_maxSize(maxSize)
+{
+    int bits = log2Floor(avgSize);
+    m_maskSmall = topBitsMask(bits + 2);
+    m_maskLarge = topBitsMask(bits - 2);
+}
+
+/**
+ * @brief Returns the FastCDC cut point for the data at the start of the buffer.
+ */
+size_t ContentChunker::cut(const uint8_t *data, size_t length) const
+{
+    if (length <= m_minSize) {
+        return length;
+    }
+    if (length > m_maxSize) {
+        length = m_maxSize;
+    }
+    size_t normal = std::min(m_avgSize, length);
+
+    uint64_t fingerprint = 0;
+    size_t i = m_minSize;
+    for (; i < normal; ++i) {
+        fingerprint = (fingerprint << 1) + kGear[data[i]];
+        if (!(fingerprint & m_maskSmall)) {
+            return i;
+        }
+    }
+    for (; i < length; ++i) {
+        fingerprint = (fingerprint << 1) + kGear[data[i]];
+        if (!(fingerprint & m_maskLarge)) {
+            return i;
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief Streams the device through a sliding buffer, cutting and hashing each chunk.
+ */
+bool ContentChunker::chunk(QIODevice &device, std::vector<Chunk> &chunks,
+                           const std::function<bool(qint64 chunked)> &progress) const
+{
+    std::vector<uint8_t> buffer(2 * m_maxSize);
+    size_t begin = 0;
+    size_t end = 0;
+    qint64 offset = 0;
+    bool atEnd = false;
+
+    for (;;) {
+        // Keep at least one maximum-size chunk buffered so cut points do not
+        // depend on read boundaries.
+        if (!atEnd && end - begin < m_maxSize) {
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+            while (!atEnd && end < buffer.size()) {
+                qint64 bytesRead = device.read(reinterpret_cast<char *>(buffer.data() + end),
+                                               static_cast<qint64>(buffer.size() - end));
+                if (bytesRead < 0) {
+                    return false;  // A read error must not pass for the end of the file.
+                } else if (bytesRead == 0) {
+                    atEnd = true;
+                } else {
+                    end += static_cast<size_t>(bytesRead);
+                }
+            }
+        }
+        if (begin == end) {
+            break;
+        }
+
+        size_t length = cut(buffer.data() + begin, end - begin);
+        QByteArray hash = QCryptographicHash::hash(
+            QByteArray::fromRawData(reinterpret_cast<const char *>(buffer.data() + begin), static_cast<int>(length)),
+            QCryptographicHash::Sha256).toHex();
+        chunks.push_back({ offset, static_cast<qint64>(length), hash });
+        offset += static_cast<qint64>(length);
+        begin += length;
+        if (progress && !progress(offset)) {
+            return false;
+        }
+    }
+    return true;
+}
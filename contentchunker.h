@@ -0,0 +1,70 @@
+#ifndef CONTENTCHUNKER_H
+#define CONTENTCHUNKER_H
+
+#include <QByteArray>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class QIODevice;
+
+/**
+ * @class ContentChunker
+ * @brief Splits data into content-defined chunks using the FastCDC algorithm.
+ *
+ * Cut points are chosen by a rolling gear hash over the data itself, so an
+ * insertion or deletion only changes the chunks around the edit and the rest of
+ * a file still produces identical chunks. Normalized chunking keeps chunk sizes
+ * close to the average between the configured minimum and maximum.
+ */
+class ContentChunker {
+public:
+    /**
+     * @brief One chunk of a file.
+     */
+    struct Chunk {
+        qint64 offset;    ///< Byte offset of the chunk in the source
+        qint64 length;    ///< Chunk length in bytes
+        QByteArray hash;  ///< Hex-encoded SHA-256 of the chunk contents
+    };
+
+    /**
+     * @brief Creates a chunker with the given size bounds.
+     * @param minSize Smallest chunk produced except for the final one.
+     * @param avgSize Target average chunk size; must be a power of two.
+     * @param maxSize Largest chunk produced.
+     */
+    explicit ContentChunker(size_t minSize = 16 * 1024, size_t avgSize = 64 * 1024, size_t maxSize = 256 * 1024);
+
+    /**
+     * @brief Finds the length of the first chunk in a buffer.
+     * @param data Start of the unchunked data.
+     * @param length Number of bytes available.
+     * @return The chunk length, never more than @p length or the maximum chunk size.
+     */
+    size_t cut(const uint8_t *data, size_t length) const;
+
+    /**
+     * @brief Reads a device to the end and collects its chunks with their hashes.
+     *
+     * Memory use is bounded by twice the maximum chunk size.
+     * @param device The data to chunk, read from its current position.
+     * @param chunks Receives the chunks in order.
+     * @param progress Optional callback after each chunk; returning false abandons chunking.
+     * @return false if the device failed to read or chunking was abandoned; @p chunks is then incomplete.
+     */
+    bool chunk(QIODevice &device, std::vector<Chunk> &chunks,
+               const std::function<bool(qint64 chunked)> &progress = nullptr) const;
+
+    size_t maxSize() const { return m_maxSize; }
+
+private:
+    size_t m_minSize;
+    size_t m_avgSize;
+    size_t m_maxSize;
+    uint64_t m_maskSmall;  ///< Stricter mask used before the average size is reached
+    uint64_t m_maskLarge;  ///< Looser mask used after the average size is reached
+};
+
+#endif // CONTENTCHUNKER_H
@@ -0,0 +1,229 @@
+#include "deltaencoder.h"
+#include <QCryptographicHash>
+#include <QIODevice>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// Literal runs are split so the receiver never has to buffer more than this.
+constexpr qint64 kMaxLiteral = 1024 * 1024;
+
+/// Bounds for the automatically chosen block size.
+constexpr size_t kMinBlockSize = 2 * 1024;
+constexpr size_t kMaxBlockSize = 128 * 1024;
+
+/// How often, in scanned bytes, the progress callback is invoked.
+constexpr qint64 kProgressInterval = 1024 * 1024;
+
+/**
+ * @brief Appends little-endian integers and raw bytes to a device, remembering failures.
+ */
+class DeltaWriter {
+public:
+    explicit DeltaWriter(QIODevice &out) : m_out(out) {}
+
+    void bytes(const void *data, qint64 length) {
+        if (m_ok && m_out.write(static_cast<const char *>(data), length) != length) {
+            m_ok = false;
+        }
+        m_written += length;
+    }
+
+    void u8(uint8_t value) { bytes(&value, 1); }
+
+    void u32(uint32_t value) {
+        uint8_t raw[4];
+        for (int i = 0; i < 4; ++i) {
+            raw[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+        bytes(raw, 4);
+    }
+
+    void u64(uint64_t value) {
+        uint8_t raw[8];
+        for (int i = 0; i < 8; ++i) {
+            raw[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+        bytes(raw, 8);
+    }
+
+    bool ok() const { return m_ok; }
+    qint64 written() const { return m_written; }
+
+private:
+    QIODevice &m_out;
+    bool m_ok = true;
+    qint64 m_written = 0;
+};
+
+} // namespace
+
+/**
+ * @brief Stores the signature and indexes it by weak checksum.
+ */
+DeltaEncoder::DeltaEncoder(size_t blockSize, std::vector<Block> blocks)
+    : m_blockSize(blockSize), m_blocks(std::move(blocks))
+{
+    m_index.reserve(m_blocks.size());
+    for (size_t i = 0; i < m_blocks.size(); ++i) {
+        m_index[m_blocks[i].weak].push_back(static_cast<uint32_t>(i));
+    }
+}
+
+/**
+ * @brief rsync's checksum: a = sum of bytes, b = sum of running a, each mod 2^16.
+ */
+uint32_t DeltaEncoder::weakChecksum(const uint8_t *data, size_t length)
+{
+    uint32_t a = 0;
+    uint32_t b = 0;
+    for (size_t i = 0; i < length; ++i) {
+        a += data[i];
+        b += static_cast<uint32_t>(length - i) * data[i];
+    }
+    return (a & 0xFFFF) | ((b & 0xFFFF) << 16);
+}
+
+/**
+ * @brief Picks a power of two near the square root of the file size.
+ */
+size_t DeltaEncoder::blockSizeForFile(qint64 size)
+{
+    size_t target = static_cast<size_t>(std::sqrt(static_cast<double>(std::max<qint64>(size, 0))));
+    size_t blockSize = kMinBlockSize;
+    while (blockSize < target && blockSize < kMaxBlockSize) {
+        blockSize <<= 1;
+    }
+    return blockSize;
+}
+
+/**
+ * @brief Scans the new file with the rolling checksum and emits literals and block copies.
+ *
+ * Weak matches are confirmed with MD5 before being used. Runs of consecutive
+ * matching blocks collapse into a single copy operation.
+ */
+bool DeltaEncoder::encode(const uint8_t *data, qint64 size, QIODevice &out,
+                          const std::function<bool(qint64 scanned, qint64 total)> &progress,
+                          Stats *stats) const
+{
+    const qint64 blockSize = static_cast<qint64>(m_blockSize);
+    DeltaWriter writer(out);
+    Stats result;
+
+    writer.bytes("LDDELTA1", 8);
+    writer.u32(static_cast<uint32_t>(m_blockSize));
+    writer.u64(static_cast<uint64_t>(size));
+
+    qint64 copyStart = -1;
+    qint64 copyCount = 0;
+    auto flushCopy = [&]() {
+        if (copyCount > 0) {
+            writer.u8('C');
+            writer.u32(static_cast<uint32_t>(copyStart));
+            writer.u32(static_cast<uint32_t>(copyCount));
+            copyCount = 0;
+        }
+    };
+    auto flushLiteral = [&](qint64 begin, qint64 end) {
+        if (begin < end) {
+            flushCopy();
+        }
+        while (begin < end) {
+            qint64 length = std::min(kMaxLiteral, end - begin);
+            writer.u8('L');
+            writer.u32(static_cast<uint32_t>(length));
+            writer.bytes(data + begin, length);
+            result.literalBytes += length;
+            begin += length;
+        }
+    };
+
+    qint64 pos = 0;
+    qint64 literalStart = 0;
+    qint64 nextProgress = kProgressInterval;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    bool primed = false;
+
+    while (pos + blockSize <= size && !m_index.empty()) {
+        if (!primed) {
+            uint32_t sum = weakChecksum(data + pos, m_blockSize);
+            a = sum & 0xFFFF;
+            b = sum >> 16;
+            primed = true;
+        }
+
+        auto candidates = m_index.find(a | (b << 16));
+        if (candidates != m_index.end()) {
+            QByteArray strong = QCryptographicHash::hash(
+                QByteArray::fromRawData(reinterpret_cast<const char *>(data + pos), static_cast<int>(blockSize)),
+                QCryptographicHash::Md5);
+            // Prefer the block that continues the current copy run.
+            qint64 match = -1;
+            for (uint32_t index : candidates->second) {
+                if (m_blocks[index].strong == strong) {
+                    match = index;
+                    if (copyCount > 0 && index == copyStart + copyCount) {
+                        break;
+                    }
+                }
+            }
+            if (match >= 0) {
+                flushLiteral(literalStart, pos);
+                if (copyCount > 0 && match == copyStart + copyCount) {
+                    copyCount++;
+                } else {
+                    flushCopy();
+                    copyStart = match;
+                    copyCount = 1;
+                }
+                result.matchedBytes += blockSize;
+                pos += blockSize;
+                literalStart = pos;
+                primed = false;
+                continue;
+            }
+        }
+
+        if (pos + blockSize < size) {
+            uint32_t outgoing = data[pos];
+            uint32_t incoming = data[pos + blockSize];
+            a = (a - outgoing + incoming) & 0xFFFF;
+            b = (b - static_cast<uint32_t>(m_blockSize) * outgoing + a) & 0xFFFF;
+        }
+        pos++;
+
+        if (pos >= nextProgress) {
+            nextProgress = pos + kProgressInterval;
+            if (progress && !progress(pos, size)) {
+                return false;
+            }
+            if (!writer.ok()) {
+                return false;
+            }
+        }
+    }
+    flushLiteral(literalStart, size);
+    flushCopy();
+
+    QCryptographicHash fileHash(QCryptographicHash::Md5);
+    for (qint64 offset = 0; offset < size; offset += kMaxLiteral) {
+        qint64 length = std::min(kMaxLiteral, size - offset);
+        fileHash.addData(QByteArray::fromRawData(reinterpret_cast<const char *>(data + offset),
+                                                 static_cast<int>(length)));
+    }
+    QByteArray digest = fileHash.result();
+    writer.u8('E');
+    writer.bytes(digest.constData(), digest.size());
+
+    if (progress) {
+        progress(size, size);
+    }
+    result.deltaBytes = writer.written();
+    if (stats) {
+        *stats = result;
+    }
+    return writer.ok();
+}
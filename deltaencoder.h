@@ -0,0 +1,83 @@
+#ifndef DELTAENCODER_H
+#define DELTAENCODER_H
+
+#include <QByteArray>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+class QIODevice;
+
+/**
+ * @class DeltaEncoder
+ * @brief Encodes a new version of a file against the block signature of an old one.
+ *
+ * This is the sender half of the rsync algorithm: every block of the old file is
+ * described by a cheap rolling checksum and an MD5 digest, the new file is scanned
+ * byte by byte with the rolling checksum, and each match becomes a block reference
+ * while everything else is sent as literal data.
+ *
+ * Delta stream (all integers little-endian):
+ *   "LDDELTA1" u32 blockSize u64 targetSize
+ *   'L' u32 length <bytes>     literal data
+ *   'C' u32 firstBlock u32 n   copy n consecutive blocks of the old file
+ *   'E' <16-byte MD5>          end; MD5 of the complete new file
+ */
+class DeltaEncoder {
+public:
+    /**
+     * @brief Signature of one block of the old file.
+     */
+    struct Block {
+        uint32_t weak;     ///< Rolling checksum of the block
+        QByteArray strong; ///< Raw 16-byte MD5 of the block
+    };
+
+    /**
+     * @brief Counts gathered while encoding.
+     */
+    struct Stats {
+        qint64 literalBytes = 0; ///< New data that had to be sent verbatim
+        qint64 matchedBytes = 0; ///< Data replaced by block references
+        qint64 deltaBytes = 0;   ///< Size of the encoded delta stream
+    };
+
+    /**
+     * @brief Creates an encoder for the given old-file signature.
+     * @param blockSize Block size the signature was computed with.
+     * @param blocks Signatures of the old file's full blocks, in order.
+     */
+    DeltaEncoder(size_t blockSize, std::vector<Block> blocks);
+
+    /**
+     * @brief Computes the rsync weak checksum of a buffer.
+     */
+    static uint32_t weakChecksum(const uint8_t *data, size_t length);
+
+    /**
+     * @brief Returns the block size to request for a file of the given size (about its square root).
+     */
+    static size_t blockSizeForFile(qint64 size);
+
+    /**
+     * @brief Writes the delta that turns the old file into @p data.
+     * @param data The complete new file contents.
+     * @param size Length of @p data.
+     * @param out Device the delta stream is written to.
+     * @param progress Optional callback with bytes scanned; returning false stops encoding.
+     * @param stats Optional output for encoding statistics.
+     * @return true if the whole delta was written; false on a write error or cancellation.
+     */
+    bool encode(const uint8_t *data, qint64 size, QIODevice &out,
+                const std::function<bool(qint64 scanned, qint64 total)> &progress = nullptr,
+                Stats *stats = nullptr) const;
+
+private:
+    size_t m_blockSize;
+    std::vector<Block> m_blocks;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_index; ///< Weak checksum -> block indices
+};
+
+#endif // DELTAENCODER_H
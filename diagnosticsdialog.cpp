@@ -0,0 +1,150 @@
+#include "diagnosticsdialog.h"
+#include "apimetrics.h"
+#include <QFile>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+enum Column {
+    EndpointColumn, RequestsColumn, ErrorsColumn, RetriesColumn,
+    P50Column, P95Column, P99Column, MaxColumn, BytesInColumn, BytesOutColumn, ColumnCount
+};
+
+QString formatBytes(double bytes)
+{
+    const char *units[] = { "B", "KB", "MB", "GB", "TB" };
+    int unit = 0;
+    while (bytes >= 1024.0 && unit < 4) {
+        bytes /= 1024.0;
+        unit++;
+    }
+    return QString::number(bytes, 'f', unit == 0 ? 0 : 1) + " " + units[unit];
+}
+
+QString formatMicros(double micros)
+{
+    if (micros >= 1000000.0)
+        return QString::number(micros / 1000000.0, 'f', 2) + " s";
+    if (micros >= 1000.0)
+        return QString::number(micros / 1000.0, 'f', 1) + " ms";
+    return QString::number(micros, 'f', 0) + " us";
+}
+
+} // namespace
+
+/**
+ * @brief Builds the table and buttons and loads the current counters.
+ */
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Diagnostics");
+    resize(900, 400);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    m_table = new QTableWidget(0, ColumnCount, this);
+    m_table->setHorizontalHeaderLabels({ "Endpoint", "Requests", "Errors", "Retries", "p50", "p95", "p99",
+                                         "Max", "Bytes in", "Bytes out" });
+    m_table->horizontalHeader()->setSectionResizeMode(EndpointColumn, QHeaderView::Stretch);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    layout->addWidget(m_table);
+
+    m_connections = new QLabel(this);
+    layout->addWidget(m_connections);
+
+    QHBoxLayout *buttons = new QHBoxLayout();
+    QPushButton *refreshBtn = new QPushButton("Refresh", this);
+    QPushButton *exportBtn = new QPushButton("Export JSON", this);
+    QPushButton *resetBtn = new QPushButton("Reset", this);
+    QPushButton *closeBtn = new QPushButton("Close", this);
+    buttons->addStretch();
+    buttons->addWidget(refreshBtn);
+    buttons->addWidget(exportBtn);
+    buttons->addWidget(resetBtn);
+    buttons->addWidget(closeBtn);
+    layout->addLayout(buttons);
+    setLayout(layout);
+
+    connect(refreshBtn, &QPushButton::clicked, this, &DiagnosticsDialog::refresh);
+    connect(exportBtn, &QPushButton::clicked, this, &DiagnosticsDialog::onExportRequested);
+    connect(resetBtn, &QPushButton::clicked, this, &DiagnosticsDialog::onResetRequested);
+    connect(closeBtn, &QPushButton::clicked, this, &QDialog::accept);
+
+    refresh();
+}
+
+/**
+ * @brief Rebuilds the rows from a JSON snapshot, so the table never holds live counters.
+ */
+void DiagnosticsDialog::refresh()
+{
+    nlohmann::json snapshot = APIMetrics::instance().toJson();
+    const nlohmann::json &endpoints = snapshot["endpoints"];
+
+    m_table->setRowCount(0);
+    for (auto it = endpoints.begin(); it != endpoints.end(); ++it) {
+        const nlohmann::json &e = it.value();
+        const nlohmann::json &latency = e["latencyUs"];
+        int row = m_table->rowCount();
+        m_table->insertRow(row);
+        auto set = [this, row](int column, const QString &text) {
+            m_table->setItem(row, column, new QTableWidgetItem(text));
+        };
+        set(EndpointColumn, QString::fromStdString(it.key()));
+        set(RequestsColumn, QString::number(e["requests"].get<quint64>()));
+        set(ErrorsColumn, QString::number(e["errors"].get<quint64>()));
+        set(RetriesColumn, QString::number(e["retries"].get<quint64>()));
+        set(P50Column, formatMicros(latency["p50"].get<double>()));
+        set(P95Column, formatMicros(latency["p95"].get<double>()));
+        set(P99Column, formatMicros(latency["p99"].get<double>()));
+        set(MaxColumn, formatMicros(latency["max"].get<double>()));
+        set(BytesInColumn, formatBytes(e["bytesIn"].get<double>()));
+        set(BytesOutColumn, formatBytes(e["bytesOut"].get<double>()));
+    }
+
+    const nlohmann::json &connections = snapshot["connections"];
+    quint64 reused = connections["reused"].get<quint64>();
+    quint64 opened = connections["opened"].get<quint64>();
+    quint64 total = reused + opened;
+    m_connections->setText(QString("Connections: %1 reused, %2 opened (%3% reuse)")
+                               .arg(reused)
+                               .arg(opened)
+                               .arg(total ? reused * 100 / total : 0));
+}
+
+/**
+ * @brief Writes the current counters to a JSON file chosen by the user.
+ */
+void DiagnosticsDialog::onExportRequested()
+{
+    QString path = QFileDialog::getSaveFileName(this, "Export Diagnostics", "localdrive-metrics.json",
+                                                "JSON Files (*.json)");
+    if (path.isEmpty())
+        return;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QMessageBox::warning(this, "Export Failed", "Could not write " + path);
+        return;
+    }
+    std::string text = APIMetrics::instance().toJson().dump(2);
+    file.write(text.data(), static_cast<qint64>(text.size()));
+}
+
+/**
+ * @brief Zeroes every counter and refreshes the table.
+ */
+void DiagnosticsDialog::onResetRequested()
+{
+    APIMetrics::instance().reset();
+    refresh();
+}
@@ -0,0 +1,41 @@
+#ifndef DIAGNOSTICSDIALOG_H
+#define DIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+
+class QLabel;
+class QTableWidget;
+
+/**
+ * @class DiagnosticsDialog
+ * @brief Shows the per-endpoint request statistics collected by APIMetrics.
+ *
+ * Lists request, error and retry counts, latency percentiles and bytes moved
+ * for every endpoint, plus connection reuse, and can export the lot as JSON.
+ */
+class DiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the dialog and fills it with the current counters.
+     * @param parent Optional parent widget.
+     */
+    explicit DiagnosticsDialog(QWidget *parent = nullptr);
+
+public slots:
+    /**
+     * @brief Reloads the table from APIMetrics.
+     */
+    void refresh();
+
+private slots:
+    void onExportRequested();
+    void onResetRequested();
+
+private:
+    QTableWidget *m_table;       ///< One row per endpoint
+    QLabel *m_connections;       ///< Connection reuse summary
+};
+
+#endif // DIAGNOSTICSDIALOG_H
@@ -0,0 +1,231 @@
+#include "downloadsink.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+
+/// Size of each of the two write-behind buffers.
+constexpr size_t kBufferSize = 1024 * 1024;
+
+/// Buffer alignment; page-aligned buffers let the kernel copy whole pages.
+constexpr size_t kBufferAlignment = 4096;
+
+} // namespace
+
+/**
+ * @brief Allocates the two aligned buffers; the file is opened by open().
+ */
+DownloadSink::DownloadSink(const QString &path)
+    : m_file(path)
+{
+    for (Buffer &buffer : m_buffers) {
+        buffer.data = static_cast<char *>(::operator new(kBufferSize, std::align_val_t(kBufferAlignment)));
+    }
+}
+
+/**
+ * @brief Stops the writer, closing the file, and frees the buffers.
+ */
+DownloadSink::~DownloadSink()
+{
+    close();
+    for (Buffer &buffer : m_buffers) {
+        ::operator delete(buffer.data, std::align_val_t(kBufferAlignment));
+    }
+}
+
+/**
+ * @brief Opens the file unbuffered, so written() reflects what the OS has, and starts the writer.
+ */
+bool DownloadSink::open()
+{
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        return false;
+    }
+    m_stop = false;
+    m_failed = false;
+    m_written = m_file.pos();
+    m_writer = std::thread(&DownloadSink::writerLoop, this);
+    return true;
+}
+
+/**
+ * @brief Drains pending writes and returns the file size.
+ */
+qint64 DownloadSink::size()
+{
+    flush();
+    return m_file.size();
+}
+
+/**
+ * @brief Drains pending writes, then truncates and repositions while the writer is idle.
+ */
+bool DownloadSink::reset(qint64 offset)
+{
+    flush();
+    if (!m_file.resize(offset) || !m_file.seek(offset)) {
+        m_failed = true;
+        return false;
+    }
+    m_written = offset;
+    m_failed = false;
+    return true;
+}
+
+/**
+ * @brief Reserves blocks beyond the current end with FALLOC_FL_KEEP_SIZE (Linux only).
+ *
+ * Keeping the length unchanged matters: resume logic treats the file length as
+ * the amount of data actually received.
+ */
+void DownloadSink::preallocate(qint64 totalSize)
+{
+#ifdef Q_OS_LINUX
+    qint64 current = written();
+    if (totalSize > current) {
+        flush();
+        ::fallocate(m_file.handle(), FALLOC_FL_KEEP_SIZE, current, totalSize - current);
+    }
+#else
+    Q_UNUSED(totalSize);
+#endif
+}
+
+/**
+ * @brief Copies data into the current buffer, handing off each buffer as it fills.
+ */
+bool DownloadSink::write(const char *data, size_t length)
+{
+    while (length > 0) {
+        if (m_failed) {
+            return false;
+        }
+        Buffer &buffer = m_buffers[m_filling];
+        size_t n = std::min(length, kBufferSize - buffer.used);
+        std::memcpy(buffer.data + buffer.used, data, n);
+        buffer.used += n;
+        data += n;
+        length -= n;
+        if (buffer.used == kBufferSize) {
+            submit();
+        }
+    }
+    return !m_failed;
+}
+
+/**
+ * @brief Hands the filling buffer to the writer (waiting for the other one to finish) and swaps.
+ */
+void DownloadSink::submit()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    waitIdle(lock);
+    m_pendingIndex = m_filling;
+    m_filling ^= 1;
+    m_buffers[m_filling].used = 0;
+    m_cond.notify_all();
+}
+
+/**
+ * @brief Blocks until the writer has no buffer in flight.
+ */
+void DownloadSink::waitIdle(std::unique_lock<std::mutex> &lock)
+{
+    m_cond.wait(lock, [this]() { return m_pendingIndex < 0; });
+}
+
+/**
+ * @brief Submits any partial buffer and waits for the writer to finish it.
+ */
+bool DownloadSink::flush()
+{
+    if (!m_writer.joinable()) {
+        return !m_failed;
+    }
+    if (m_buffers[m_filling].used > 0) {
+        submit();
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    waitIdle(lock);
+    return !m_failed;
+}
+
+/**
+ * @brief Writer thread: writes each submitted buffer and marks itself idle again.
+ */
+void DownloadSink::writerLoop()
+{
+    for (;;) {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() { return m_stop || m_pendingIndex >= 0; });
+            if (m_pendingIndex < 0) {
+                return;
+            }
+            index = m_pendingIndex;
+        }
+
+        const Buffer &buffer = m_buffers[index];
+        qint64 length = static_cast<qint64>(buffer.used);
+        if (!m_failed && m_file.write(buffer.data, length) == length) {
+            m_written += length;
+        } else {
+            m_failed = true;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingIndex = -1;
+        m_cond.notify_all();
+    }
+}
+
+/**
+ * @brief Lets the writer finish its current buffer and joins it.
+ */
+void DownloadSink::stopWriter()
+{
+    if (!m_writer.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_cond.notify_all();
+    }
+    m_writer.join();
+}
+
+/**
+ * @brief Flushes, issues a single fsync, and closes the file.
+ */
+bool DownloadSink::finish()
+{
+    bool ok = flush();
+    stopWriter();
+#ifdef Q_OS_UNIX
+    if (ok && m_file.isOpen()) {
+        ok = (::fsync(m_file.handle()) == 0);
+    }
+#endif
+    m_file.close();
+    return ok;
+}
+
+/**
+ * @brief Flushes and closes the file, leaving durability to the OS.
+ */
+void DownloadSink::close()
+{
+    flush();
+    stopWriter();
+    m_file.close();
+}
@@ -0,0 +1,106 @@
+#ifndef DOWNLOADSINK_H
+#define DOWNLOADSINK_H
+
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/**
+ * @class DownloadSink
+ * @brief Write-behind file writer that overlaps network receive with disk writes.
+ *
+ * Incoming data is copied into one of two page-aligned buffers. When a buffer
+ * fills it is handed to a dedicated writer thread while the receiver keeps filling
+ * the other one, so a slow disk only stalls the network when both buffers are
+ * busy. The destination can be preallocated so it is laid out contiguously, and
+ * finish() syncs the file to disk once at the end instead of after every write.
+ *
+ * All methods are called from one thread; only the writer thread touches the
+ * file while a buffer is in flight.
+ */
+class DownloadSink {
+public:
+    explicit DownloadSink(const QString &path);
+    ~DownloadSink();
+
+    DownloadSink(const DownloadSink &) = delete;
+    DownloadSink &operator=(const DownloadSink &) = delete;
+
+    /**
+     * @brief Opens (or creates) the file without truncating it and starts the writer thread.
+     */
+    bool open();
+
+    /**
+     * @brief Returns the current file size; buffered data is flushed first.
+     */
+    qint64 size();
+
+    /**
+     * @brief Truncates the file to @p offset and continues writing from there.
+     */
+    bool reset(qint64 offset);
+
+    /**
+     * @brief Reserves disk space for a file of @p totalSize bytes without changing its length.
+     *
+     * Best effort: filesystems without preallocation support are silently skipped.
+     */
+    void preallocate(qint64 totalSize);
+
+    /**
+     * @brief Queues data for writing.
+     * @return false if an earlier write failed.
+     */
+    bool write(const char *data, size_t length);
+
+    /**
+     * @brief Writes out everything queued so far and waits for it.
+     * @return false if any write failed.
+     */
+    bool flush();
+
+    /**
+     * @brief Returns the file length the writer thread has handed to the OS so far.
+     *
+     * Safe to use as a resume point: every byte below it is in the file.
+     */
+    qint64 written() const { return m_written.load(); }
+
+    /**
+     * @brief Flushes, syncs the file to stable storage once, and closes it.
+     */
+    bool finish();
+
+    /**
+     * @brief Flushes and closes the file without syncing.
+     */
+    void close();
+
+private:
+    struct Buffer {
+        char *data = nullptr;
+        size_t used = 0;
+    };
+
+    void writerLoop();
+    void submit();
+    void waitIdle(std::unique_lock<std::mutex> &lock);
+    void stopWriter();
+
+    QFile m_file;
+    Buffer m_buffers[2];
+    int m_filling = 0;                ///< Index of the buffer the receiver is filling
+    int m_pendingIndex = -1;          ///< Buffer handed to the writer, or -1 when idle
+    bool m_stop = false;              ///< Tells the writer thread to exit
+    std::atomic<bool> m_failed{false};
+    std::atomic<qint64> m_written{0};
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_writer;
+};
+
+#endif // DOWNLOADSINK_H
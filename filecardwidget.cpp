@@ -3,6 +3,8 @@
 #include <QLabel>
 #include <QPushButton>
 #include <QPixmap>
+#include <QLocale>
+#include <QStringList>
 
 /**
  * @author Harshi Kamboj
@@ -10,7 +12,7 @@
  *
  * Initializes layout, styles, and button interactions for favorite and select functionality.
  */
-FileCardWidget::FileCardWidget(FileData &data, int index, QWidget *parent)
+FileCardWidget::FileCardWidget(const FileData &data, int index, QWidget *parent)
     : QFrame(parent), m_file(data), m_index(index)
 {
     // Style the card
@@ -25,22 +27,18 @@ FileCardWidget::FileCardWidget(FileData &data, int index, QWidget *parent)
     cardLayout->setSpacing(5);
 
     // File icon setup
-    QLabel *iconLabel = new QLabel(this);
-    QPixmap pix(QString(":/icons/%1").arg(m_file.iconName));
-    pix = pix.scaled(48, 48, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    iconLabel->setPixmap(pix);
+    iconLabel = new QLabel(this);
     iconLabel->setAlignment(Qt::AlignHCenter);
     cardLayout->addWidget(iconLabel);
 
     // Display file name
-    QLabel *nameLabel = new QLabel(m_file.fileName, this);
+    nameLabel = new QLabel(this);
     nameLabel->setStyleSheet("font-weight: bold; font-size: 12px; color: #000000;");
     nameLabel->setAlignment(Qt::AlignHCenter);
     cardLayout->addWidget(nameLabel);
 
     // Display last modified date
-    QString dateStr = m_file.dateModified.toString("yyyy-MM-dd hh:mm");
-    QLabel *dateLabel = new QLabel(QString("Modified: %1").arg(dateStr), this);
+    dateLabel = new QLabel(this);
     dateLabel->setStyleSheet("color: #555555; font-size: 10px;");
     dateLabel->setAlignment(Qt::AlignHCenter);
     cardLayout->addWidget(dateLabel);
@@ -66,7 +64,47 @@ FileCardWidget::FileCardWidget(FileData &data, int index, QWidget *parent)
 
     cardLayout->addStretch();
 
-    // Set initial button states
+    // Set initial labels and button states
+    showFile();
+}
+
+/**
+ * @brief Replaces the shown data and index in place, without recreating the card.
+ */
+void FileCardWidget::setFile(const FileData &data, int index)
+{
+    m_index = index;
+    if (data.iconName == m_file.iconName && data.fileName == m_file.fileName &&
+        data.dateModified == m_file.dateModified && data.size == m_file.size &&
+        data.mimeType == m_file.mimeType && data.isFavorite == m_file.isFavorite &&
+        data.isSelected == m_file.isSelected)
+        return;
+    m_file = data;
+    showFile();
+}
+
+/**
+ * @brief Fills the icon, labels, tooltip and buttons from the current data.
+ */
+void FileCardWidget::showFile()
+{
+    QPixmap pix(QString(":/icons/%1").arg(m_file.iconName));
+    pix = pix.scaled(48, 48, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    iconLabel->setPixmap(pix);
+
+    nameLabel->setText(m_file.fileName);
+
+    QString dateStr = m_file.dateModified.toString("yyyy-MM-dd hh:mm");
+    dateLabel->setText(QString("Modified: %1").arg(dateStr));
+
+    // Size and type are only known when the server listing carried them.
+    QStringList details;
+    if (m_file.size >= 0)
+        details << QString("Size: %1").arg(QLocale().formattedDataSize(m_file.size));
+    if (!m_file.mimeType.isEmpty())
+        details << QString("Type: %1").arg(m_file.mimeType);
+    setToolTip(details.isEmpty() ? m_file.fileName : m_file.fileName + "\n" + details.join("\n"));
+
     updateButtons();
 }
 
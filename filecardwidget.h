@@ -4,6 +4,7 @@
 #include <QFrame>
 #include "MainWindow.h"
 
+class QLabel;
 class QPushButton;
 
 /**
@@ -19,12 +20,24 @@ class FileCardWidget : public QFrame
     Q_OBJECT
 public:
     /**
-     * @brief Constructs a FileCardWidget with reference to file data and its index.
-     * @param data Reference to the file's metadata.
+     * @brief Constructs a FileCardWidget showing a copy of the file's data.
+     * @param data The file's metadata.
      * @param index Index of the file in the master file list.
      * @param parent Optional parent widget.
      */
-    explicit FileCardWidget(FileData &data, int index, QWidget *parent = nullptr);
+    explicit FileCardWidget(const FileData &data, int index, QWidget *parent = nullptr);
+
+    /**
+     * @brief Shows new data for the card's file, e.g. after a pushed change moved or updated it.
+     * @param data The file's current metadata.
+     * @param index The file's current index in the master file list.
+     */
+    void setFile(const FileData &data, int index);
+
+    /**
+     * @brief Returns the data the card currently shows.
+     */
+    const FileData &file() const { return m_file; }
 
 signals:
     /**
@@ -55,12 +68,20 @@ private slots:
     void onSelectClicked();
 
 private:
-    FileData &m_file;          ///< Reference to the file's data
+    FileData m_file;           ///< Copy of the file's data; the master list may reallocate
     int m_index;               ///< Index of the file in the global list
 
+    QLabel *iconLabel;         ///< File type icon
+    QLabel *nameLabel;         ///< File name
+    QLabel *dateLabel;         ///< Last modified date
     QPushButton *favoriteBtn;  ///< Button to toggle favorite state
     QPushButton *selectBtn;    ///< Button to toggle selection state
 
+    /**
+     * @brief Fills the labels and tooltip from m_file.
+     */
+    void showFile();
+
     /**
      * @brief Updates button labels to reflect the current file state.
      */
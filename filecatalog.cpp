@@ -0,0 +1,130 @@
+#include "filecatalog.h"
+#include <QHash>
+#include <QSet>
+
+/**
+ * @brief Maps a file extension to its corresponding icon filename.
+ * @param extension The file extension (e.g., ".pdf").
+ * @return A QString representing the icon filename.
+ */
+QString FileCatalog::iconForExtension(const QString &extension) {
+    QString ext = extension.toLower();
+    if(ext == ".pdf")
+        return "pdf.png";
+    else if(ext == ".doc" || ext == ".docx")
+        return "word.png";
+    else if(ext == ".xls" || ext == ".xlsx")
+        return "excel.png";
+    else if(ext == ".ppt" || ext == ".pptx")
+        return "ppt.png";
+    else if(ext == ".mp3" || ext == ".wav" || ext == ".flac" || ext == ".aac" || ext == ".m4a" || ext == ".ogg")
+        return "music.png";
+    else if(ext == ".mp4" || ext == ".avi" || ext == ".mkv" || ext == ".mov" || ext == ".wmv" || ext == ".flv")
+        return "video.png";
+    else if(ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".gif" || ext == ".bmp" ||
+             ext == ".svg" || ext == ".tiff" || ext == ".webp" || ext == ".heif")
+        return "image.png";
+    else if(ext == ".txt" || ext == ".html" || ext == ".rtf" || ext == ".csv")
+        return "doc.png";
+    else
+        return "random.png";
+}
+
+/**
+ * @brief Converts a server listing entry into the view's file record.
+ */
+FileData FileCatalog::fileDataFor(const APIClient::RemoteFile &stored, const QStringList &favorites) {
+    const QString &filename = stored.name;
+    FileData fileData;
+    fileData.fileName = filename;
+    int dotIndex = filename.lastIndexOf('.');
+    fileData.extension = (dotIndex != -1) ? filename.mid(dotIndex).toLower() : "";
+    // Older servers send names only; fall back to "now" so the card still shows a date.
+    fileData.dateModified = stored.modified > 0 ? QDateTime::fromMSecsSinceEpoch(stored.modified)
+                                                : QDateTime::currentDateTime();
+    fileData.size = stored.size;
+    fileData.contentHash = stored.contentHash;
+    fileData.mimeType = stored.mimeType;
+    fileData.iconName = iconForExtension(fileData.extension);
+
+    // Mark as favorite if found in settings.
+    fileData.isFavorite = favorites.contains(filename);
+    return fileData;
+}
+
+/**
+ * @brief Replays journal changes against the list using a name index.
+ *
+ * Adds of a name already present update its metadata, so replaying a change
+ * the listing already included is harmless. Removed rows are dropped in one
+ * pass at the end.
+ */
+void FileCatalog::applyChanges(QList<FileData> &files, const QList<APIClient::FileChange> &changes,
+                               const QStringList &favorites) {
+    QHash<QString, int> rows;
+    rows.reserve(files.size());
+    for (int i = 0; i < files.size(); ++i)
+        rows.insert(files[i].fileName, i);
+    QSet<int> removedRows;
+
+    for (const APIClient::FileChange &change : changes) {
+        const QString &name = change.file.name;
+        switch (change.type) {
+        case APIClient::FileChange::Type::Added: {
+            if (name == ".DS_Store")
+                break;
+            auto it = rows.find(name);
+            if (it == rows.end()) {
+                rows.insert(name, files.size());
+                files.append(fileDataFor(change.file, favorites));
+                break;
+            }
+            FileData &existing = files[it.value()];
+            FileData updated = fileDataFor(change.file, favorites);
+            existing.dateModified = updated.dateModified;
+            existing.size = updated.size;
+            existing.contentHash = updated.contentHash;
+            existing.mimeType = updated.mimeType;
+            break;
+        }
+        case APIClient::FileChange::Type::Removed: {
+            auto it = rows.find(name);
+            if (it != rows.end()) {
+                removedRows.insert(it.value());
+                rows.erase(it);
+            }
+            break;
+        }
+        case APIClient::FileChange::Type::Renamed: {
+            auto it = rows.find(change.oldName);
+            if (it == rows.end())
+                break;
+            int row = it.value();
+            rows.erase(it);
+            // A rename onto an existing name replaces that file.
+            auto target = rows.find(name);
+            if (target != rows.end()) {
+                removedRows.insert(target.value());
+                rows.erase(target);
+            }
+            FileData &file = files[row];
+            file.fileName = name;
+            int dotIndex = name.lastIndexOf('.');
+            file.extension = (dotIndex != -1) ? name.mid(dotIndex).toLower() : "";
+            file.iconName = iconForExtension(file.extension);
+            rows.insert(name, row);
+            break;
+        }
+        }
+    }
+
+    if (!removedRows.isEmpty()) {
+        QList<FileData> kept;
+        kept.reserve(files.size() - removedRows.size());
+        for (int i = 0; i < files.size(); ++i) {
+            if (!removedRows.contains(i))
+                kept.append(files[i]);
+        }
+        files = kept;
+    }
+}
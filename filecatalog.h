@@ -0,0 +1,52 @@
+#ifndef FILECATALOG_H
+#define FILECATALOG_H
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "APIClient.h"
+
+/**
+ * @brief A file as the view shows it.
+ */
+struct FileData {
+    QString iconName;         ///< Icon used for display (e.g., "pdf.png")
+    QString fileName;         ///< File name shown to user
+    QString extension;        ///< File extension/type
+    bool isFavorite = false;  ///< Whether marked as favorite
+    bool isSelected = false;  ///< Whether currently selected
+    QDateTime dateModified;   ///< Last modified date
+    qint64 size = -1;         ///< Size in bytes, or -1 if unknown
+    QString contentHash;      ///< Server content digest, or empty
+    QString mimeType;         ///< MIME type reported by the server, or empty
+};
+
+/**
+ * @class FileCatalog
+ * @brief Builds the view's file records from server listings and patches them from the change journal.
+ *
+ * Kept free of widgets so the listing logic can be tested on its own.
+ */
+class FileCatalog {
+public:
+    /**
+     * @brief Maps a file extension (e.g. ".pdf") to its icon file name.
+     */
+    static QString iconForExtension(const QString &extension);
+
+    /**
+     * @brief Builds the view entry for a file reported by the server.
+     * @param favorites Favorite file names from QSettings.
+     */
+    static FileData fileDataFor(const APIClient::RemoteFile &stored, const QStringList &favorites);
+
+    /**
+     * @brief Replays journal changes against @p files in place, keeping favorite and selection state.
+     * @param favorites Favorite file names from QSettings, for files the changes add.
+     */
+    static void applyChanges(QList<FileData> &files, const QList<APIClient::FileChange> &changes,
+                             const QStringList &favorites);
+};
+
+#endif // FILECATALOG_H
@@ -0,0 +1,185 @@
+#include "filehasher.h"
+#include <QFile>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+/// Read size used by hashFile(); large enough to keep the hash loop busy.
+constexpr qint64 kReadSize = 1024 * 1024;
+
+inline uint64_t rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t read64(const uint8_t *p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t read32(const uint8_t *p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t lane) {
+    acc ^= round(0, lane);
+    return acc * kPrime1 + kPrime4;
+}
+
+} // namespace
+
+/**
+ * @brief Initializes the four lane accumulators from the seed.
+ */
+FileHasher::FileHasher(uint64_t seed)
+    : m_seed(seed)
+{
+    m_lanes[0] = seed + kPrime1 + kPrime2;
+    m_lanes[1] = seed + kPrime2;
+    m_lanes[2] = seed;
+    m_lanes[3] = seed - kPrime1;
+}
+
+/**
+ * @brief Consumes input in 32-byte stripes, buffering any remainder.
+ */
+void FileHasher::update(const void *data, size_t length)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    const uint8_t *end = p + length;
+    m_totalLength += length;
+
+    if (m_buffered + length < sizeof(m_buffer)) {
+        std::memcpy(m_buffer + m_buffered, p, length);
+        m_buffered += length;
+        return;
+    }
+
+    if (m_buffered > 0) {
+        size_t fill = sizeof(m_buffer) - m_buffered;
+        std::memcpy(m_buffer + m_buffered, p, fill);
+        p += fill;
+        for (int lane = 0; lane < 4; ++lane) {
+            m_lanes[lane] = round(m_lanes[lane], read64(m_buffer + lane * 8));
+        }
+        m_buffered = 0;
+    }
+
+    // Four independent accumulators let the CPU overlap the multiplies.
+    uint64_t v1 = m_lanes[0], v2 = m_lanes[1], v3 = m_lanes[2], v4 = m_lanes[3];
+    while (end - p >= 32) {
+        v1 = round(v1, read64(p));
+        v2 = round(v2, read64(p + 8));
+        v3 = round(v3, read64(p + 16));
+        v4 = round(v4, read64(p + 24));
+        p += 32;
+    }
+    m_lanes[0] = v1; m_lanes[1] = v2; m_lanes[2] = v3; m_lanes[3] = v4;
+
+    m_buffered = static_cast<size_t>(end - p);
+    std::memcpy(m_buffer, p, m_buffered);
+}
+
+/**
+ * @brief Merges the lanes, folds in the buffered tail and applies the final avalanche.
+ */
+uint64_t FileHasher::digest() const
+{
+    uint64_t h;
+    if (m_totalLength >= 32) {
+        h = rotl(m_lanes[0], 1) + rotl(m_lanes[1], 7) + rotl(m_lanes[2], 12) + rotl(m_lanes[3], 18);
+        for (uint64_t lane : m_lanes) {
+            h = mergeRound(h, lane);
+        }
+    } else {
+        h = m_seed + kPrime5;
+    }
+    h += m_totalLength;
+
+    const uint8_t *p = m_buffer;
+    const uint8_t *end = m_buffer + m_buffered;
+    while (end - p >= 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+    if (end - p >= 4) {
+        h ^= uint64_t(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+/**
+ * @brief Formats the digest as big-endian hex, matching the canonical XXH64 form.
+ */
+QByteArray FileHasher::hexDigest() const
+{
+    uint64_t value = digest();
+    QByteArray hex(16, '0');
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 15; i >= 0; --i) {
+        hex[i] = digits[value & 0xF];
+        value >>= 4;
+    }
+    return hex;
+}
+
+/**
+ * @brief Reads the file in large blocks and returns its hex digest.
+ */
+QByteArray FileHasher::hashFile(const QString &filePath,
+                                const std::function<bool(qint64 hashed, qint64 total)> &progress)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    const qint64 fileSize = file.size();
+    qint64 hashed = 0;
+    FileHasher hasher;
+    std::vector<char> buffer(static_cast<size_t>(kReadSize));
+    for (;;) {
+        qint64 bytesRead = file.read(buffer.data(), kReadSize);
+        if (bytesRead < 0) {
+            return QByteArray();
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+        hasher.update(buffer.data(), static_cast<size_t>(bytesRead));
+        hashed += bytesRead;
+        if (progress && !progress(hashed, fileSize)) {
+            return QByteArray();
+        }
+    }
+    return hasher.hexDigest();
+}
@@ -0,0 +1,57 @@
+#ifndef FILEHASHER_H
+#define FILEHASHER_H
+
+#include <QByteArray>
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @class FileHasher
+ * @brief Incremental XXH64 hash used to fingerprint whole files before upload.
+ *
+ * XXH64 is not cryptographic; it only has to tell the server whether it may
+ * already hold the same content, which the server confirms by size and its own
+ * stored hash before linking anything.
+ */
+class FileHasher {
+public:
+    /**
+     * @brief Starts a new hash with the given seed.
+     */
+    explicit FileHasher(uint64_t seed = 0);
+
+    /**
+     * @brief Feeds more data into the hash.
+     */
+    void update(const void *data, size_t length);
+
+    /**
+     * @brief Returns the hash of everything fed so far; the state is left unchanged.
+     */
+    uint64_t digest() const;
+
+    /**
+     * @brief Returns digest() as 16 lowercase hex characters.
+     */
+    QByteArray hexDigest() const;
+
+    /**
+     * @brief Hashes a whole file.
+     * @param filePath The file to hash.
+     * @param progress Optional callback after each block; returning false abandons the hash.
+     * @return The hex digest, or an empty QByteArray if the file could not be read or hashing was abandoned.
+     */
+    static QByteArray hashFile(const QString &filePath,
+                               const std::function<bool(qint64 hashed, qint64 total)> &progress = nullptr);
+
+private:
+    uint64_t m_seed;
+    uint64_t m_lanes[4];        ///< Accumulators for the four parallel stripes
+    uint8_t m_buffer[32];       ///< Input not yet forming a full 32-byte stripe
+    size_t m_buffered = 0;      ///< Bytes held in m_buffer
+    uint64_t m_totalLength = 0; ///< Bytes fed in total
+};
+
+#endif // FILEHASHER_H
@@ -1,6 +1,7 @@
 #include "FileHierarchyView.h"
 #include "FileCardWidget.h"
-#include "APIClient.h"
+#include "asyncapiclient.h"
+#include "filetypes.h"
 #include <QStackedWidget>
 #include <QScrollArea>
 #include <QGridLayout>
@@ -8,21 +9,33 @@
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QSettings>
+#include <QHash>
 #include <QDebug>
 #include <algorithm>
 
+namespace {
+
+/// Cards per grid row.
+constexpr int kColumns = 4;
+
+} // namespace
+
 /**
  * @author Harshi Kamboj
  * @brief Constructs and initializes the FileHierarchyView.
  */
 FileHierarchyView::FileHierarchyView(QWidget *parent)
-    : QWidget(parent), allFiles(nullptr), currentCategory("All Files")
+    : QWidget(parent), allFiles(nullptr), currentCategory("All Files"),
+      apiClient(new AsyncAPIClient("http://localhost:8080", this))
 {
     QVBoxLayout *layout = new QVBoxLayout(this);
     stackedWidget = new QStackedWidget(this);
     layout->addWidget(stackedWidget);
     setLayout(layout);
 
+    connect(apiClient, &AsyncAPIClient::renameFinished, this, &FileHierarchyView::onRenameFinished);
+    connect(apiClient, &AsyncAPIClient::deleteBatchFinished, this, &FileHierarchyView::onDeleteBatchFinished);
+
     searchTerm.clear(); // No search term initially
 }
 
@@ -75,32 +88,24 @@ QList<FileData> FileHierarchyView::filterFilesByCategory(const QString &category
             if (f.isFavorite)
                 result.append(f);
     } else if (category == "Images") {
-        QStringList exts = { ".png", ".jpeg", ".jpg", ".gif", ".tiff", ".webp", ".svg", ".bmp", ".heif" };
         for (auto &f : *allFiles)
-            if (exts.contains(f.extension.toLower()))
+            if (FileTypes::images().contains(f.extension.toLower()))
                 result.append(f);
     } else if (category == "Videos") {
-        QStringList exts = { ".avi", ".wmv", ".mp4", ".mkv", ".mov", ".avchd", ".flv", ".ogg" };
         for (auto &f : *allFiles)
-            if (exts.contains(f.extension.toLower()))
+            if (FileTypes::videos().contains(f.extension.toLower()))
                 result.append(f);
     } else if (category == "Music") {
-        QStringList exts = { ".wav", ".aiff", ".mp3", ".flac", ".aac", ".m4a", ".ogg" };
         for (auto &f : *allFiles)
-            if (exts.contains(f.extension.toLower()))
+            if (FileTypes::music().contains(f.extension.toLower()))
                 result.append(f);
     } else if (category == "Documents") {
-        QStringList exts = { ".pdf", ".docx", ".pptx", ".xlsx", ".txt", ".html", ".rtf", ".csv", ".doc", ".ppt" };
         for (auto &f : *allFiles)
-            if (exts.contains(f.extension.toLower()))
+            if (FileTypes::documents().contains(f.extension.toLower()))
                 result.append(f);
     } else if (category == "Other") {
-        QStringList allKnown = { ".png", ".jpeg", ".jpg", ".gif", ".tiff", ".webp", ".svg", ".bmp", ".heif",
-                                ".avi", ".wmv", ".mp4", ".mkv", ".mov", ".avchd", ".flv", ".ogg",
-                                ".wav", ".aiff", ".mp3", ".flac", ".aac", ".m4a",
-                                ".pdf", ".docx", ".pptx", ".xlsx", ".txt", ".html", ".rtf", ".csv", ".doc", ".ppt" };
         for (auto &f : *allFiles)
-            if (!allKnown.contains(f.extension.toLower()))
+            if (!FileTypes::isKnown(f.extension))
                 result.append(f);
     } else {
         result = *allFiles; // fallback
@@ -134,46 +139,59 @@ QWidget* FileHierarchyView::createCategoryPage(const QList<FileData> &files)
     QGridLayout *gridLayout = new QGridLayout(container);
     gridLayout->setSpacing(15);
 
-    const int columns = 4;
-    int row = 0, col = 0;
-
-    for (int i = 0; i < files.size(); ++i) {
-        int globalIndex = -1;
-
+    m_grid = gridLayout;
+    m_cards.clear();
+    const QHash<QString, int> rows = fileRows();
+    for (const FileData &file : files) {
         // Find index in original list
-        for (int j = 0; j < allFiles->size(); ++j) {
-            if ((*allFiles)[j].fileName == files[i].fileName &&
-                (*allFiles)[j].extension == files[i].extension)
-            {
-                globalIndex = j;
-                break;
-            }
-        }
-
-        if (globalIndex == -1)
+        auto it = rows.find(file.fileName);
+        if (it == rows.end())
             continue;
-
-        // Create FileCard for file
-        FileCardWidget *card = new FileCardWidget((*allFiles)[globalIndex], globalIndex, container);
-
-        // Connect card signals to view
-        connect(card, &FileCardWidget::favoriteToggled, this, &FileHierarchyView::fileFavoriteToggled);
-        connect(card, &FileCardWidget::selectedToggled, this, &FileHierarchyView::fileSelectedToggled);
-
-        gridLayout->addWidget(card, row, col);
-
-        col++;
-        if (col >= columns) {
-            col = 0;
-            row++;
-        }
+        m_cards.append(createCard(it.value(), container));
     }
+    layoutCards();
 
     container->setLayout(gridLayout);
     scroll->setWidget(container);
     return scroll;
 }
 
+/**
+ * @brief Creates a card for one file and connects its signals to the view.
+ * @param globalIndex Index of the file in the master list.
+ * @param parent Widget that holds the card grid.
+ */
+FileCardWidget *FileHierarchyView::createCard(int globalIndex, QWidget *parent)
+{
+    FileCardWidget *card = new FileCardWidget((*allFiles)[globalIndex], globalIndex, parent);
+    connect(card, &FileCardWidget::favoriteToggled, this, &FileHierarchyView::fileFavoriteToggled);
+    connect(card, &FileCardWidget::selectedToggled, this, &FileHierarchyView::fileSelectedToggled);
+    return card;
+}
+
+/**
+ * @brief Lays the current cards out kColumns to a row.
+ */
+void FileHierarchyView::layoutCards()
+{
+    for (int i = 0; i < m_cards.size(); ++i)
+        m_grid->addWidget(m_cards[i], i / kColumns, i % kColumns);
+}
+
+/**
+ * @brief Indexes the master list by file name.
+ */
+QHash<QString, int> FileHierarchyView::fileRows() const
+{
+    QHash<QString, int> rows;
+    if (!allFiles)
+        return rows;
+    rows.reserve(allFiles->size());
+    for (int i = 0; i < allFiles->size(); ++i)
+        rows.insert((*allFiles)[i].fileName, i);
+    return rows;
+}
+
 /**
  * @brief Clears and rebuilds the file view from scratch.
  */
@@ -251,6 +269,64 @@ void FileHierarchyView::updateView()
     rebuild(); // Trigger full refresh
 }
 
+/**
+ * @brief Diffs the current page's cards against the filtered file list by name.
+ *
+ * Renamed files leave under their old name and come back at the end under the
+ * new one. Falls back to rebuild() when no page has been built yet.
+ */
+void FileHierarchyView::refreshCards()
+{
+    if (!m_grid || !allFiles) {
+        rebuild();
+        return;
+    }
+
+    const QHash<QString, int> rows = fileRows();
+    const QList<FileData> filtered = filterFilesByCategory(currentCategory);
+    QSet<QString> wanted;
+    wanted.reserve(filtered.size());
+    for (const FileData &file : filtered)
+        wanted.insert(file.fileName);
+
+    QList<FileCardWidget *> kept;
+    kept.reserve(filtered.size());
+    QSet<QString> shown;
+    for (FileCardWidget *card : m_cards) {
+        const QString name = card->file().fileName;
+        auto it = rows.find(name);
+        if (it != rows.end() && wanted.contains(name)) {
+            card->setFile((*allFiles)[it.value()], it.value());
+            kept.append(card);
+            shown.insert(name);
+        } else {
+            m_grid->removeWidget(card);
+            card->deleteLater();
+        }
+    }
+
+    bool appended = false;
+    QWidget *container = m_grid->parentWidget();
+    for (const FileData &file : filtered) {
+        if (shown.contains(file.fileName))
+            continue;
+        auto it = rows.find(file.fileName);
+        if (it == rows.end())
+            continue;
+        kept.append(createCard(it.value(), container));
+        appended = true;
+    }
+
+    // Cards only need new grid positions when some were removed or added.
+    if (appended || kept.size() != m_cards.size()) {
+        for (FileCardWidget *card : kept)
+            m_grid->removeWidget(card);
+        m_cards = kept;
+        layoutCards();
+    }
+    updateSelectionInfo();
+}
+
 /**
  * @brief Returns the global indices for files currently shown on the view.
  * @return A QList of indices corresponding to files in the master list.
@@ -337,20 +413,39 @@ void FileHierarchyView::onRenameRequested()
 
         if (ok && !newBaseName.isEmpty()) {
             QString newFullName = newBaseName + extension;
-            APIClient apiClient;  // Create API client instance.
-            bool apiSuccess = apiClient.renameFile(currentName, newFullName);
-            if (apiSuccess) {
-                (*allFiles)[singleIndex].fileName = newFullName;
-                rebuild();
-            } else {
-                QMessageBox::warning(this, "Rename File", "Failed to rename file on the server.");
-            }
+            apiClient->renameFile(currentName, newFullName);
+        }
+    }
+}
+
+/**
+ * @brief Updates the renamed file once the server has confirmed the rename.
+ * @param oldName The file's name before the rename.
+ * @param newName The requested new name.
+ * @param success Whether the server applied the rename.
+ */
+void FileHierarchyView::onRenameFinished(const QString &oldName, const QString &newName, bool success)
+{
+    if (!success) {
+        QMessageBox::warning(this, "Rename File", "Failed to rename file on the server.");
+        return;
+    }
+    if (!allFiles) return;
+
+    for (auto &f : *allFiles) {
+        if (f.fileName == oldName) {
+            f.fileName = newName;
+            break;
         }
     }
+    rebuild();
 }
 
 /**
- * @brief Deletes all currently selected files from the list and updates the API.
+ * @brief Starts deleting all currently selected files on the server.
+ *
+ * The whole selection is sent as one batch in the background; the list is
+ * updated when the per-file results come back.
  */
 void FileHierarchyView::onDeleteRequested()
 {
@@ -358,28 +453,45 @@ void FileHierarchyView::onDeleteRequested()
     QList<int> indices = getCurrentPageFileIndices();
     if (indices.isEmpty()) return;
 
-    QList<int> indicesToRemove;
-    APIClient apiClient;  // Create an API client instance.
+    QStringList toDelete;
     for (int idx : indices) {
         if ((*allFiles)[idx].isSelected) {
-            bool apiSuccess = apiClient.deleteFile((*allFiles)[idx].fileName);
-            if (apiSuccess) {
-                indicesToRemove.append(idx);
-            } else {
-                QMessageBox::warning(this, "Delete File", "Failed to delete file on the server: " + (*allFiles)[idx].fileName);
-            }
+            toDelete.append((*allFiles)[idx].fileName);
         }
     }
+    if (toDelete.isEmpty()) return;
 
-    if (indicesToRemove.isEmpty()) return;
+    apiClient->deleteFiles(toDelete);
+}
 
-    // Remove from highest index to avoid shifting.
-    std::sort(indicesToRemove.begin(), indicesToRemove.end(), std::greater<int>());
-    for (int idx : indicesToRemove) {
-        allFiles->removeAt(idx);
+/**
+ * @brief Removes deleted files from the list and reports any failures at once.
+ * @param results One result per requested file.
+ */
+void FileHierarchyView::onDeleteBatchFinished(const std::vector<APIClient::BatchResult> &results)
+{
+    QSet<QString> deleted;
+    QStringList failed;
+    for (const auto &result : results) {
+        if (result.success)
+            deleted.insert(result.name);
+        else
+            failed.append(result.name);
     }
 
-    rebuild();
+    if (allFiles && !deleted.isEmpty()) {
+        // Remove from highest index to avoid shifting.
+        for (int i = allFiles->size() - 1; i >= 0; --i) {
+            if (deleted.contains((*allFiles)[i].fileName)) {
+                allFiles->removeAt(i);
+            }
+        }
+        rebuild();
+    }
+
+    if (!failed.isEmpty()) {
+        QMessageBox::warning(this, "Delete File", "Failed to delete file on the server: " + failed.join(", "));
+    }
 }
 
 /**
@@ -3,9 +3,13 @@
 
 #include <QWidget>
 #include "MainWindow.h"
+#include "APIClient.h"
 #include <QSet>
 
 class QStackedWidget;
+class QGridLayout;
+class AsyncAPIClient;
+class FileCardWidget;
 
 /**
  * @author Harshi Kamboj
@@ -53,6 +57,16 @@ public:
      */
     void updateView();
 
+    /**
+     * @brief Brings the current page in line with the file list without rebuilding it.
+     *
+     * For small changes to the list, such as pushed server changes: cards of
+     * files that left the page are removed, new matches are appended, and the
+     * remaining cards are updated in place, so scroll position and sort order
+     * are kept and only the affected cards are created.
+     */
+    void refreshCards();
+
 public slots:
     /**
      * @brief Updates the search term used for filtering files.
@@ -99,11 +113,25 @@ public slots:
      */
     void fileSelectedToggled(int fileIndex, bool isSelected);
 
+private slots:
+    /**
+     * @brief Applies a finished background rename to the file list.
+     */
+    void onRenameFinished(const QString &oldName, const QString &newName, bool success);
+
+    /**
+     * @brief Removes the files a batch delete succeeded on and reports the rest.
+     */
+    void onDeleteBatchFinished(const std::vector<APIClient::BatchResult> &results);
+
 private:
     QStackedWidget *stackedWidget;     ///< Holds the file pages by category
     QList<FileData> *allFiles;           ///< Pointer to the master list of files
     QString currentCategory;             ///< Current file category
     QString searchTerm;                  ///< Current search input for filtering
+    AsyncAPIClient *apiClient;           ///< Runs rename/delete requests off the GUI thread
+    QGridLayout *m_grid = nullptr;       ///< Card grid of the current page
+    QList<FileCardWidget *> m_cards;     ///< Cards of the current page, in grid order
 
     /**
      * @brief Generates a UI page for the given list of files.
@@ -112,6 +140,21 @@ private:
      */
     QWidget* createCategoryPage(const QList<FileData> &files);
 
+    /**
+     * @brief Creates a connected card for the file at @p globalIndex.
+     */
+    FileCardWidget *createCard(int globalIndex, QWidget *parent);
+
+    /**
+     * @brief Places m_cards into m_grid row by row.
+     */
+    void layoutCards();
+
+    /**
+     * @brief Maps each file name to its index in the master list.
+     */
+    QHash<QString, int> fileRows() const;
+
     /**
      * @brief Filters the global file list by category and search term.
      * @param category Category to filter by.
@@ -0,0 +1,46 @@
+#include "filetypes.h"
+
+/**
+ * @brief Returns the extensions listed under "Images".
+ */
+const QStringList &FileTypes::images()
+{
+    static const QStringList exts = { ".png", ".jpeg", ".jpg", ".gif", ".tiff", ".webp", ".svg", ".bmp", ".heif" };
+    return exts;
+}
+
+/**
+ * @brief Returns the extensions listed under "Videos".
+ */
+const QStringList &FileTypes::videos()
+{
+    static const QStringList exts = { ".avi", ".wmv", ".mp4", ".mkv", ".mov", ".avchd", ".flv", ".ogg" };
+    return exts;
+}
+
+/**
+ * @brief Returns the extensions listed under "Music".
+ */
+const QStringList &FileTypes::music()
+{
+    static const QStringList exts = { ".wav", ".aiff", ".mp3", ".flac", ".aac", ".m4a", ".ogg" };
+    return exts;
+}
+
+/**
+ * @brief Returns the extensions listed under "Documents".
+ */
+const QStringList &FileTypes::documents()
+{
+    static const QStringList exts = { ".pdf", ".docx", ".pptx", ".xlsx", ".txt", ".html", ".rtf", ".csv", ".doc", ".ppt" };
+    return exts;
+}
+
+/**
+ * @brief Checks the extension against every category table.
+ */
+bool FileTypes::isKnown(const QString &extension)
+{
+    QString ext = extension.toLower();
+    return images().contains(ext) || videos().contains(ext) || music().contains(ext) || documents().contains(ext);
+}
@@ -0,0 +1,25 @@
+#ifndef FILETYPES_H
+#define FILETYPES_H
+
+#include <QStringList>
+
+/**
+ * @class FileTypes
+ * @brief The file extension tables behind the sidebar categories.
+ *
+ * Extensions are lowercase and include the leading dot, matching FileData::extension.
+ */
+class FileTypes {
+public:
+    static const QStringList &images();
+    static const QStringList &videos();
+    static const QStringList &music();
+    static const QStringList &documents();
+
+    /**
+     * @brief Returns true if the extension belongs to any category.
+     */
+    static bool isKnown(const QString &extension);
+};
+
+#endif // FILETYPES_H
@@ -0,0 +1,238 @@
+#include "folderuploader.h"
+#include "APIClient.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// Number of concurrent upload requests.
+constexpr int kUploadWorkers = 3;
+
+/// Files waiting for upload; walkers block once this many are queued.
+constexpr size_t kQueueCapacity = 4096;
+
+/// Files at least this large are uploaded with APIClient::uploadFile() instead of in an archive.
+constexpr qint64 kLargeFileSize = 1024 * 1024;
+
+/// Limits on one archive request of small files.
+constexpr size_t kBatchFiles = 512;
+constexpr qint64 kBatchBytes = 16 * 1024 * 1024;
+
+} // namespace
+
+/**
+ * @brief State shared between the GUI-side object and its worker tasks.
+ */
+struct FolderUploader::Shared {
+    struct Item {
+        QString localPath;
+        QString remoteName;
+        qint64 size;
+    };
+
+    QDir root;                       ///< The folder being uploaded
+    QString prefix;                  ///< Folder name prepended to every remote path
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<Item> queue;
+    bool walkDone = false;
+    std::atomic<bool> cancelled{false};
+    std::atomic<int> pendingDirectories{0};
+    std::atomic<int> activeWorkers{0};
+    std::atomic<int> found{0};
+    std::atomic<int> succeeded{0};
+    std::atomic<int> failed{0};
+    QThreadPool walkPool;            ///< Runs the directory listings
+    QThreadPool uploadPool;          ///< Runs the upload workers
+};
+
+/**
+ * @brief Constructs the uploader; worker pools are created per upload.
+ */
+FolderUploader::FolderUploader(const QString &serverUrl, QObject *parent)
+    : QObject(parent), m_serverUrl(serverUrl)
+{
+}
+
+/**
+ * @brief Cancels and joins all workers before the shared state goes away.
+ */
+FolderUploader::~FolderUploader()
+{
+    cancel();
+    if (m_shared) {
+        m_shared->walkPool.waitForDone();
+        m_shared->uploadPool.waitForDone();
+    }
+}
+
+/**
+ * @brief Returns true while any upload worker is still running.
+ */
+bool FolderUploader::isRunning() const
+{
+    return m_shared && m_shared->activeWorkers.load() > 0;
+}
+
+/**
+ * @brief Seeds the walk with the root folder and starts the upload workers alongside it.
+ */
+bool FolderUploader::start(const QString &rootPath)
+{
+    QFileInfo rootInfo(rootPath);
+    if (isRunning() || !rootInfo.isDir())
+        return false;
+
+    if (m_shared) {
+        m_shared->walkPool.waitForDone();
+        m_shared->uploadPool.waitForDone();
+    }
+    m_shared = std::make_unique<Shared>();
+    m_shared->root = QDir(rootInfo.absoluteFilePath());
+    m_shared->prefix = rootInfo.fileName();
+    m_shared->walkPool.setMaxThreadCount(QThread::idealThreadCount());
+    m_shared->uploadPool.setMaxThreadCount(kUploadWorkers);
+
+    m_shared->pendingDirectories = 1;
+    m_shared->activeWorkers = kUploadWorkers;
+    QString root = m_shared->root.absolutePath();
+    QtConcurrent::run(&m_shared->walkPool, [this, root]() { walk(root); });
+    for (int i = 0; i < kUploadWorkers; ++i)
+        QtConcurrent::run(&m_shared->uploadPool, [this]() { uploadLoop(); });
+    return true;
+}
+
+/**
+ * @brief Flags cancellation and wakes every waiting walker and worker.
+ */
+void FolderUploader::cancel()
+{
+    if (!m_shared)
+        return;
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    m_shared->cancelled = true;
+    m_shared->notEmpty.notify_all();
+    m_shared->notFull.notify_all();
+}
+
+/**
+ * @brief Lists one directory, queues its files and schedules its subdirectories.
+ *
+ * Symbolic links are skipped so a link cycle cannot make the walk endless. The
+ * last walker to finish marks the walk as done.
+ */
+void FolderUploader::walk(const QString &directory)
+{
+    Shared &shared = *m_shared;
+    const QFileInfoList entries = QDir(directory).entryInfoList(
+        QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden, QDir::NoSort);
+
+    for (const QFileInfo &entry : entries) {
+        if (shared.cancelled)
+            break;
+        if (entry.isSymLink())
+            continue;
+        if (entry.isDir()) {
+            ++shared.pendingDirectories;
+            QString path = entry.absoluteFilePath();
+            QtConcurrent::run(&shared.walkPool, [this, path]() { walk(path); });
+            continue;
+        }
+
+        Shared::Item item{ entry.absoluteFilePath(),
+                           shared.prefix + "/" + shared.root.relativeFilePath(entry.absoluteFilePath()),
+                           entry.size() };
+        std::unique_lock<std::mutex> lock(shared.mutex);
+        shared.notFull.wait(lock, [&shared]() { return shared.cancelled || shared.queue.size() < kQueueCapacity; });
+        if (shared.cancelled)
+            break;
+        shared.queue.push_back(std::move(item));
+        ++shared.found;
+        shared.notEmpty.notify_one();
+    }
+
+    if (--shared.pendingDirectories == 0) {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        shared.walkDone = true;
+        shared.notEmpty.notify_all();
+    }
+}
+
+/**
+ * @brief Upload worker: sends a large file with uploadFile(), or a batch of small ones as an archive.
+ *
+ * Runs until the queue is drained after the walk, or until cancelled. The last
+ * worker to exit emits finished().
+ */
+void FolderUploader::uploadLoop()
+{
+    Shared &shared = *m_shared;
+    APIClient apiClient(m_serverUrl);
+    apiClient.setTransferClass(APIClient::TransferClass::Background);
+
+    for (;;) {
+        std::vector<std::pair<QString, QString>> batch;
+        bool largeFile = false;
+        {
+            std::unique_lock<std::mutex> lock(shared.mutex);
+            shared.notEmpty.wait(lock, [&shared]() {
+                return shared.cancelled || shared.walkDone || !shared.queue.empty();
+            });
+            if (shared.cancelled || shared.queue.empty())
+                break;
+
+            // A large file goes alone; small ones are grouped up to kBatchFiles / kBatchBytes.
+            largeFile = shared.queue.front().size >= kLargeFileSize;
+            qint64 batchBytes = 0;
+            do {
+                const Shared::Item &item = shared.queue.front();
+                batch.emplace_back(item.localPath, item.remoteName);
+                batchBytes += item.size;
+                shared.queue.pop_front();
+            } while (!largeFile && !shared.queue.empty() &&
+                     shared.queue.front().size < kLargeFileSize && batch.size() < kBatchFiles &&
+                     batchBytes + shared.queue.front().size <= kBatchBytes);
+            shared.notFull.notify_all();
+        }
+
+        auto keepGoing = [&shared](qint64, qint64) { return !shared.cancelled; };
+        std::vector<APIClient::BatchResult> results;
+        if (largeFile) {
+            // Streamed on its own, so it gets the compression and retry handling of a plain upload.
+            const auto &file = batch.front();
+            results.push_back({ file.second, apiClient.uploadFile(file.first, keepGoing, file.second), QString() });
+        } else {
+            results = apiClient.uploadArchive(batch, keepGoing);
+        }
+        QStringList stored;
+        for (const auto &result : results) {
+            if (result.success) {
+                stored.append(result.name);
+                ++shared.succeeded;
+            } else {
+                ++shared.failed;
+            }
+        }
+        if (!stored.isEmpty())
+            emit filesUploaded(stored);
+
+        bool walkDone;
+        {
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            walkDone = shared.walkDone;
+        }
+        emit progress(shared.succeeded + shared.failed, shared.found, walkDone);
+    }
+
+    if (--shared.activeWorkers == 0)
+        emit finished(shared.succeeded, shared.failed);
+}
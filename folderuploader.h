@@ -0,0 +1,80 @@
+#ifndef FOLDERUPLOADER_H
+#define FOLDERUPLOADER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+/**
+ * @class FolderUploader
+ * @brief Uploads a whole directory tree, keeping paths relative to the chosen folder.
+ *
+ * A pool of walker tasks lists directories in parallel and feeds the files into
+ * a bounded queue; a fixed set of upload workers drains the queue at the same
+ * time, so the first files go out while the walk is still running and a huge
+ * tree never sits in memory. Small files are grouped into tar archive requests
+ * (APIClient::uploadArchive); files of 1 MiB or more are sent on their own
+ * with APIClient::uploadFile().
+ *
+ * Signals are emitted from worker threads and reach GUI receivers queued.
+ */
+class FolderUploader : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs an idle uploader.
+     * @param serverUrl The base URL of the API server.
+     * @param parent Optional parent QObject.
+     */
+    explicit FolderUploader(const QString &serverUrl = "http://localhost:8080", QObject *parent = nullptr);
+
+    /**
+     * @brief Cancels any running upload and waits for its workers to stop.
+     */
+    ~FolderUploader() override;
+
+    /**
+     * @brief Starts uploading @p rootPath; files are stored as "<folder name>/<relative path>".
+     * @return false if an upload is already running or the folder does not exist.
+     */
+    bool start(const QString &rootPath);
+
+    /**
+     * @brief Stops walking and uploading; finished() is still emitted.
+     */
+    void cancel();
+
+    bool isRunning() const;
+
+signals:
+    /**
+     * @brief Emitted after each upload request.
+     * @param processed Files uploaded or failed so far.
+     * @param found Files discovered so far.
+     * @param walkDone Whether the directory walk has finished, i.e. @p found is final.
+     */
+    void progress(int processed, int found, bool walkDone);
+
+    /**
+     * @brief Emitted with the server names of the files stored by one upload request.
+     */
+    void filesUploaded(const QStringList &remoteNames);
+
+    /**
+     * @brief Emitted once every worker has stopped.
+     */
+    void finished(int succeeded, int failed);
+
+private:
+    struct Shared;
+
+    void walk(const QString &directory);
+    void uploadLoop();
+
+    QString m_serverUrl;
+    std::unique_ptr<Shared> m_shared; ///< State shared with the walker and upload tasks
+};
+
+#endif // FOLDERUPLOADER_H
@@ -0,0 +1,178 @@
+#include "listingcache.h"
+#include "listingparser.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <fstream>
+#include "json/json.hpp"
+
+namespace {
+
+/// Entries handed to the callback per batch when replaying.
+constexpr size_t kReplayBatchSize = 1000;
+
+/// Length of the trailing offset: a CBOR uint64 head byte and eight big-endian bytes.
+constexpr qint64 kTrailerSize = 9;
+
+/**
+ * @brief Returns the CBOR encoding of a text string.
+ */
+std::vector<uint8_t> cborText(const std::string &text)
+{
+    return nlohmann::json::to_cbor(nlohmann::json(text));
+}
+
+/**
+ * @brief Writes raw CBOR bytes to the cache file.
+ */
+void writeBytes(QSaveFile &file, const std::vector<uint8_t> &bytes)
+{
+    file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<qint64>(bytes.size()));
+}
+
+} // namespace
+
+/**
+ * @brief Derives the cache file name from the server URL and reads the metadata at its end.
+ *
+ * A file without a valid trailer (missing, cut short or damaged) counts as no cache.
+ */
+ListingCache::ListingCache(const QString &serverUrl)
+{
+    const QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/listings";
+    QDir().mkpath(directory);
+    const QString key = QString::fromLatin1(
+        QCryptographicHash::hash(serverUrl.toUtf8(), QCryptographicHash::Md5).toHex());
+    m_path = directory + "/" + key + ".cbor";
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < kTrailerSize || !file.seek(file.size() - kTrailerSize)) {
+        return;
+    }
+    const QByteArray trailer = file.read(kTrailerSize);
+    if (trailer.size() != kTrailerSize || static_cast<uchar>(trailer[0]) != 0x1b) {
+        return;
+    }
+    qint64 offset = 0;
+    for (int i = 1; i < kTrailerSize; ++i) {
+        offset = (offset << 8) | static_cast<uchar>(trailer[i]);
+    }
+    const qint64 metaEnd = file.size() - kTrailerSize;
+    if (offset <= 0 || offset >= metaEnd || !file.seek(offset)) {
+        return;
+    }
+    try {
+        const QByteArray meta = file.read(metaEnd - offset);
+        auto jsonData = nlohmann::json::from_cbor(meta.constData(), meta.constData() + meta.size());
+        m_etag = jsonData.value("etag", "");
+        m_sequence = jsonData.value("seq", qint64(-1));
+    } catch (...) {
+        m_etag.clear();
+        m_sequence = -1;
+    }
+}
+
+ListingCache::~ListingCache() = default;
+
+/**
+ * @brief Streams the entries through the same SAX parser used for live listings.
+ *
+ * Parsing stops after the entries map; the metadata behind it is not read.
+ */
+bool ListingCache::replay(const APIClient::ListingCallback &onBatch) const
+{
+    if (m_etag.empty()) {
+        return false;
+    }
+    std::ifstream in(QFile::encodeName(m_path).toStdString(), std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    ListingParser parser(onBatch, kReplayBatchSize);
+    return nlohmann::json::sax_parse(in, &parser, nlohmann::json::input_format_t::cbor, false) && parser.flush();
+}
+
+/**
+ * @brief Opens a new cache file and writes the entries map header and array start.
+ */
+bool ListingCache::beginWrite()
+{
+    m_writer.reset(new QSaveFile(m_path));
+    if (!m_writer->open(QIODevice::WriteOnly)) {
+        m_writer.reset();
+        return false;
+    }
+    writeBytes(*m_writer, { 0xa1 });              // map with one pair
+    writeBytes(*m_writer, cborText("files"));
+    writeBytes(*m_writer, { 0x9f });              // array of unknown length
+    return true;
+}
+
+/**
+ * @brief Encodes each entry as its own CBOR map, so nothing accumulates in memory.
+ */
+void ListingCache::append(const std::vector<APIClient::RemoteFile> &files)
+{
+    if (!m_writer) {
+        return;
+    }
+    for (const APIClient::RemoteFile &file : files) {
+        nlohmann::json entry = { { "name", file.name.toStdString() } };
+        if (file.size >= 0)
+            entry["size"] = file.size;
+        if (file.modified > 0)
+            entry["mtime"] = file.modified;
+        if (!file.contentHash.isEmpty())
+            entry["hash"] = file.contentHash.toStdString();
+        if (!file.mimeType.isEmpty())
+            entry["mime"] = file.mimeType.toStdString();
+        writeBytes(*m_writer, nlohmann::json::to_cbor(entry));
+    }
+}
+
+/**
+ * @brief Closes the array, appends the metadata and its offset, and swaps the file into place.
+ */
+bool ListingCache::commit(const std::string &etag, qint64 sequence)
+{
+    if (!m_writer) {
+        return false;
+    }
+    if (etag.empty()) {
+        clear();
+        return false;
+    }
+
+    writeBytes(*m_writer, { 0xff });              // end of array
+    const qint64 offset = m_writer->pos();
+    writeBytes(*m_writer, nlohmann::json::to_cbor({ { "etag", etag }, { "seq", sequence } }));
+    std::vector<uint8_t> trailer = { 0x1b };      // uint64, eight bytes follow
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        trailer.push_back(static_cast<uint8_t>(offset >> shift));
+    }
+    writeBytes(*m_writer, trailer);
+    const bool committed = m_writer->commit();
+    m_writer.reset();
+    if (!committed) {
+        return false;
+    }
+    m_etag = etag;
+    m_sequence = sequence;
+    return true;
+}
+
+/**
+ * @brief Removes the cache file; the next listing is fetched unconditionally.
+ */
+void ListingCache::clear()
+{
+    if (m_writer) {
+        m_writer->cancelWriting();
+        m_writer.reset();
+    }
+    QFile::remove(m_path);
+    m_etag.clear();
+    m_sequence = -1;
+}
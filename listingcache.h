@@ -0,0 +1,85 @@
+#ifndef LISTINGCACHE_H
+#define LISTINGCACHE_H
+
+#include <QString>
+#include <memory>
+#include <vector>
+#include "APIClient.h"
+
+class QSaveFile;
+
+/**
+ * @class ListingCache
+ * @brief On-disk copy of the last complete file listing from one server.
+ *
+ * Stored under QStandardPaths::CacheLocation as one file per server, a CBOR
+ * sequence of three items:
+ *   - the entries, {"files": [...]}, the same shape as a listing page, written
+ *     as an indefinite-length array while the listing streams in;
+ *   - {"etag": ..., "seq": ...} for those entries;
+ *   - the file offset of that map as a fixed-width uint64, so the ETag is read
+ *     from the end without scanning the entries.
+ * The file is written through QSaveFile, so the ETag and its entries are replaced
+ * together by one rename; two clients listing at once can never leave one's
+ * ETag paired with the other's entries.
+ *
+ * APIClient sends the cached ETag as If-None-Match and replays the cache when
+ * the server answers 304 Not Modified.
+ */
+class ListingCache {
+public:
+    /**
+     * @brief Opens the cache belonging to @p serverUrl and reads its ETag and sequence.
+     */
+    explicit ListingCache(const QString &serverUrl);
+    ~ListingCache();
+
+    ListingCache(const ListingCache &) = delete;
+    ListingCache &operator=(const ListingCache &) = delete;
+
+    /**
+     * @brief Returns the ETag of the cached listing, or an empty string if there is none.
+     */
+    const std::string &etag() const { return m_etag; }
+
+    /**
+     * @brief Returns the change sequence of the cached listing, or -1.
+     */
+    qint64 sequence() const { return m_sequence; }
+
+    /**
+     * @brief Feeds the cached entries to @p onBatch in batches, as a listing would.
+     * @return false if the cache is missing or damaged, or the callback stopped it.
+     */
+    bool replay(const APIClient::ListingCallback &onBatch) const;
+
+    /**
+     * @brief Starts replacing the cache; the old copy stays valid until commit().
+     */
+    bool beginWrite();
+
+    /**
+     * @brief Appends entries to the copy being written.
+     */
+    void append(const std::vector<APIClient::RemoteFile> &files);
+
+    /**
+     * @brief Finishes the copy being written, tagged with @p etag and @p sequence, and makes it current.
+     *
+     * Without an ETag the copy could never be revalidated, so it is dropped along with the old one.
+     */
+    bool commit(const std::string &etag, qint64 sequence);
+
+    /**
+     * @brief Drops the copy being written and forgets the cached listing.
+     */
+    void clear();
+
+private:
+    QString m_path;          ///< CBOR file holding the entries, ETag and sequence
+    std::string m_etag;
+    qint64 m_sequence = -1;
+    std::unique_ptr<QSaveFile> m_writer;  ///< Open while a new copy is being written
+};
+
+#endif // LISTINGCACHE_H
@@ -0,0 +1,269 @@
+#include "listingparser.h"
+#include <QByteArray>
+#include <algorithm>
+
+/**
+ * @brief Constructs a parser that delivers entries in groups of @p batchSize.
+ */
+ListingParser::ListingParser(BatchCallback onBatch, size_t batchSize)
+    : m_onBatch(std::move(onBatch)), m_batchSize(std::max<size_t>(1, batchSize))
+{
+    m_pending.reserve(m_batchSize);
+}
+
+/**
+ * @brief Hands the pending entries to the callback and starts a new batch.
+ */
+bool ListingParser::flush()
+{
+    if (m_pending.empty()) {
+        return true;
+    }
+    bool keepGoing = !m_onBatch || m_onBatch(m_pending);
+    m_pending.clear();
+    return keepGoing;
+}
+
+/**
+ * @brief Queues @p file and delivers the batch once it is full.
+ */
+bool ListingParser::add(APIClient::RemoteFile &&file)
+{
+    m_pending.push_back(std::move(file));
+    ++m_count;
+    return m_pending.size() < m_batchSize || flush();
+}
+
+/**
+ * @brief Scalars outside an entry only matter as the value of "next", which they clear.
+ */
+bool ListingParser::value()
+{
+    if (m_depth == 1 && m_field == Field::Next) {
+        m_next.clear();
+    }
+    if (m_depth == 1) {
+        m_field = Field::None;
+    }
+    return true;
+}
+
+/**
+ * @brief Sizes and times may arrive as any numeric type depending on the encoding.
+ */
+bool ListingParser::number(qint64 number)
+{
+    if (inEntry()) {
+        if (m_entryField == EntryField::Size) {
+            m_entry.size = number;
+        } else if (m_entryField == EntryField::Modified) {
+            m_entry.modified = number;
+        }
+        m_entryField = EntryField::None;
+        return true;
+    }
+    if (m_depth == 1 && m_field == Field::Sequence) {
+        m_sequence = number;
+    }
+    return value();
+}
+
+bool ListingParser::null()
+{
+    m_entryField = EntryField::None;
+    return value();
+}
+
+bool ListingParser::boolean(bool)
+{
+    m_entryField = EntryField::None;
+    return value();
+}
+
+bool ListingParser::number_integer(number_integer_t number)
+{
+    return this->number(static_cast<qint64>(number));
+}
+
+bool ListingParser::number_unsigned(number_unsigned_t number)
+{
+    return this->number(static_cast<qint64>(number));
+}
+
+bool ListingParser::number_float(number_float_t number, const string_t &)
+{
+    return this->number(static_cast<qint64>(number));
+}
+
+/**
+ * @brief A CBOR byte string is only expected as an entry's hash.
+ */
+bool ListingParser::binary(binary_t &bytes)
+{
+    if (inEntry() && m_entryField == EntryField::Hash) {
+        QByteArray raw(reinterpret_cast<const char *>(bytes.data()), static_cast<int>(bytes.size()));
+        m_entry.contentHash = QString::fromLatin1(raw.toHex());
+        m_entryField = EntryField::None;
+        return true;
+    }
+    m_entryField = EntryField::None;
+    return value();
+}
+
+/**
+ * @brief Collects bare names, entry members, and the cursor after "next".
+ */
+bool ListingParser::string(string_t &text)
+{
+    if (m_depth == m_filesDepth) {
+        APIClient::RemoteFile file;
+        file.name = QString::fromStdString(text);
+        return add(std::move(file));
+    }
+    if (inEntry()) {
+        switch (m_entryField) {
+        case EntryField::Name: m_entry.name = QString::fromStdString(text); break;
+        case EntryField::Hash: m_entry.contentHash = QString::fromStdString(text); break;
+        case EntryField::Mime: m_entry.mimeType = QString::fromStdString(text); break;
+        default: break;
+        }
+        m_entryField = EntryField::None;
+        return true;
+    }
+    if (m_depth == 1 && m_field == Field::Next) {
+        m_next = std::move(text);
+        m_field = Field::None;
+        return true;
+    }
+    return value();
+}
+
+/**
+ * @brief A top-level object marks a paginated page; one in the file array starts an entry.
+ */
+bool ListingParser::start_object(std::size_t)
+{
+    if (m_depth == 0) {
+        m_paginated = true;
+    } else if (m_depth == 1) {
+        m_field = Field::None;
+    }
+    if (m_depth == m_filesDepth) {
+        m_entry = APIClient::RemoteFile();
+    }
+    m_entryField = EntryField::None;
+    ++m_depth;
+    return true;
+}
+
+/**
+ * @brief Remembers which top-level key or entry member the next value belongs to.
+ */
+bool ListingParser::key(string_t &name)
+{
+    if (m_depth == 1) {
+        if (name == "files")
+            m_field = Field::Files;
+        else if (name == "next")
+            m_field = Field::Next;
+        else if (name == "seq")
+            m_field = Field::Sequence;
+        else
+            m_field = Field::None;
+    } else if (inEntry()) {
+        if (name == "name")
+            m_entryField = EntryField::Name;
+        else if (name == "size")
+            m_entryField = EntryField::Size;
+        else if (name == "mtime")
+            m_entryField = EntryField::Modified;
+        else if (name == "hash")
+            m_entryField = EntryField::Hash;
+        else if (name == "mime")
+            m_entryField = EntryField::Mime;
+        else
+            m_entryField = EntryField::None;
+    }
+    return true;
+}
+
+/**
+ * @brief Queues an entry when its object closes; entries without a name are dropped.
+ */
+bool ListingParser::end_object()
+{
+    --m_depth;
+    if (m_depth == m_filesDepth && !m_entry.name.isEmpty()) {
+        return add(std::move(m_entry));
+    }
+    return true;
+}
+
+/**
+ * @brief Enters the file array: the whole document, or the value of "files".
+ */
+bool ListingParser::start_array(std::size_t)
+{
+    if (m_depth == 0 || (m_depth == 1 && m_field == Field::Files)) {
+        m_filesDepth = m_depth + 1;
+    }
+    if (m_depth == 1) {
+        m_field = Field::None;
+    }
+    m_entryField = EntryField::None;
+    ++m_depth;
+    return true;
+}
+
+bool ListingParser::end_array()
+{
+    if (m_depth == m_filesDepth) {
+        m_filesDepth = -1;
+    }
+    --m_depth;
+    return true;
+}
+
+/**
+ * @brief Stops on malformed input; entries already delivered stay delivered.
+ */
+bool ListingParser::parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &)
+{
+    return false;
+}
+
+/**
+ * @brief Builds a RemoteFile from an entry object, leaving absent fields unknown.
+ */
+APIClient::RemoteFile ListingParser::entryFromJson(const nlohmann::json &object)
+{
+    APIClient::RemoteFile file;
+    file.name = QString::fromStdString(object.value("name", std::string()));
+    file.size = object.value("size", qint64(-1));
+    file.modified = object.value("mtime", qint64(0));
+    file.contentHash = QString::fromStdString(object.value("hash", std::string()));
+    file.mimeType = QString::fromStdString(object.value("mime", std::string()));
+    return file;
+}
+
+/**
+ * @brief Decodes an add, remove or rename journal entry.
+ */
+bool ListingParser::changeFromJson(const nlohmann::json &entry, APIClient::FileChange &change)
+{
+    const std::string op = entry.value("op", std::string());
+    if (op == "add") {
+        change.type = APIClient::FileChange::Type::Added;
+        change.file = entryFromJson(entry.at("file"));
+    } else if (op == "remove") {
+        change.type = APIClient::FileChange::Type::Removed;
+        change.file.name = QString::fromStdString(entry.at("name").get<std::string>());
+    } else if (op == "rename") {
+        change.type = APIClient::FileChange::Type::Renamed;
+        change.oldName = QString::fromStdString(entry.at("from").get<std::string>());
+        change.file.name = QString::fromStdString(entry.at("to").get<std::string>());
+    } else {
+        return false;
+    }
+    return !change.file.name.isEmpty();
+}
@@ -0,0 +1,133 @@
+#ifndef LISTINGPARSER_H
+#define LISTINGPARSER_H
+
+#include "APIClient.h"
+#include <functional>
+#include <string>
+#include <vector>
+#include "json/json.hpp"
+
+/**
+ * @class ListingParser
+ * @brief SAX handler that turns a /api/files response into batches of file entries.
+ *
+ * Accepts both listing formats the server may send:
+ *   - a paginated page, {"files": [...], "next": "<cursor>" | null, "seq": <n>}
+ *   - a plain array, from servers without pagination
+ *
+ * Each file is either a bare name or an object
+ * {"name", "size", "mtime" (ms since the epoch), "hash", "mime"}. The same
+ * events arrive whether the body is JSON or CBOR; in CBOR the hash may be a
+ * byte string, which is stored as hex.
+ *
+ * Entries are handed to the batch callback every @p batchSize files while the
+ * document is still being parsed, so no DOM is built and the caller sees the
+ * first files before the rest of the body has arrived. Unknown keys are skipped.
+ */
+class ListingParser : public nlohmann::json_sax<nlohmann::json> {
+public:
+    /**
+     * @brief Receives parsed entries; returning false stops the parse.
+     */
+    using BatchCallback = APIClient::ListingCallback;
+
+    ListingParser(BatchCallback onBatch, size_t batchSize);
+
+    /**
+     * @brief Delivers any entries still pending; call once the parse succeeded.
+     * @return false if the callback asked to stop.
+     */
+    bool flush();
+
+    /**
+     * @brief Returns the cursor for the next page, or an empty string on the last page.
+     */
+    const std::string &nextCursor() const { return m_next; }
+
+    /**
+     * @brief Returns the server's change sequence the page was taken at, or -1 if not sent.
+     */
+    qint64 sequence() const { return m_sequence; }
+
+    /**
+     * @brief Returns true if the response was a page rather than a plain array.
+     */
+    bool paginated() const { return m_paginated; }
+
+    /**
+     * @brief Returns the number of entries parsed so far.
+     */
+    size_t count() const { return m_count; }
+
+    /**
+     * @brief Reads a file entry object already parsed into a DOM, as the change journal sends it.
+     */
+    static APIClient::RemoteFile entryFromJson(const nlohmann::json &object);
+
+    /**
+     * @brief Reads one change journal entry ({"op": "add" | "remove" | "rename", ...}).
+     * @return false for unknown operations and entries without a name.
+     */
+    static bool changeFromJson(const nlohmann::json &entry, APIClient::FileChange &change);
+
+    bool null() override;
+    bool boolean(bool value) override;
+    bool number_integer(number_integer_t value) override;
+    bool number_unsigned(number_unsigned_t value) override;
+    bool number_float(number_float_t value, const string_t &text) override;
+    bool string(string_t &value) override;
+    bool binary(binary_t &value) override;
+    bool start_object(std::size_t elements) override;
+    bool key(string_t &value) override;
+    bool end_object() override;
+    bool start_array(std::size_t elements) override;
+    bool end_array() override;
+    bool parse_error(std::size_t position, const std::string &lastToken,
+                     const nlohmann::detail::exception &error) override;
+
+private:
+    /**
+     * @brief Where the parser currently is relative to the file list.
+     */
+    enum class Field { None, Files, Next, Sequence };
+
+    /**
+     * @brief Member of a file entry whose value comes next.
+     */
+    enum class EntryField { None, Name, Size, Modified, Hash, Mime };
+
+    /**
+     * @brief Handles a scalar value at the current position.
+     */
+    bool value();
+
+    /**
+     * @brief Returns true while parsing the members of an object entry.
+     */
+    bool inEntry() const { return m_filesDepth > 0 && m_depth == m_filesDepth + 1; }
+
+    /**
+     * @brief Stores a numeric value in the current entry.
+     */
+    bool number(qint64 number);
+
+    /**
+     * @brief Queues a finished entry, flushing a full batch.
+     */
+    bool add(APIClient::RemoteFile &&file);
+
+    BatchCallback m_onBatch;
+    size_t m_batchSize;
+    std::vector<APIClient::RemoteFile> m_pending;  ///< Entries parsed but not yet delivered
+    APIClient::RemoteFile m_entry;   ///< Object entry being parsed
+    EntryField m_entryField = EntryField::None;
+    std::string m_next;
+    qint64 m_sequence = -1;
+    size_t m_count = 0;
+    int m_depth = 0;                 ///< Nesting depth of the value being parsed
+    int m_filesDepth = -1;           ///< Depth of the file array's elements, or -1 outside it
+    Field m_field = Field::None;     ///< Top-level key whose value comes next
+    bool m_paginated = false;
+};
+
+#endif // LISTINGPARSER_H
@@ -0,0 +1,61 @@
+#include "ratelimitdialog.h"
+#include "apiclient.h"
+#include "ratelimiter.h"
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QSpinBox>
+#include <QVBoxLayout>
+#include <algorithm>
+
+namespace {
+
+/// Bytes per unit shown in the spin boxes.
+constexpr qint64 kBytesPerKB = 1024;
+
+/// Largest limit that can be entered, in KB/s (about 1 GB/s).
+constexpr int kMaxKBPerSecond = 1024 * 1024;
+
+QSpinBox *createLimitBox(qint64 bytesPerSecond, QWidget *parent)
+{
+    QSpinBox *box = new QSpinBox(parent);
+    box->setRange(0, kMaxKBPerSecond);
+    box->setSuffix(" KB/s");
+    box->setSpecialValueText("Unlimited");
+    box->setValue(static_cast<int>(std::min<qint64>(bytesPerSecond / kBytesPerKB, kMaxKBPerSecond)));
+    return box;
+}
+
+} // namespace
+
+/**
+ * @brief Builds the form and fills it from the shared upload and download buckets.
+ */
+RateLimitDialog::RateLimitDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Transfer Limits");
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    QFormLayout *form = new QFormLayout();
+    m_upload = createLimitBox(RateLimiter::globalUpload().rate(), this);
+    m_download = createLimitBox(RateLimiter::globalDownload().rate(), this);
+    form->addRow("Upload:", m_upload);
+    form->addRow("Download:", m_download);
+    layout->addLayout(form);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+    layout->addWidget(buttons);
+    setLayout(layout);
+
+    connect(buttons, &QDialogButtonBox::accepted, this, &RateLimitDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+}
+
+/**
+ * @brief Hands the limits to APIClient, so running transfers slow down or speed up at once.
+ */
+void RateLimitDialog::accept()
+{
+    APIClient::setGlobalRateLimits(m_upload->value() * kBytesPerKB, m_download->value() * kBytesPerKB);
+    QDialog::accept();
+}
@@ -0,0 +1,37 @@
+#ifndef RATELIMITDIALOG_H
+#define RATELIMITDIALOG_H
+
+#include <QDialog>
+
+class QSpinBox;
+
+/**
+ * @class RateLimitDialog
+ * @brief Lets the user cap upload and download bandwidth for all transfers.
+ *
+ * Shows the current process-wide limits in KB/s (0 = unlimited) and applies
+ * them through APIClient::setGlobalRateLimits() when accepted, which also
+ * saves them for the next start.
+ */
+class RateLimitDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the dialog and loads the current limits.
+     * @param parent Optional parent widget.
+     */
+    explicit RateLimitDialog(QWidget *parent = nullptr);
+
+public slots:
+    /**
+     * @brief Applies the entered limits and closes the dialog.
+     */
+    void accept() override;
+
+private:
+    QSpinBox *m_upload;   ///< Upload cap in KB/s
+    QSpinBox *m_download; ///< Download cap in KB/s
+};
+
+#endif // RATELIMITDIALOG_H
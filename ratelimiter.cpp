@@ -0,0 +1,111 @@
+#include "ratelimiter.h"
+#include <QSettings>
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+/// Largest burst, as a fraction of one second of traffic.
+constexpr double kBurstSeconds = 0.25;
+
+} // namespace
+
+std::atomic<int> RateLimiter::s_interactive{0};
+
+/**
+ * @brief Creates a bucket that starts full.
+ */
+RateLimiter::RateLimiter(qint64 bytesPerSecond)
+    : m_rate(std::max<qint64>(0, bytesPerSecond)),
+      m_tokens(m_rate * kBurstSeconds),
+      m_lastRefill(Clock::now())
+{
+}
+
+/**
+ * @brief Changes the rate; accumulated debt is kept so a lowered limit takes effect at once.
+ */
+void RateLimiter::setRate(qint64 bytesPerSecond)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_rate = std::max<qint64>(0, bytesPerSecond);
+    m_tokens = std::min(m_tokens, m_rate * kBurstSeconds);
+    m_lastRefill = Clock::now();
+}
+
+/**
+ * @brief Returns the current rate in bytes per second (0 = unlimited).
+ */
+qint64 RateLimiter::rate() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_rate;
+}
+
+/**
+ * @brief Refills the bucket for the time elapsed, takes the tokens and sleeps off any debt.
+ *
+ * The debt is recorded before sleeping, so concurrent callers queue up behind
+ * each other instead of all waking at the same moment.
+ */
+void RateLimiter::consume(qint64 bytes)
+{
+    double waitSeconds = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_rate <= 0 || bytes <= 0)
+            return;
+
+        Clock::time_point now = Clock::now();
+        double elapsed = std::chrono::duration<double>(now - m_lastRefill).count();
+        m_lastRefill = now;
+        m_tokens = std::min(m_tokens + elapsed * m_rate, m_rate * kBurstSeconds);
+        m_tokens -= static_cast<double>(bytes);
+        if (m_tokens < 0)
+            waitSeconds = -m_tokens / m_rate;
+    }
+    if (waitSeconds > 0)
+        std::this_thread::sleep_for(std::chrono::duration<double>(waitSeconds));
+}
+
+/**
+ * @brief Returns the process-wide upload bucket.
+ */
+RateLimiter &RateLimiter::globalUpload()
+{
+    static RateLimiter limiter(QSettings("YourCompany", "LocalDrive").value("limits/upload", 0).toLongLong());
+    return limiter;
+}
+
+/**
+ * @brief Returns the process-wide download bucket.
+ */
+RateLimiter &RateLimiter::globalDownload()
+{
+    static RateLimiter limiter(QSettings("YourCompany", "LocalDrive").value("limits/download", 0).toLongLong());
+    return limiter;
+}
+
+/**
+ * @brief Reads the count of interactive requests in flight.
+ */
+int RateLimiter::interactiveCount()
+{
+    return std::max(0, s_interactive.load());
+}
+
+/**
+ * @brief Registers an interactive request.
+ */
+RateLimiter::InteractiveScope::InteractiveScope()
+{
+    ++s_interactive;
+}
+
+/**
+ * @brief Unregisters the interactive request.
+ */
+RateLimiter::InteractiveScope::~InteractiveScope()
+{
+    --s_interactive;
+}
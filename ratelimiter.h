@@ -0,0 +1,71 @@
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+/**
+ * @class RateLimiter
+ * @brief Thread-safe token bucket that paces a byte stream to a target rate.
+ *
+ * consume() takes tokens for bytes that are about to be (or were just)
+ * transferred and sleeps the calling thread when the bucket is in debt. The
+ * bucket holds at most a quarter second of tokens, so short idle periods do not
+ * turn into large bursts. A rate of 0 means unlimited.
+ *
+ * Two process-wide buckets cap all uploads and all downloads together; their
+ * rates start from QSettings ("limits/upload", "limits/download", in bytes per
+ * second) and follow setRate() from then on.
+ */
+class RateLimiter {
+public:
+    explicit RateLimiter(qint64 bytesPerSecond = 0);
+
+    RateLimiter(const RateLimiter &) = delete;
+    RateLimiter &operator=(const RateLimiter &) = delete;
+
+    void setRate(qint64 bytesPerSecond);
+    qint64 rate() const;
+
+    /**
+     * @brief Accounts for @p bytes and blocks until the stream is back under the rate.
+     */
+    void consume(qint64 bytes);
+
+    static RateLimiter &globalUpload();
+    static RateLimiter &globalDownload();
+
+    /**
+     * @brief Returns the number of interactive requests in flight.
+     *
+     * Background transfers give up a share of their time proportional to this
+     * so listings and small operations are not stuck behind bulk traffic.
+     */
+    static int interactiveCount();
+
+    /**
+     * @class InteractiveScope
+     * @brief Marks an interactive request as in flight for its lifetime.
+     */
+    class InteractiveScope {
+    public:
+        InteractiveScope();
+        ~InteractiveScope();
+        InteractiveScope(const InteractiveScope &) = delete;
+        InteractiveScope &operator=(const InteractiveScope &) = delete;
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    mutable std::mutex m_mutex;
+    qint64 m_rate;                  ///< Bytes per second, or 0 for unlimited
+    double m_tokens;                ///< Available bytes; negative while in debt
+    Clock::time_point m_lastRefill; ///< When m_tokens was last topped up
+
+    static std::atomic<int> s_interactive; ///< Number of interactive requests in flight
+};
+
+#endif // RATELIMITER_H
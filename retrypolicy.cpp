@@ -0,0 +1,86 @@
+#include "retrypolicy.h"
+#include <QUuid>
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+/**
+ * @brief Constructs a policy; @p maxAttempts counts the first try.
+ */
+RetryPolicy::RetryPolicy(int maxAttempts, std::chrono::milliseconds baseDelay, std::chrono::milliseconds maxDelay,
+                         std::chrono::milliseconds budget)
+    : m_maxAttempts(std::max(1, maxAttempts)), m_baseDelay(baseDelay), m_maxDelay(maxDelay), m_budget(budget)
+{
+}
+
+/**
+ * @brief Small requests retry quickly; transfers wait longer for a flaky link to recover.
+ */
+RetryPolicy RetryPolicy::forOperation(Operation operation)
+{
+    using std::chrono::milliseconds;
+    switch (operation) {
+    case Operation::Metadata:
+        return RetryPolicy(4, milliseconds(200), milliseconds(2000), milliseconds(10000));
+    case Operation::Batch:
+        return RetryPolicy(3, milliseconds(500), milliseconds(4000), milliseconds(20000));
+    case Operation::Transfer:
+        return RetryPolicy(5, milliseconds(500), milliseconds(8000), milliseconds(60000));
+    }
+    return RetryPolicy(1, milliseconds(0), milliseconds(0), milliseconds(0));
+}
+
+/**
+ * @brief Full jitter: uniform in [0, min(maxDelay, baseDelay * 2^(attempt-1))], never below Retry-After.
+ */
+std::chrono::milliseconds RetryPolicy::delayFor(int attempt, std::chrono::milliseconds retryAfter) const
+{
+    thread_local std::mt19937_64 rng(std::random_device{}());
+
+    const int shift = std::min(std::max(attempt - 1, 0), 20);
+    const long long ceiling = std::min<long long>(m_maxDelay.count(), m_baseDelay.count() << shift);
+    std::uniform_int_distribution<long long> pick(0, std::max(0LL, ceiling));
+    return std::max(std::chrono::milliseconds(pick(rng)), retryAfter);
+}
+
+/**
+ * @brief Checks both the attempt count and the time budget.
+ */
+bool RetryPolicy::allows(int attempt, std::chrono::milliseconds waited, std::chrono::milliseconds delay) const
+{
+    return attempt < m_maxAttempts && waited + delay <= m_budget;
+}
+
+/**
+ * @brief Timeouts, throttling and gateway errors are transient; other statuses are final.
+ */
+bool RetryPolicy::isTransientStatus(int status)
+{
+    switch (status) {
+    case 408: case 425: case 429: case 500: case 502: case 503: case 504:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Accepts a delay in whole seconds; anything else yields zero.
+ */
+std::chrono::milliseconds RetryPolicy::parseRetryAfter(const std::string &value)
+{
+    if (value.empty() || !std::all_of(value.begin(), value.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return std::chrono::milliseconds(0);
+    }
+    // Anything longer than a day is not worth honouring; the budget would reject it anyway.
+    long long seconds = value.size() > 6 ? 86400 : std::atoll(value.c_str());
+    return std::chrono::milliseconds(seconds * 1000);
+}
+
+/**
+ * @brief Uses a random (version 4) UUID.
+ */
+std::string RetryPolicy::newIdempotencyKey()
+{
+    return QUuid::createUuid().toString(QUuid::WithoutBraces).toStdString();
+}
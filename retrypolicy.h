@@ -0,0 +1,77 @@
+#ifndef RETRYPOLICY_H
+#define RETRYPOLICY_H
+
+#include <chrono>
+#include <string>
+
+/**
+ * @class RetryPolicy
+ * @brief Decides whether and when a failed request is tried again.
+ *
+ * Delays grow exponentially from a base delay up to a cap and are drawn with
+ * full jitter (uniformly between zero and the current ceiling), so clients
+ * that failed together do not retry together. Each kind of operation has a
+ * budget: a maximum number of attempts and a maximum total time spent waiting,
+ * after which the failure is reported to the caller.
+ *
+ * Only transient failures are retried: dropped or refused connections, timeouts,
+ * and 408, 425, 429, 500, 502, 503 and 504 responses. Mutating requests carry an
+ * Idempotency-Key header that stays the same across retries, so the server can
+ * recognise a repeat of a request it already applied and answer it again
+ * instead of applying it twice.
+ */
+class RetryPolicy {
+public:
+    /**
+     * @brief Kinds of operation, each with its own retry budget.
+     */
+    enum class Operation {
+        Metadata,  ///< Listings, renames, deletes and other small requests
+        Batch,     ///< Batch requests covering many files at once
+        Transfer   ///< Requests carrying file content
+    };
+
+    RetryPolicy(int maxAttempts, std::chrono::milliseconds baseDelay, std::chrono::milliseconds maxDelay,
+                std::chrono::milliseconds budget);
+
+    /**
+     * @brief Returns the default policy for an operation kind.
+     */
+    static RetryPolicy forOperation(Operation operation);
+
+    int maxAttempts() const { return m_maxAttempts; }
+
+    /**
+     * @brief Returns the jittered delay before retry number @p attempt (1 for the first retry).
+     * @param retryAfter Server-requested minimum wait from a Retry-After header, or zero.
+     */
+    std::chrono::milliseconds delayFor(int attempt, std::chrono::milliseconds retryAfter = {}) const;
+
+    /**
+     * @brief Returns true if retry number @p attempt, after @p waited and a further @p delay, fits the budget.
+     */
+    bool allows(int attempt, std::chrono::milliseconds waited, std::chrono::milliseconds delay) const;
+
+    /**
+     * @brief Returns true for HTTP statuses that are worth retrying.
+     */
+    static bool isTransientStatus(int status);
+
+    /**
+     * @brief Parses a Retry-After header given in seconds; HTTP dates are ignored.
+     */
+    static std::chrono::milliseconds parseRetryAfter(const std::string &value);
+
+    /**
+     * @brief Returns a fresh random key for the Idempotency-Key header.
+     */
+    static std::string newIdempotencyKey();
+
+private:
+    int m_maxAttempts;
+    std::chrono::milliseconds m_baseDelay;
+    std::chrono::milliseconds m_maxDelay;
+    std::chrono::milliseconds m_budget;   ///< Most total time spent waiting between attempts
+};
+
+#endif // RETRYPOLICY_H
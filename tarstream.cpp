@@ -0,0 +1,195 @@
+#include "tarstream.h"
+#include <QFileInfo>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "cpp-httplib/httplib.h"
+
+namespace {
+
+/// Block of file data read per provide() call.
+constexpr qint64 kReadSize = 64 * 1024;
+
+/// Largest size representable in the 11 octal digits of a ustar header.
+constexpr qint64 kMaxUstarSize = 077777777777LL;
+
+const char kZeros[512] = {};
+
+qint64 roundUpToBlock(qint64 value) {
+    return (value + 511) / 512 * 512;
+}
+
+/**
+ * @brief Writes @p value as a zero-padded octal field of @p width bytes, NUL-terminated.
+ */
+void putOctal(char *field, size_t width, qint64 value) {
+    std::snprintf(field, width, "%0*llo", static_cast<int>(width - 1), static_cast<unsigned long long>(value));
+}
+
+/**
+ * @brief Builds one 512-byte ustar header block.
+ */
+std::string ustarHeader(const std::string &name, qint64 size, qint64 mtime, char type) {
+    char block[512] = {};
+    std::memcpy(block, name.data(), std::min<size_t>(name.size(), 100));
+    putOctal(block + 100, 8, 0644);
+    putOctal(block + 108, 8, 0);
+    putOctal(block + 116, 8, 0);
+    putOctal(block + 124, 12, std::min(size, kMaxUstarSize));
+    putOctal(block + 136, 12, mtime);
+    block[156] = type;
+    std::memcpy(block + 257, "ustar", 6);
+    std::memcpy(block + 263, "00", 2);
+
+    // The checksum is computed with its own field filled with spaces.
+    std::memset(block + 148, ' ', 8);
+    unsigned int sum = 0;
+    for (unsigned char c : block) {
+        sum += c;
+    }
+    std::snprintf(block + 148, 8, "%06o", sum);
+    block[155] = ' ';
+    return std::string(block, sizeof(block));
+}
+
+/**
+ * @brief Formats a pax record "<len> key=value\n", where len counts the whole record.
+ */
+std::string paxRecord(const std::string &key, const std::string &value) {
+    size_t body = key.size() + value.size() + 3; // space, '=', newline
+    size_t length = body + 1;
+    while (std::to_string(length).size() + body > length) {
+        length++;
+    }
+    return std::to_string(length) + " " + key + "=" + value + "\n";
+}
+
+} // namespace
+
+/**
+ * @brief Creates an empty archive.
+ */
+TarStream::TarStream()
+    : m_buffer(static_cast<size_t>(kReadSize))
+{
+}
+
+/**
+ * @brief Closes the file being streamed, if any.
+ */
+TarStream::~TarStream() = default;
+
+/**
+ * @brief Records the entry and its headers; file contents are read later by provide().
+ */
+bool TarStream::addFile(const QString &localPath, const QString &archiveName)
+{
+    QFileInfo info(localPath);
+    if (!info.isFile()) {
+        return false;
+    }
+
+    const std::string name = archiveName.toUtf8().toStdString();
+    const qint64 size = info.size();
+    const qint64 mtime = info.lastModified().toSecsSinceEpoch();
+
+    std::string header;
+    std::string pax;
+    if (name.size() > 100) {
+        pax += paxRecord("path", name);
+    }
+    if (size > kMaxUstarSize) {
+        pax += paxRecord("size", std::to_string(size));
+    }
+    if (!pax.empty()) {
+        header = ustarHeader("PaxHeader", static_cast<qint64>(pax.size()), mtime, 'x');
+        header += pax;
+        header.append(static_cast<size_t>(roundUpToBlock(static_cast<qint64>(pax.size())) - pax.size()), '\0');
+    }
+    header += ustarHeader(name, size, mtime, '0');
+
+    Entry entry;
+    entry.localPath = localPath;
+    entry.header = std::move(header);
+    entry.size = size;
+    entry.start = m_entriesEnd;
+    entry.length = static_cast<qint64>(entry.header.size()) + roundUpToBlock(size);
+    m_entriesEnd += entry.length;
+    m_entries.push_back(std::move(entry));
+    return true;
+}
+
+/**
+ * @brief Opens the file behind an entry, closing the previous one.
+ */
+bool TarStream::openEntry(size_t index)
+{
+    if (m_openIndex == index) {
+        return m_file.isOpen();
+    }
+    m_file.close();
+    m_file.setFileName(m_entries[index].localPath);
+    m_openIndex = index;
+    return m_file.open(QIODevice::ReadOnly);
+}
+
+/**
+ * @brief Emits the header, data or padding of the entry covering @p offset, or the trailer.
+ *
+ * A file that shrank or became unreadable since addFile() is padded with zeros
+ * to its announced size and reported through unreadable().
+ */
+bool TarStream::provide(qint64 offset, httplib::DataSink &sink)
+{
+    qint64 written = 0;
+    bool ok = true;
+
+    // A retried request starts again from the top; only what this pass reads counts.
+    if (offset == 0) {
+        m_unreadable.clear();
+    }
+
+    if (offset >= m_entriesEnd) {
+        written = std::min(kBlockSize, contentLength() - offset);
+        ok = sink.write(kZeros, static_cast<size_t>(written));
+    } else {
+        // A retried request starts again from the top of the archive.
+        if (offset < m_entries[m_cursor].start) {
+            m_cursor = 0;
+        }
+        while (offset >= m_entries[m_cursor].start + m_entries[m_cursor].length) {
+            m_cursor++;
+        }
+        const Entry &entry = m_entries[m_cursor];
+        const qint64 local = offset - entry.start;
+        const qint64 headerSize = static_cast<qint64>(entry.header.size());
+
+        if (local < headerSize) {
+            written = headerSize - local;
+            ok = sink.write(entry.header.data() + local, static_cast<size_t>(written));
+        } else if (local - headerSize < entry.size) {
+            const qint64 dataOffset = local - headerSize;
+            written = std::min(kReadSize, entry.size - dataOffset);
+            qint64 bytesRead = -1;
+            if (openEntry(m_cursor) && (m_file.pos() == dataOffset || m_file.seek(dataOffset))) {
+                bytesRead = m_file.read(m_buffer.data(), written);
+            }
+            if (bytesRead < written) {
+                std::memset(m_buffer.data() + std::max<qint64>(0, bytesRead), 0,
+                            static_cast<size_t>(written - std::max<qint64>(0, bytesRead)));
+                if (m_unreadable.empty() || m_unreadable.back() != m_cursor) {
+                    m_unreadable.push_back(m_cursor);
+                }
+            }
+            ok = sink.write(m_buffer.data(), static_cast<size_t>(written));
+        } else {
+            written = entry.length - local;
+            ok = sink.write(kZeros, static_cast<size_t>(written));
+        }
+    }
+
+    if (!ok) {
+        return false;
+    }
+    return !m_progress || m_progress(offset + written, contentLength());
+}
@@ -0,0 +1,89 @@
+#ifndef TARSTREAM_H
+#define TARSTREAM_H
+
+#include <QFile>
+#include <QString>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace httplib {
+struct DataSink;
+}
+
+/**
+ * @class TarStream
+ * @brief A POSIX tar (pax/ustar) archive of local files, generated on demand.
+ *
+ * The archive is never materialised: its exact length is computed from the file
+ * sizes when entries are added, and provide() produces any requested byte range
+ * by reading the current file through a small buffer. Names that do not fit the
+ * 100-byte ustar field, and files of 8 GiB or more, get a pax extended header.
+ */
+class TarStream {
+public:
+    TarStream();
+    ~TarStream();
+
+    TarStream(const TarStream &) = delete;
+    TarStream &operator=(const TarStream &) = delete;
+
+    /**
+     * @brief Appends a regular file to the archive.
+     * @param localPath The file on disk.
+     * @param archiveName The path stored in the archive, using '/' separators.
+     * @return false if the file does not exist or is not a regular file.
+     */
+    bool addFile(const QString &localPath, const QString &archiveName);
+
+    /**
+     * @brief Returns the total archive length, including the end-of-archive blocks.
+     */
+    qint64 contentLength() const { return m_entriesEnd + kTrailerSize; }
+
+    /**
+     * @brief Writes the next piece of the archive starting at @p offset into @p sink.
+     *
+     * Offsets must be requested in increasing order, as httplib does.
+     * @return false if the connection was closed or the progress callback cancelled.
+     */
+    bool provide(qint64 offset, httplib::DataSink &sink);
+
+    /**
+     * @brief Sets a callback invoked with (bytes written, contentLength()) after each piece.
+     */
+    void setProgress(const std::function<bool(qint64, qint64)> &progress) { m_progress = progress; }
+
+    /**
+     * @brief Returns the indices of entries whose file could not be read completely.
+     *
+     * Such entries are padded with zeros so the archive stays well formed. The list
+     * covers the latest pass over the archive; it is cleared when offset 0 is requested again.
+     */
+    const std::vector<size_t> &unreadable() const { return m_unreadable; }
+
+private:
+    static constexpr qint64 kBlockSize = 512;
+    static constexpr qint64 kTrailerSize = 2 * kBlockSize;
+
+    struct Entry {
+        QString localPath;
+        std::string header; ///< Optional pax header plus the ustar header
+        qint64 size;        ///< File data length
+        qint64 start;       ///< Archive offset of the first header byte
+        qint64 length;      ///< Header, data and padding to the next block
+    };
+
+    bool openEntry(size_t index);
+
+    std::vector<Entry> m_entries;
+    qint64 m_entriesEnd = 0;              ///< Archive offset just past the last entry
+    size_t m_cursor = 0;                  ///< Entry containing the last requested offset
+    QFile m_file;                         ///< File of the entry being streamed
+    size_t m_openIndex = size_t(-1);      ///< Entry whose file is open
+    std::vector<char> m_buffer;
+    std::vector<size_t> m_unreadable;
+    std::function<bool(qint64, qint64)> m_progress;
+};
+
+#endif // TARSTREAM_H
@@ -0,0 +1,157 @@
+#include "apimetrics.h"
+#include "APIClient.h"
+#include "localserver.h"
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// Requests timed by the overhead check.
+constexpr int kRequests = 500;
+
+/// Relative error a percentile may have with 16 sub-buckets per power of two.
+constexpr double kResolution = 1.0 / 16;
+
+} // namespace
+
+/**
+ * @class TestAPIMetrics
+ * @brief Checks histogram percentiles and request counting, and that recording stays under 1% of a request.
+ */
+class TestAPIMetrics : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void percentilesWithinResolution();
+    void requestsAreCounted();
+    void recordCost();
+    void overheadUnderOnePercent();
+
+private:
+    QTemporaryDir m_dir;
+    std::unique_ptr<LocalServer> m_server;
+};
+
+/**
+ * @brief Keeps settings read by the client out of the user's configuration.
+ */
+void TestAPIMetrics::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+}
+
+/**
+ * @brief Zeroes the metrics and starts a server that accepts renames.
+ */
+void TestAPIMetrics::init()
+{
+    APIMetrics::instance().reset();
+    m_server = std::make_unique<LocalServer>();
+    m_server->server().Post("/api/rename", [](const httplib::Request &, httplib::Response &) {});
+    QVERIFY(m_server->start());
+}
+
+void TestAPIMetrics::cleanup()
+{
+    m_server.reset();
+}
+
+/**
+ * @brief Percentiles of a uniform 1..10000 us spread land within one sub-bucket of the truth.
+ */
+void TestAPIMetrics::percentilesWithinResolution()
+{
+    LatencyHistogram histogram;
+    for (qint64 micros = 1; micros <= 10000; ++micros)
+        histogram.record(micros);
+
+    QCOMPARE(histogram.count(), quint64(10000));
+    QCOMPARE(histogram.max(), qint64(10000));
+    QVERIFY(std::abs(histogram.mean() - 5000.5) < 0.01);
+    for (double percentile : { 50.0, 95.0, 99.0 }) {
+        const double exact = percentile * 100;
+        const double reported = double(histogram.percentile(percentile));
+        QVERIFY2(std::abs(reported - exact) <= exact * kResolution,
+                 qPrintable(QString("p%1 = %2").arg(percentile).arg(reported)));
+    }
+    QCOMPARE(histogram.percentile(100), qint64(10000));
+
+    histogram.reset();
+    QCOMPARE(histogram.count(), quint64(0));
+    QCOMPARE(histogram.percentile(50), qint64(0));
+}
+
+/**
+ * @brief Each request lands in its endpoint's counters, and later requests reuse the pooled connection.
+ */
+void TestAPIMetrics::requestsAreCounted()
+{
+    APIClient client(m_server->url());
+    for (int i = 0; i < 10; ++i)
+        QVERIFY(client.renameFile("a.txt", "b.txt"));
+
+    const nlohmann::json metrics = APIMetrics::instance().toJson();
+    const nlohmann::json &rename = metrics.at("endpoints").at("/api/rename");
+    QCOMPARE(rename.at("requests").get<quint64>(), quint64(10));
+    QCOMPARE(rename.at("errors").get<quint64>(), quint64(0));
+    QVERIFY(rename.at("bytesOut").get<quint64>() > 0);
+    QVERIFY(rename.at("latencyUs").at("p50").get<qint64>() > 0);
+    QVERIFY(metrics.at("connections").at("reused").get<quint64>() >= 9);
+}
+
+/**
+ * @brief Times what every request pays for its metrics: one RequestTimer with bytes and a status.
+ */
+void TestAPIMetrics::recordCost()
+{
+    QBENCHMARK {
+        RequestTimer timer("/bench");
+        timer.addBytesOut(100);
+        timer.finish(200, 100);
+    }
+}
+
+/**
+ * @brief Compares the recording cost with the latency of a loopback request, the cheapest real case.
+ */
+void TestAPIMetrics::overheadUnderOnePercent()
+{
+    APIClient client(m_server->url());
+    QVERIFY(client.renameFile("a.txt", "b.txt"));  // Open the pooled connection first.
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < kRequests; ++i)
+        QVERIFY(client.renameFile("a.txt", "b.txt"));
+    const qint64 requestsNs = timer.nsecsElapsed();
+
+    timer.restart();
+    for (int i = 0; i < kRequests; ++i) {
+        RequestTimer record("/bench");
+        record.addBytesOut(100);
+        record.finish(200, 100);
+    }
+    const qint64 recordingNs = timer.nsecsElapsed();
+
+    const double overhead = double(recordingNs) / double(std::max<qint64>(1, requestsNs));
+    qInfo().noquote() << QString("%1 ns per request, %2 ns of it recording metrics (%3%)")
+                             .arg(requestsNs / kRequests)
+                             .arg(recordingNs / kRequests)
+                             .arg(overhead * 100, 0, 'f', 3);
+    QVERIFY(overhead < 0.01);
+}
+
+QTEST_GUILESS_MAIN(TestAPIMetrics)
+#include "tst_apimetrics.moc"
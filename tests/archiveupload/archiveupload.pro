@@ -0,0 +1,11 @@
+include(../tests.pri)
+include(../client.pri)
+
+TARGET = tst_archiveupload
+
+SOURCES += \
+    tst_archiveupload.cpp \
+    ../../folderuploader.cpp
+
+HEADERS += \
+    ../../folderuploader.h
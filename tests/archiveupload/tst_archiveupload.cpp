@@ -0,0 +1,351 @@
+#include "APIClient.h"
+#include "folderuploader.h"
+#include "localserver.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSettings>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "json/json.hpp"
+
+namespace {
+
+/// Files sent per benchmark iteration; files/sec is this over the reported time.
+constexpr int kBenchmarkFiles = 200;
+
+QByteArray randomData(int size, quint32 seed)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    QRandomGenerator generator(seed);
+    for (char &byte : data)
+        byte = static_cast<char>(generator.bounded(256));
+    return data;
+}
+
+bool writeFile(const QString &path, const QByteArray &data)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+/**
+ * @brief Splits a ustar/pax archive into (name, data) members, as the server would unpack it.
+ * @return false if the archive is truncated.
+ */
+bool unpackTar(const std::string &tar, std::vector<std::pair<std::string, std::string>> &members)
+{
+    std::string paxName;
+    size_t pos = 0;
+    while (pos + 512 <= tar.size()) {
+        const char *block = tar.data() + pos;
+        if (block[0] == '\0')
+            return true;
+        const size_t size = std::strtoull(block + 124, nullptr, 8);
+        if (pos + 512 + size > tar.size())
+            return false;
+        std::string data = tar.substr(pos + 512, size);
+        pos += 512 + (size + 511) / 512 * 512;
+
+        if (block[156] == 'x') {
+            // Records are "<length> key=value\n"; only the path is used here.
+            size_t key = data.find(" path=");
+            if (key != std::string::npos)
+                paxName = data.substr(key + 6, data.find('\n', key) - key - 6);
+            continue;
+        }
+        members.emplace_back(paxName.empty() ? std::string(block, strnlen(block, 100)) : paxName, data);
+        paxName.clear();
+    }
+    return false;
+}
+
+} // namespace
+
+/**
+ * @class TestArchiveUpload
+ * @brief Compares archive and per-file uploads of small files, and checks FolderUploader's routing.
+ *
+ * The server stands in for /api/upload/archive: it unpacks the tar, stores each
+ * member, and answers with one result per member, so everything the client
+ * reports can be checked against what actually arrived.
+ */
+class TestArchiveUpload : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void archiveReportsEachMember();
+    void folderUploaderSendsLargeFilesAlone();
+
+    void filesPerSecond_data();
+    void filesPerSecond();
+    void folderTree_data();
+    void folderTree();
+
+private:
+    /**
+     * @brief One stored file and the endpoint it came through.
+     */
+    struct Stored {
+        QByteArray content;
+        std::string endpoint;  ///< "archive" or "file"
+    };
+
+    std::map<std::string, Stored> stored();
+
+    QTemporaryDir m_dir;
+    std::unique_ptr<LocalServer> m_server;
+
+    std::mutex m_mutex;
+    std::map<std::string, Stored> m_stored;
+};
+
+/**
+ * @brief Keeps settings read by the client out of the user's configuration.
+ */
+void TestArchiveUpload::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+}
+
+/**
+ * @brief Starts a server with both upload endpoints; members under "rejected/" are refused.
+ */
+void TestArchiveUpload::init()
+{
+    m_stored.clear();
+    m_server = std::make_unique<LocalServer>();
+    m_server->server().Post("/api/upload", [this](const httplib::Request &req, httplib::Response &res) {
+        if (!req.has_file("file")) {
+            res.status = 400;
+            return;
+        }
+        const httplib::MultipartFormData file = req.get_file_value("file");
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stored[file.filename] = { QByteArray::fromStdString(file.content), "file" };
+    });
+    m_server->server().Post("/api/upload/archive", [this](const httplib::Request &req, httplib::Response &res) {
+        std::vector<std::pair<std::string, std::string>> members;
+        if (!unpackTar(req.body, members)) {
+            res.status = 400;
+            return;
+        }
+        nlohmann::json results = nlohmann::json::array();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto &member : members) {
+            if (member.first.rfind("rejected/", 0) == 0) {
+                results.push_back({ { "ok", false }, { "error", "Name not allowed" } });
+                continue;
+            }
+            m_stored[member.first] = { QByteArray::fromStdString(member.second), "archive" };
+            results.push_back({ { "ok", true } });
+        }
+        res.set_content(nlohmann::json{ { "results", results } }.dump(), "application/json");
+    });
+    QVERIFY(m_server->start());
+}
+
+void TestArchiveUpload::cleanup()
+{
+    m_server.reset();
+}
+
+std::map<std::string, TestArchiveUpload::Stored> TestArchiveUpload::stored()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stored;
+}
+
+/**
+ * @brief Per-member results follow the server's answer, and stored members match the local files.
+ */
+void TestArchiveUpload::archiveReportsEachMember()
+{
+    const QByteArray first = randomData(1000, 1);
+    const QByteArray second = randomData(3000, 2);
+    const QByteArray third = randomData(70000, 3);
+    QVERIFY(writeFile(m_dir.filePath("members/a.bin"), first));
+    QVERIFY(writeFile(m_dir.filePath("members/b.bin"), second));
+    QVERIFY(writeFile(m_dir.filePath("members/c.bin"), third));
+
+    APIClient client(m_server->url());
+    auto results = client.uploadArchive({ { m_dir.filePath("members/a.bin"), "kept/a.bin" },
+                                          { m_dir.filePath("members/b.bin"), "rejected/b.bin" },
+                                          { m_dir.filePath("members/missing.bin"), "kept/missing.bin" },
+                                          { m_dir.filePath("members/c.bin"), "kept/c.bin" } });
+    QCOMPARE(results.size(), size_t(4));
+    QVERIFY(results[0].success);
+    QVERIFY(!results[1].success);
+    QCOMPARE(results[1].error, QString("Name not allowed"));
+    QVERIFY(!results[2].success);
+    QCOMPARE(results[2].error, QString("Not a readable file"));
+    QVERIFY(results[3].success);
+
+    std::map<std::string, Stored> files = stored();
+    QCOMPARE(files.size(), size_t(2));
+    QCOMPARE(files["kept/a.bin"].content, first);
+    QCOMPARE(files["kept/c.bin"].content, third);
+}
+
+/**
+ * @brief Files of 1 MiB or more go through /api/upload; smaller ones through the archive endpoint.
+ */
+void TestArchiveUpload::folderUploaderSendsLargeFilesAlone()
+{
+    const QByteArray small = randomData(1024, 4);
+    const QByteArray medium = randomData(64 * 1024, 5);
+    const QByteArray large = randomData(1024 * 1024 + 100, 6);
+    QVERIFY(writeFile(m_dir.filePath("tree/small.bin"), small));
+    QVERIFY(writeFile(m_dir.filePath("tree/sub/medium.bin"), medium));
+    QVERIFY(writeFile(m_dir.filePath("tree/sub/large.bin"), large));
+
+    FolderUploader uploader(m_server->url());
+    QSignalSpy finished(&uploader, &FolderUploader::finished);
+    QVERIFY(uploader.start(m_dir.filePath("tree")));
+    QVERIFY(finished.wait(30000));
+    QCOMPARE(finished.at(0).at(0).toInt(), 3);
+    QCOMPARE(finished.at(0).at(1).toInt(), 0);
+
+    std::map<std::string, Stored> files = stored();
+    QCOMPARE(files.size(), size_t(3));
+    QCOMPARE(files["tree/small.bin"].content, small);
+    QCOMPARE(files["tree/small.bin"].endpoint, std::string("archive"));
+    QCOMPARE(files["tree/sub/medium.bin"].content, medium);
+    QCOMPARE(files["tree/sub/medium.bin"].endpoint, std::string("archive"));
+    QCOMPARE(files["tree/sub/large.bin"].content, large);
+    QCOMPARE(files["tree/sub/large.bin"].endpoint, std::string("file"));
+}
+
+/**
+ * @brief File sizes and upload modes to compare.
+ */
+void TestArchiveUpload::filesPerSecond_data()
+{
+    QTest::addColumn<int>("fileSize");
+    QTest::addColumn<bool>("archive");
+    QTest::newRow("200 x 1 KB, archive") << 1024 << true;
+    QTest::newRow("200 x 1 KB, per file") << 1024 << false;
+    QTest::newRow("200 x 64 KB, archive") << 64 * 1024 << true;
+    QTest::newRow("200 x 64 KB, per file") << 64 * 1024 << false;
+}
+
+/**
+ * @brief Times kBenchmarkFiles uploads in one archive request against one request per file.
+ *
+ * Every file is then checked on the server, so a fast but lossy mode cannot pass.
+ */
+void TestArchiveUpload::filesPerSecond()
+{
+    QFETCH(int, fileSize);
+    QFETCH(bool, archive);
+
+    std::vector<std::pair<QString, QString>> files;
+    std::vector<QByteArray> contents;
+    for (int i = 0; i < kBenchmarkFiles; ++i) {
+        contents.push_back(randomData(fileSize, quint32(100 + i)));
+        QString path = m_dir.filePath(QString("bench%1/%2.bin").arg(fileSize).arg(i));
+        QVERIFY(writeFile(path, contents.back()));
+        files.emplace_back(path, QString("bench/%1.bin").arg(i));
+    }
+
+    APIClient client(m_server->url());
+    int succeeded = 0;
+    QBENCHMARK {
+        succeeded = 0;
+        if (archive) {
+            for (const auto &result : client.uploadArchive(files))
+                succeeded += result.success ? 1 : 0;
+        } else {
+            for (const auto &file : files)
+                succeeded += client.uploadFile(file.first, nullptr, file.second) ? 1 : 0;
+        }
+    }
+    QCOMPARE(succeeded, kBenchmarkFiles);
+
+    std::map<std::string, Stored> received = stored();
+    QCOMPARE(received.size(), size_t(kBenchmarkFiles));
+    for (int i = 0; i < kBenchmarkFiles; ++i) {
+        const Stored &file = received[QString("bench/%1.bin").arg(i).toStdString()];
+        QCOMPARE(file.content, contents[size_t(i)]);
+        QCOMPARE(file.endpoint, std::string(archive ? "archive" : "file"));
+    }
+}
+
+/**
+ * @brief Tree sizes; files are spread over two directory levels so the walk runs in parallel.
+ */
+void TestArchiveUpload::folderTree_data()
+{
+    QTest::addColumn<int>("directories");
+    QTest::addColumn<int>("filesPerDirectory");
+    QTest::newRow("10k files") << 100 << 100;
+    QTest::newRow("100k files") << 1000 << 100;
+}
+
+/**
+ * @brief Times FolderUploader over a tree of small files and prints files/s and the time to the first stored batch.
+ */
+void TestArchiveUpload::folderTree()
+{
+    QFETCH(int, directories);
+    QFETCH(int, filesPerDirectory);
+    const QString root = m_dir.filePath(QString("tree%1").arg(directories));
+    for (int d = 0; d < directories; ++d) {
+        const QString directory = QString("%1/%2/%3").arg(root).arg(d % 10).arg(d);
+        QVERIFY(QDir().mkpath(directory));
+        for (int f = 0; f < filesPerDirectory; ++f) {
+            QFile file(QString("%1/%2.txt").arg(directory).arg(f));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(QString("%1/%2\n").arg(d).arg(f).toUtf8());
+        }
+    }
+    const int total = directories * filesPerDirectory;
+
+    FolderUploader uploader(m_server->url());
+    QSignalSpy finished(&uploader, &FolderUploader::finished);
+    QElapsedTimer timer;
+    std::atomic<qint64> firstStoredMs{-1};
+    connect(&uploader, &FolderUploader::filesUploaded, this, [&timer, &firstStoredMs](const QStringList &) {
+        qint64 unset = -1;
+        firstStoredMs.compare_exchange_strong(unset, timer.elapsed());
+    }, Qt::DirectConnection);
+
+    QBENCHMARK_ONCE {
+        timer.start();
+        QVERIFY(uploader.start(root));
+        QVERIFY(finished.wait(600000));
+    }
+    const qint64 elapsedMs = std::max<qint64>(1, timer.elapsed());
+    QCOMPARE(finished.at(0).at(0).toInt(), total);
+    QCOMPARE(finished.at(0).at(1).toInt(), 0);
+
+    std::map<std::string, Stored> files = stored();
+    QCOMPARE(files.size(), size_t(total));
+    const std::string prefix = QFileInfo(root).fileName().toStdString();
+    QCOMPARE(files[prefix + "/3/3/7.txt"].content, QByteArray("3/7\n"));
+    qInfo().noquote() << QString("%1: %2 files/s, first batch stored after %3 ms")
+                             .arg(QTest::currentDataTag())
+                             .arg(total * 1000.0 / elapsedMs, 0, 'f', 0)
+                             .arg(firstStoredMs.load());
+}
+
+QTEST_GUILESS_MAIN(TestArchiveUpload)
+#include "tst_archiveupload.moc"
@@ -0,0 +1,259 @@
+#include "APIClient.h"
+#include "localserver.h"
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "json/json.hpp"
+
+namespace {
+
+/// Items per batch request; kBatchSize in apiclient.cpp.
+constexpr int kBatchSize = 1000;
+
+} // namespace
+
+/**
+ * @class TestBatchOperations
+ * @brief Runs deleteFiles() and renameFiles() against a server that keeps a set of file names.
+ */
+class TestBatchOperations : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void deleteReportsEachItem();
+    void renameReportsEachItem();
+    void largeRequestsAreSplit();
+    void fallsBackWithoutBatchEndpoint_data();
+    void fallsBackWithoutBatchEndpoint();
+    void malformedReplyFailsTheGroup();
+
+private:
+    QTemporaryDir m_dir;
+    std::unique_ptr<LocalServer> m_server;
+
+    std::mutex m_mutex;
+    std::set<std::string> m_files;   ///< Names stored on the server
+    int m_batchRequests = 0;         ///< Requests to /api/batch/*
+    int m_singleRequests = 0;        ///< Requests to /api/delete and /api/rename
+    int m_batchStatus = 0;           ///< If set, the batch endpoints answer with this status instead
+    bool m_dropLastReply = false;    ///< Leave the last item out of batch replies
+};
+
+/**
+ * @brief Keeps settings read by the client out of the user's configuration.
+ */
+void TestBatchOperations::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+}
+
+/**
+ * @brief Starts a server with batch and single-item delete and rename endpoints.
+ *
+ * Batch replies carry one result per item in request order; deleting or renaming
+ * a missing file and renaming onto an existing name fail for that item only.
+ */
+void TestBatchOperations::init()
+{
+    m_files = { "a.txt", "b.txt", "c.txt" };
+    m_batchRequests = 0;
+    m_singleRequests = 0;
+    m_batchStatus = 0;
+    m_dropLastReply = false;
+
+    m_server = std::make_unique<LocalServer>();
+    auto removeFile = [this](const std::string &name) {
+        return m_files.erase(name) > 0 ? std::string() : std::string("No such file");
+    };
+    auto moveFile = [this](const std::string &from, const std::string &to) {
+        if (m_files.count(from) == 0)
+            return std::string("No such file");
+        if (m_files.count(to) > 0)
+            return std::string("Target exists");
+        m_files.erase(from);
+        m_files.insert(to);
+        return std::string();
+    };
+    auto batch = [this](const std::string &key, auto apply) {
+        return [this, key, apply](const httplib::Request &req, httplib::Response &res) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_batchRequests;
+            if (m_batchStatus != 0) {
+                res.status = m_batchStatus;
+                return;
+            }
+            nlohmann::json results = nlohmann::json::array();
+            for (const auto &item : nlohmann::json::parse(req.body).at(key)) {
+                const std::string error = apply(item);
+                results.push_back(error.empty() ? nlohmann::json{ { "ok", true } }
+                                                : nlohmann::json{ { "ok", false }, { "error", error } });
+            }
+            if (m_dropLastReply && !results.empty())
+                results.erase(results.size() - 1);
+            res.set_content(nlohmann::json{ { "results", results } }.dump(), "application/json");
+        };
+    };
+
+    m_server->server().Post("/api/batch/delete", batch("files", [removeFile](const nlohmann::json &item) {
+        return removeFile(item.get<std::string>());
+    }));
+    m_server->server().Post("/api/batch/rename", batch("renames", [moveFile](const nlohmann::json &item) {
+        return moveFile(item.at("old").get<std::string>(), item.at("new").get<std::string>());
+    }));
+    m_server->server().Post("/api/delete", [this, removeFile](const httplib::Request &req, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_singleRequests;
+        res.status = removeFile(req.get_param_value("file")).empty() ? 200 : 404;
+    });
+    m_server->server().Post("/api/rename", [this, moveFile](const httplib::Request &req, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_singleRequests;
+        res.status = moveFile(req.get_param_value("old"), req.get_param_value("new")).empty() ? 200 : 409;
+    });
+    QVERIFY(m_server->start());
+}
+
+/**
+ * @brief Stops the server so the next test gets a fresh port and connection pool entry.
+ */
+void TestBatchOperations::cleanup()
+{
+    m_server.reset();
+}
+
+/**
+ * @brief One request deletes what exists and reports the missing name on its own result.
+ */
+void TestBatchOperations::deleteReportsEachItem()
+{
+    auto results = APIClient(m_server->url()).deleteFiles({ "a.txt", "missing.txt", "c.txt" });
+    QCOMPARE(results.size(), size_t(3));
+    QCOMPARE(results[0].name, QString("a.txt"));
+    QVERIFY(results[0].success);
+    QCOMPARE(results[1].name, QString("missing.txt"));
+    QVERIFY(!results[1].success);
+    QCOMPARE(results[1].error, QString("No such file"));
+    QCOMPARE(results[2].name, QString("c.txt"));
+    QVERIFY(results[2].success);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_batchRequests, 1);
+    QCOMPARE(m_singleRequests, 0);
+    QCOMPARE(m_files, std::set<std::string>({ "b.txt" }));
+}
+
+/**
+ * @brief Renames apply in order, so a later rename onto a name taken earlier in the batch fails.
+ */
+void TestBatchOperations::renameReportsEachItem()
+{
+    auto results = APIClient(m_server->url())
+                       .renameFiles({ { "a.txt", "x.txt" }, { "missing.txt", "y.txt" }, { "b.txt", "x.txt" } });
+    QCOMPARE(results.size(), size_t(3));
+    QCOMPARE(results[0].name, QString("a.txt"));
+    QVERIFY(results[0].success);
+    QVERIFY(!results[1].success);
+    QCOMPARE(results[1].error, QString("No such file"));
+    QCOMPARE(results[2].name, QString("b.txt"));
+    QVERIFY(!results[2].success);
+    QCOMPARE(results[2].error, QString("Target exists"));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_batchRequests, 1);
+    QCOMPARE(m_files, std::set<std::string>({ "b.txt", "c.txt", "x.txt" }));
+}
+
+/**
+ * @brief More than kBatchSize items go out in several requests, with results kept in order.
+ */
+void TestBatchOperations::largeRequestsAreSplit()
+{
+    std::vector<QString> names;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int i = 0; i < 2 * kBatchSize + 500; ++i) {
+            names.push_back(QString("bulk/%1.txt").arg(i));
+            if (i % 2 == 0)
+                m_files.insert(names.back().toStdString());
+        }
+    }
+
+    auto results = APIClient(m_server->url()).deleteFiles(names);
+    QCOMPARE(results.size(), names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        QCOMPARE(results[i].name, names[i]);
+        QCOMPARE(results[i].success, i % 2 == 0);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_batchRequests, 3);
+    QCOMPARE(m_files.size(), size_t(3));
+}
+
+/**
+ * @brief Statuses that mean the server has no batch endpoint.
+ */
+void TestBatchOperations::fallsBackWithoutBatchEndpoint_data()
+{
+    QTest::addColumn<int>("status");
+    QTest::newRow("404") << 404;
+    QTest::newRow("405") << 405;
+}
+
+/**
+ * @brief Without a batch endpoint every item is sent on its own, once the first batch is refused.
+ */
+void TestBatchOperations::fallsBackWithoutBatchEndpoint()
+{
+    QFETCH(int, status);
+    m_batchStatus = status;
+
+    APIClient client(m_server->url());
+    auto deleted = client.deleteFiles({ "a.txt", "missing.txt" });
+    QCOMPARE(deleted.size(), size_t(2));
+    QVERIFY(deleted[0].success);
+    QVERIFY(!deleted[1].success);
+
+    auto renamed = client.renameFiles({ { "b.txt", "c.txt" }, { "b.txt", "d.txt" } });
+    QCOMPARE(renamed.size(), size_t(2));
+    QVERIFY(!renamed[0].success);
+    QVERIFY(renamed[1].success);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_batchRequests, 2);
+    QCOMPARE(m_singleRequests, 4);
+    QCOMPARE(m_files, std::set<std::string>({ "c.txt", "d.txt" }));
+}
+
+/**
+ * @brief A reply whose results do not line up with the request fails every item in it.
+ */
+void TestBatchOperations::malformedReplyFailsTheGroup()
+{
+    m_dropLastReply = true;
+    auto results = APIClient(m_server->url()).deleteFiles({ "a.txt", "b.txt" });
+    QCOMPARE(results.size(), size_t(2));
+    for (const auto &result : results) {
+        QVERIFY(!result.success);
+        QCOMPARE(result.error, QString("Batch request failed"));
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_singleRequests, 0);
+}
+
+QTEST_GUILESS_MAIN(TestBatchOperations)
+#include "tst_batchoperations.moc"
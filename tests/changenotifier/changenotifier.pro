@@ -0,0 +1,11 @@
+include(../tests.pri)
+include(../client.pri)
+
+TARGET = tst_changenotifier
+
+SOURCES += \
+    tst_changenotifier.cpp \
+    ../../changenotifier.cpp
+
+HEADERS += \
+    ../../changenotifier.h
@@ -0,0 +1,258 @@
+#include "changenotifier.h"
+#include "apimetrics.h"
+#include "localserver.h"
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using std::chrono::milliseconds;
+
+namespace {
+
+/**
+ * @brief Formats one "changes" event the way the server sends it.
+ */
+std::string changesEvent(qint64 sequence, const std::string &changes)
+{
+    return "id: " + std::to_string(sequence) + "\nevent: changes\ndata: {\"seq\": " + std::to_string(sequence)
+         + ", \"changes\": " + changes + "}\n\n";
+}
+
+/**
+ * @brief Returns a change list adding @p name.
+ */
+std::string added(const std::string &name)
+{
+    return R"([{"op": "add", "file": {"name": ")" + name + R"(", "size": 3}}])";
+}
+
+} // namespace
+
+/**
+ * @class TestChangeNotifier
+ * @brief Runs ChangeNotifier against a server that streams scripted events, one script per connection.
+ */
+class TestChangeNotifier : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void parsesEventStream();
+    void reconnectsAfterHeartbeatTimeout();
+    void resyncRequired_data();
+    void resyncRequired();
+    void deliveryTimeIsRecorded();
+
+private:
+    /**
+     * @brief Returns the "since" parameter of every stream request so far.
+     */
+    std::vector<qint64> requests();
+
+    QTemporaryDir m_dir;
+    std::unique_ptr<LocalServer> m_server;
+
+    std::mutex m_mutex;
+    std::vector<std::vector<std::string>> m_streams;  ///< Chunks sent on each connection, in order
+    std::vector<qint64> m_since;                      ///< "since" of each stream request
+    int m_status = 0;                                 ///< If set, stream requests get this status instead
+    std::atomic<bool> m_release{false};               ///< Ends streams that went silent
+};
+
+/**
+ * @brief Keeps settings read by the client out of the user's configuration.
+ */
+void TestChangeNotifier::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+}
+
+/**
+ * @brief Starts a server whose event stream sends the next script, then goes silent without closing.
+ */
+void TestChangeNotifier::init()
+{
+    m_streams.clear();
+    m_since.clear();
+    m_status = 0;
+    m_release = false;
+    APIMetrics::instance().reset();
+
+    m_server = std::make_unique<LocalServer>();
+    m_server->server().Get("/api/events", [this](const httplib::Request &req, httplib::Response &res) {
+        auto pending = std::make_shared<std::deque<std::string>>();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_since.push_back(std::stoll(req.get_param_value("since")));
+            if (m_status != 0) {
+                res.status = m_status;
+                return;
+            }
+            const size_t connection = m_since.size() - 1;
+            if (connection < m_streams.size())
+                pending->assign(m_streams[connection].begin(), m_streams[connection].end());
+        }
+        res.set_chunked_content_provider("text/event-stream", [this, pending](size_t, httplib::DataSink &sink) {
+            if (!pending->empty()) {
+                const std::string chunk = pending->front();
+                pending->pop_front();
+                return sink.write(chunk.data(), chunk.size());
+            }
+            // Silent from here on, like a stalled server or a dead route.
+            std::this_thread::sleep_for(milliseconds(10));
+            return !m_release.load();
+        });
+    });
+    QVERIFY(m_server->start());
+}
+
+/**
+ * @brief Ends silent streams so the server can stop.
+ */
+void TestChangeNotifier::cleanup()
+{
+    m_release = true;
+    m_server.reset();
+}
+
+std::vector<qint64> TestChangeNotifier::requests()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_since;
+}
+
+/**
+ * @brief Events split across chunks, with CRLF lines, multi-line data, heartbeats, unknown
+ *        event types and a replayed sequence, come out as exactly the two new change sets.
+ */
+void TestChangeNotifier::parsesEventStream()
+{
+    m_streams = { {
+        ": heartbeat\n\n",
+        "id: 1\r\nevent: changes\r\ndata: {\"seq\": 1,\r\n",
+        "data:  \"changes\": " + added("a.txt") + "}\r",
+        "\n\r\n",
+        "event: other\ndata: {\"seq\": 9}\n\n",
+        changesEvent(1, added("again.txt")),
+        ": heartbeat\n\ndata: {\"seq\": 2, \"changes\": [{\"op\": \"remove\", \"name\": \"a.txt\"}]}\n\n",
+    } };
+
+    std::vector<std::pair<QList<APIClient::FileChange>, qint64>> pushed;
+    ChangeNotifier notifier(m_server->url());
+    connect(&notifier, &ChangeNotifier::changesPushed, this,
+            [&pushed](const QList<APIClient::FileChange> &changes, qint64 sequence) {
+                pushed.emplace_back(changes, sequence);
+            });
+    notifier.start(0);
+
+    QTRY_COMPARE(pushed.size(), size_t(2));
+    QCOMPARE(pushed[0].second, qint64(1));
+    QCOMPARE(pushed[0].first.size(), 1);
+    QCOMPARE(pushed[0].first[0].type, APIClient::FileChange::Type::Added);
+    QCOMPARE(pushed[0].first[0].file.name, QString("a.txt"));
+    QCOMPARE(pushed[0].first[0].file.size, qint64(3));
+    QCOMPARE(pushed[1].second, qint64(2));
+    QCOMPARE(pushed[1].first.size(), 1);
+    QCOMPARE(pushed[1].first[0].type, APIClient::FileChange::Type::Removed);
+    QCOMPARE(requests(), std::vector<qint64>({ 0 }));
+}
+
+/**
+ * @brief A stream that stops sending heartbeats is reopened from the last sequence received.
+ */
+void TestChangeNotifier::reconnectsAfterHeartbeatTimeout()
+{
+    m_streams = { { changesEvent(5, added("first.txt")) }, { changesEvent(6, added("second.txt")) } };
+
+    std::vector<qint64> sequences;
+    ChangeNotifier notifier(m_server->url());
+    notifier.setHeartbeatTimeout(milliseconds(300));
+    connect(&notifier, &ChangeNotifier::changesPushed, this,
+            [&sequences](const QList<APIClient::FileChange> &, qint64 sequence) { sequences.push_back(sequence); });
+    notifier.start(4);
+
+    QTRY_COMPARE_WITH_TIMEOUT(sequences.size(), size_t(2), 5000);
+    QCOMPARE(sequences, std::vector<qint64>({ 5, 6 }));
+    QCOMPARE(requests(), std::vector<qint64>({ 4, 5 }));
+    const nlohmann::json metrics = APIMetrics::instance().toJson();
+    QVERIFY(metrics.at("endpoints").at("/api/events").at("retries").get<quint64>() >= 1);
+}
+
+/**
+ * @brief Both ways the server says it cannot replay from the requested sequence.
+ */
+void TestChangeNotifier::resyncRequired_data()
+{
+    QTest::addColumn<int>("status");
+    QTest::newRow("expired event") << 0;
+    QTest::newRow("410") << 410;
+}
+
+/**
+ * @brief resyncRequired() is emitted once and the notifier stops instead of reconnecting.
+ */
+void TestChangeNotifier::resyncRequired()
+{
+    QFETCH(int, status);
+    m_status = status;
+    m_streams = { { "event: expired\ndata: {}\n\n" } };
+
+    int resyncs = 0;
+    int pushes = 0;
+    ChangeNotifier notifier(m_server->url());
+    connect(&notifier, &ChangeNotifier::resyncRequired, this, [&resyncs]() { ++resyncs; });
+    connect(&notifier, &ChangeNotifier::changesPushed, this, [&pushes]() { ++pushes; });
+    notifier.start(3);
+
+    QTRY_COMPARE(resyncs, 1);
+    QTest::qWait(1000);
+    QCOMPARE(resyncs, 1);
+    QCOMPARE(pushes, 0);
+    QCOMPARE(requests(), std::vector<qint64>({ 3 }));
+}
+
+/**
+ * @brief Each change set adds one sample from its arrival to the return of its handlers,
+ *        so a slow handler shows up in the metric.
+ */
+void TestChangeNotifier::deliveryTimeIsRecorded()
+{
+    m_streams = { { changesEvent(1, added("a.txt")) + changesEvent(2, added("b.txt")) + changesEvent(3, added("c.txt")) } };
+
+    ChangeNotifier notifier(m_server->url());
+    connect(&notifier, &ChangeNotifier::changesPushed, this,
+            []() { std::this_thread::sleep_for(milliseconds(20)); });
+    notifier.start(0);
+
+    auto delivered = []() {
+        const nlohmann::json endpoints = APIMetrics::instance().toJson().at("endpoints");
+        return endpoints.contains(ChangeNotifier::kDeliveryEndpoint)
+                   ? endpoints.at(ChangeNotifier::kDeliveryEndpoint).at("requests").get<quint64>()
+                   : quint64(0);
+    };
+    QTRY_COMPARE(delivered(), quint64(3));
+
+    const nlohmann::json latency =
+        APIMetrics::instance().toJson().at("endpoints").at(ChangeNotifier::kDeliveryEndpoint).at("latencyUs");
+    QVERIFY(latency.at("p50").get<qint64>() >= 20000);
+    QVERIFY(latency.at("max").get<qint64>() < 5000000);
+}
+
+QTEST_GUILESS_MAIN(TestChangeNotifier)
+#include "tst_changenotifier.moc"
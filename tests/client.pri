@@ -0,0 +1,40 @@
+# Sources for tests that run APIClient against a LocalServer.
+
+QT += concurrent
+
+# gzip request/response bodies in cpp-httplib (see CompressionPolicy)
+DEFINES += CPPHTTPLIB_ZLIB_SUPPORT
+LIBS += -lz
+
+SOURCES += \
+    $$PWD/../apiclient.cpp \
+    $$PWD/../apimetrics.cpp \
+    $$PWD/../compressionpolicy.cpp \
+    $$PWD/../connectionpool.cpp \
+    $$PWD/../contentchunker.cpp \
+    $$PWD/../deltaencoder.cpp \
+    $$PWD/../downloadsink.cpp \
+    $$PWD/../filehasher.cpp \
+    $$PWD/../filetypes.cpp \
+    $$PWD/../listingcache.cpp \
+    $$PWD/../listingparser.cpp \
+    $$PWD/../ratelimiter.cpp \
+    $$PWD/../retrypolicy.cpp \
+    $$PWD/../tarstream.cpp
+
+HEADERS += \
+    $$PWD/localserver.h \
+    $$PWD/../apiclient.h \
+    $$PWD/../apimetrics.h \
+    $$PWD/../compressionpolicy.h \
+    $$PWD/../connectionpool.h \
+    $$PWD/../contentchunker.h \
+    $$PWD/../deltaencoder.h \
+    $$PWD/../downloadsink.h \
+    $$PWD/../filehasher.h \
+    $$PWD/../filetypes.h \
+    $$PWD/../listingcache.h \
+    $$PWD/../listingparser.h \
+    $$PWD/../ratelimiter.h \
+    $$PWD/../retrypolicy.h \
+    $$PWD/../tarstream.h
@@ -0,0 +1,292 @@
+#include "compressionpolicy.h"
+#include "APIClient.h"
+#include "localserver.h"
+#include <QBuffer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+QByteArray randomData(int size, quint32 seed)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    QRandomGenerator generator(seed);
+    for (char &byte : data)
+        byte = static_cast<char>(generator.bounded(256));
+    return data;
+}
+
+/**
+ * @brief Returns log-like text that gzip shrinks several times over.
+ */
+QByteArray textData(int lines)
+{
+    QByteArray data;
+    for (int i = 0; i < lines; ++i)
+        data += QString("%1 INFO transfer queue sampled %2 running jobs\n").arg(i).arg(i % 4).toUtf8();
+    return data;
+}
+
+bool writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+} // namespace
+
+/**
+ * @class TestCompressionPolicy
+ * @brief Checks which bodies are compressed, and that gzip uploads only go to servers that decode them.
+ */
+class TestCompressionPolicy : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void classify_data();
+    void classify();
+    void entropyOfSamples();
+    void shouldCompressFile();
+
+    void plainWithoutAdvertisedSupport();
+    void gzipWhenAdvertised();
+    void refusedGzipIsResentPlain();
+
+private:
+    /**
+     * @brief One /api/upload request as the server saw it.
+     */
+    struct Upload {
+        std::string encoding;       ///< Content-Encoding of the request body
+        std::string idempotencyKey;
+        QByteArray content;         ///< Decoded file part
+        int status = 0;
+    };
+
+    std::vector<Upload> uploads();
+
+    QTemporaryDir m_dir;
+    std::unique_ptr<LocalServer> m_server;
+
+    std::mutex m_mutex;
+    bool m_advertiseGzip = false;   ///< Answer OPTIONS /api/upload with Accept-Encoding: gzip
+    bool m_refuseGzip = false;      ///< Answer gzip bodies with 415 even so
+    std::vector<Upload> m_uploads;
+};
+
+/**
+ * @brief Keeps settings read by the client out of the user's configuration.
+ */
+void TestCompressionPolicy::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+}
+
+/**
+ * @brief Starts an upload server that records the encoding and decoded content of every body.
+ *
+ * Each test gets a new port, and with it a server the client has not probed yet.
+ */
+void TestCompressionPolicy::init()
+{
+    m_advertiseGzip = false;
+    m_refuseGzip = false;
+    m_uploads.clear();
+
+    m_server = std::make_unique<LocalServer>();
+    m_server->server().Options("/api/upload", [this](const httplib::Request &, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_advertiseGzip)
+            res.set_header("Accept-Encoding", "gzip, deflate");
+        res.status = 204;
+    });
+    m_server->server().Post("/api/upload", [this](const httplib::Request &req, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Upload upload;
+        upload.encoding = req.get_header_value("Content-Encoding");
+        upload.idempotencyKey = req.get_header_value("Idempotency-Key");
+        if (req.has_file("file"))
+            upload.content = QByteArray::fromStdString(req.get_file_value("file").content);
+        upload.status = (m_refuseGzip && !upload.encoding.empty()) ? 415 : 200;
+        res.status = upload.status;
+        m_uploads.push_back(upload);
+    });
+    QVERIFY(m_server->start());
+}
+
+void TestCompressionPolicy::cleanup()
+{
+    m_server.reset();
+}
+
+std::vector<TestCompressionPolicy::Upload> TestCompressionPolicy::uploads()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_uploads;
+}
+
+/**
+ * @brief File names and the decision their extension alone gives.
+ */
+void TestCompressionPolicy::classify_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<int>("decision");
+    const int compress = int(CompressionPolicy::Decision::Compress);
+    const int skip = int(CompressionPolicy::Decision::Skip);
+    const int unknown = int(CompressionPolicy::Decision::Unknown);
+    QTest::newRow("txt") << "notes.txt" << compress;
+    QTest::newRow("csv upper case") << "DATA.CSV" << compress;
+    QTest::newRow("html") << "index.html" << compress;
+    QTest::newRow("json") << "listing.json" << compress;
+    QTest::newRow("wav") << "take.wav" << compress;
+    QTest::newRow("jpg") << "photo.jpg" << skip;
+    QTest::newRow("mp4") << "clip.mp4" << skip;
+    QTest::newRow("flac") << "song.flac" << skip;
+    QTest::newRow("unknown extension") << "blob.xyz" << unknown;
+    QTest::newRow("no extension") << "Makefile" << unknown;
+}
+
+/**
+ * @brief Text and raw formats compress, self-compressed formats are skipped, the rest need a sample.
+ */
+void TestCompressionPolicy::classify()
+{
+    QFETCH(QString, name);
+    QFETCH(int, decision);
+    QCOMPARE(int(CompressionPolicy::classify(name)), decision);
+}
+
+/**
+ * @brief Uniform bytes sample near 0 bits per byte, random bytes near 8, and the position is kept.
+ */
+void TestCompressionPolicy::entropyOfSamples()
+{
+    QByteArray zeros(256 * 1024, '\0');
+    QBuffer uniform(&zeros);
+    QVERIFY(uniform.open(QIODevice::ReadOnly));
+    QVERIFY(CompressionPolicy::sampleEntropy(uniform) < 0.01);
+
+    QByteArray noise = randomData(256 * 1024, 1);
+    QBuffer random(&noise);
+    QVERIFY(random.open(QIODevice::ReadOnly));
+    QVERIFY(random.seek(1000));
+    QVERIFY(CompressionPolicy::sampleEntropy(random) > 7.9);
+    QCOMPARE(random.pos(), qint64(1000));
+
+    QByteArray text = textData(2000);
+    QBuffer log(&text);
+    QVERIFY(log.open(QIODevice::ReadOnly));
+    QVERIFY(CompressionPolicy::sampleEntropy(log) < 6.0);
+
+    QByteArray nothing;
+    QBuffer empty(&nothing);
+    QVERIFY(empty.open(QIODevice::ReadOnly));
+    QCOMPARE(CompressionPolicy::sampleEntropy(empty), 8.0);
+}
+
+/**
+ * @brief Unknown types are judged by their contents; tiny files are never compressed.
+ */
+void TestCompressionPolicy::shouldCompressFile()
+{
+    QVERIFY(writeFile(m_dir.filePath("text.dat"), textData(2000)));
+    QVERIFY(CompressionPolicy::shouldCompressFile(m_dir.filePath("text.dat")));
+
+    QVERIFY(writeFile(m_dir.filePath("noise.dat"), randomData(64 * 1024, 2)));
+    QVERIFY(!CompressionPolicy::shouldCompressFile(m_dir.filePath("noise.dat")));
+
+    QVERIFY(writeFile(m_dir.filePath("text.jpg"), textData(2000)));
+    QVERIFY(!CompressionPolicy::shouldCompressFile(m_dir.filePath("text.jpg")));
+
+    QVERIFY(writeFile(m_dir.filePath("tiny.txt"), "short"));
+    QVERIFY(!CompressionPolicy::shouldCompressFile(m_dir.filePath("tiny.txt")));
+
+    QVERIFY(!CompressionPolicy::shouldCompressFile(m_dir.filePath("missing.txt")));
+}
+
+/**
+ * @brief A server that does not advertise gzip gets the text file as-is.
+ */
+void TestCompressionPolicy::plainWithoutAdvertisedSupport()
+{
+    const QByteArray text = textData(2000);
+    QVERIFY(writeFile(m_dir.filePath("plain.log"), text));
+
+    APIClient client(m_server->url());
+    QVERIFY(client.uploadFile(m_dir.filePath("plain.log")));
+    QVERIFY(!client.lastCompression().compressed);
+
+    std::vector<Upload> received = uploads();
+    QCOMPARE(received.size(), size_t(1));
+    QVERIFY(received[0].encoding.empty());
+    QCOMPARE(received[0].content, text);
+}
+
+/**
+ * @brief A server that advertises gzip gets a smaller encoded body that decodes to the file.
+ */
+void TestCompressionPolicy::gzipWhenAdvertised()
+{
+    m_advertiseGzip = true;
+    const QByteArray text = textData(2000);
+    QVERIFY(writeFile(m_dir.filePath("packed.log"), text));
+
+    APIClient client(m_server->url());
+    QVERIFY(client.uploadFile(m_dir.filePath("packed.log")));
+    const CompressionReport &report = client.lastCompression();
+    QVERIFY(report.compressed);
+    QVERIFY(report.wireBytes > 0 && report.wireBytes < report.rawBytes / 3);
+    QVERIFY(report.ratio() > 3.0);
+
+    std::vector<Upload> received = uploads();
+    QCOMPARE(received.size(), size_t(1));
+    QCOMPARE(received[0].encoding, std::string("gzip"));
+    QCOMPARE(received[0].content, text);
+}
+
+/**
+ * @brief A 415 for the encoded body brings one plain re-send, and later uploads skip gzip.
+ */
+void TestCompressionPolicy::refusedGzipIsResentPlain()
+{
+    m_advertiseGzip = true;
+    m_refuseGzip = true;
+    const QByteArray text = textData(2000);
+    QVERIFY(writeFile(m_dir.filePath("refused.log"), text));
+
+    APIClient client(m_server->url());
+    QVERIFY(client.uploadFile(m_dir.filePath("refused.log")));
+    QVERIFY(!client.lastCompression().compressed);
+
+    std::vector<Upload> received = uploads();
+    QCOMPARE(received.size(), size_t(2));
+    QCOMPARE(received[0].encoding, std::string("gzip"));
+    QCOMPARE(received[0].status, 415);
+    QVERIFY(received[1].encoding.empty());
+    QCOMPARE(received[1].status, 200);
+    QCOMPARE(received[1].content, text);
+    QVERIFY(received[1].idempotencyKey != received[0].idempotencyKey);
+
+    QVERIFY(client.uploadFile(m_dir.filePath("refused.log")));
+    received = uploads();
+    QCOMPARE(received.size(), size_t(3));
+    QVERIFY(received[2].encoding.empty());
+}
+
+QTEST_GUILESS_MAIN(TestCompressionPolicy)
+#include "tst_compressionpolicy.moc"
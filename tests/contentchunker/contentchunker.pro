@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_contentchunker
+
+SOURCES += \
+    tst_contentchunker.cpp \
+    $$PWD/../../contentchunker.cpp
+
+HEADERS += \
+    $$PWD/../../contentchunker.h
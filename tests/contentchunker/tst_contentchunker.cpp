@@ -0,0 +1,290 @@
+#include "contentchunker.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QtTest>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+/// Test data size; about 64 chunks at the default 64 KiB average.
+constexpr int kDataSize = 4 * 1024 * 1024;
+
+/// Data chunked per benchmark iteration.
+constexpr int kBenchmarkSize = 64 * 1024 * 1024;
+
+QByteArray randomData(int size, quint32 seed)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    QRandomGenerator generator(seed);
+    for (char &byte : data)
+        byte = static_cast<char>(generator.bounded(256));
+    return data;
+}
+
+std::vector<ContentChunker::Chunk> chunkAll(const QByteArray &data)
+{
+    QByteArray copy = data;
+    QBuffer buffer(&copy);
+    buffer.open(QIODevice::ReadOnly);
+    std::vector<ContentChunker::Chunk> chunks;
+    if (!ContentChunker().chunk(buffer, chunks))
+        chunks.clear();
+    return chunks;
+}
+
+QSet<QByteArray> hashes(const std::vector<ContentChunker::Chunk> &chunks)
+{
+    QSet<QByteArray> result;
+    for (const ContentChunker::Chunk &chunk : chunks)
+        result.insert(chunk.hash);
+    return result;
+}
+
+/**
+ * @brief A device that delivers some bytes and then reports a read error.
+ */
+class FailingDevice : public QIODevice
+{
+public:
+    explicit FailingDevice(qint64 goodBytes) : m_left(goodBytes) {}
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        if (m_left <= 0)
+            return -1;
+        qint64 length = std::min(maxSize, m_left);
+        std::memset(data, 'a', static_cast<size_t>(length));
+        m_left -= length;
+        return length;
+    }
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    qint64 m_left;
+};
+
+} // namespace
+
+/**
+ * @class TestContentChunker
+ * @brief Checks FastCDC chunk bounds, coverage and stability under edits.
+ */
+class TestContentChunker : public QObject
+{
+    Q_OBJECT
+private slots:
+    void chunksCoverInputWithinBounds();
+    void hashesMatchChunkContents();
+    void emptyInputHasNoChunks();
+    void uniformInputCutsAtMaximum();
+    void cutPointsSurviveInsertion();
+    void cutPointsSurviveShift();
+    void readErrorFails();
+    void progressCanCancel();
+
+    void throughput_data();
+    void throughput();
+    void bytesSavedAfterEdits();
+};
+
+/**
+ * @brief Chunks are contiguous, cover the input, and only the last may be under the minimum.
+ */
+void TestContentChunker::chunksCoverInputWithinBounds()
+{
+    const QByteArray data = randomData(kDataSize, 1);
+    const std::vector<ContentChunker::Chunk> chunks = chunkAll(data);
+    QVERIFY(chunks.size() > 1);
+
+    qint64 offset = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        QCOMPARE(chunks[i].offset, offset);
+        QVERIFY(chunks[i].length <= 256 * 1024);
+        if (i + 1 < chunks.size())
+            QVERIFY(chunks[i].length >= 16 * 1024);
+        offset += chunks[i].length;
+    }
+    QCOMPARE(offset, qint64(kDataSize));
+}
+
+/**
+ * @brief Each chunk carries the hex SHA-256 of exactly its own bytes.
+ */
+void TestContentChunker::hashesMatchChunkContents()
+{
+    const QByteArray data = randomData(kDataSize / 4, 2);
+    for (const ContentChunker::Chunk &chunk : chunkAll(data)) {
+        QByteArray expected = QCryptographicHash::hash(data.mid(static_cast<int>(chunk.offset),
+                                                                static_cast<int>(chunk.length)),
+                                                       QCryptographicHash::Sha256).toHex();
+        QCOMPARE(chunk.hash, expected);
+    }
+}
+
+/**
+ * @brief An empty device succeeds without producing chunks.
+ */
+void TestContentChunker::emptyInputHasNoChunks()
+{
+    QByteArray empty;
+    QBuffer buffer(&empty);
+    buffer.open(QIODevice::ReadOnly);
+    std::vector<ContentChunker::Chunk> chunks;
+    QVERIFY(ContentChunker().chunk(buffer, chunks));
+    QVERIFY(chunks.empty());
+}
+
+/**
+ * @brief Data without any cut point is split at the maximum size.
+ */
+void TestContentChunker::uniformInputCutsAtMaximum()
+{
+    const std::vector<ContentChunker::Chunk> chunks = chunkAll(QByteArray(1024 * 1024, '\0'));
+    QCOMPARE(chunks.size(), size_t(4));
+    for (const ContentChunker::Chunk &chunk : chunks)
+        QCOMPARE(chunk.length, qint64(256 * 1024));
+}
+
+/**
+ * @brief Inserting bytes in the middle only changes the chunks around the edit.
+ */
+void TestContentChunker::cutPointsSurviveInsertion()
+{
+    const QByteArray original = randomData(kDataSize, 3);
+    QByteArray edited = original;
+    edited.insert(kDataSize / 2, QByteArray(100, 'x'));
+
+    const std::vector<ContentChunker::Chunk> before = chunkAll(original);
+    const std::vector<ContentChunker::Chunk> after = chunkAll(edited);
+    const QSet<QByteArray> known = hashes(before);
+    int shared = 0;
+    for (const ContentChunker::Chunk &chunk : after)
+        shared += known.contains(chunk.hash) ? 1 : 0;
+    QVERIFY2(shared >= static_cast<int>(after.size()) - 2,
+             qPrintable(QString("%1 of %2 chunks reused").arg(shared).arg(after.size())));
+}
+
+/**
+ * @brief Prepending data shifts every offset but keeps the chunks after the first.
+ */
+void TestContentChunker::cutPointsSurviveShift()
+{
+    const QByteArray original = randomData(kDataSize, 4);
+    const QByteArray shifted = randomData(1000, 5) + original;
+
+    const QSet<QByteArray> known = hashes(chunkAll(original));
+    const std::vector<ContentChunker::Chunk> after = chunkAll(shifted);
+    int shared = 0;
+    for (const ContentChunker::Chunk &chunk : after)
+        shared += known.contains(chunk.hash) ? 1 : 0;
+    QVERIFY2(shared >= static_cast<int>(after.size()) - 2,
+             qPrintable(QString("%1 of %2 chunks reused").arg(shared).arg(after.size())));
+}
+
+/**
+ * @brief A read error is reported instead of being taken for the end of the data.
+ */
+void TestContentChunker::readErrorFails()
+{
+    FailingDevice device(600 * 1024);
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    std::vector<ContentChunker::Chunk> chunks;
+    QVERIFY(!ContentChunker().chunk(device, chunks));
+}
+
+/**
+ * @brief Returning false from the progress callback stops chunking.
+ */
+void TestContentChunker::progressCanCancel()
+{
+    QByteArray data = randomData(kDataSize, 6);
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    std::vector<ContentChunker::Chunk> chunks;
+    qint64 lastReported = 0;
+    QVERIFY(!ContentChunker().chunk(buffer, chunks, [&](qint64 chunked) {
+        lastReported = chunked;
+        return chunked < kDataSize / 2;
+    }));
+    QVERIFY(lastReported >= kDataSize / 2);
+    QVERIFY(lastReported < kDataSize);
+}
+
+/**
+ * @brief Finding cut points alone, and the full pass that also hashes every chunk.
+ */
+void TestContentChunker::throughput_data()
+{
+    QTest::addColumn<bool>("hashed");
+    QTest::newRow("cut points") << false;
+    QTest::newRow("cut points and SHA-256") << true;
+}
+
+/**
+ * @brief Chunks kBenchmarkSize random bytes and prints GB/s.
+ */
+void TestContentChunker::throughput()
+{
+    QFETCH(bool, hashed);
+    QByteArray data = randomData(kBenchmarkSize, 7);
+    const ContentChunker chunker;
+    size_t chunkCount = 0;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        if (hashed) {
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::ReadOnly);
+            std::vector<ContentChunker::Chunk> chunks;
+            QVERIFY(chunker.chunk(buffer, chunks));
+            chunkCount = chunks.size();
+        } else {
+            const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.constData());
+            size_t offset = 0;
+            chunkCount = 0;
+            while (offset < size_t(data.size())) {
+                offset += chunker.cut(bytes + offset, size_t(data.size()) - offset);
+                ++chunkCount;
+            }
+        }
+    }
+    const qint64 elapsedNs = std::max<qint64>(1, timer.nsecsElapsed());
+    QVERIFY(chunkCount > 0);
+    qInfo().noquote() << QString("%1: %2 GB/s, %3 chunks")
+                             .arg(QTest::currentDataTag())
+                             .arg(double(kBenchmarkSize) / elapsedNs, 0, 'f', 2)
+                             .arg(chunkCount);
+}
+
+/**
+ * @brief Counts the chunk bytes a re-upload must send after ten scattered small edits.
+ */
+void TestContentChunker::bytesSavedAfterEdits()
+{
+    const QByteArray original = randomData(4 * kDataSize, 8);
+    QByteArray edited = original;
+    QRandomGenerator generator(9);
+    for (int i = 0; i < 10; ++i)
+        edited.insert(generator.bounded(edited.size()), randomData(100, quint32(10 + i)));
+
+    const QSet<QByteArray> known = hashes(chunkAll(original));
+    qint64 sent = 0;
+    for (const ContentChunker::Chunk &chunk : chunkAll(edited)) {
+        if (!known.contains(chunk.hash))
+            sent += chunk.length;
+    }
+    qInfo().noquote() << QString("%1 of %2 bytes sent, %3% saved")
+                             .arg(sent)
+                             .arg(edited.size())
+                             .arg(100.0 - 100.0 * sent / edited.size(), 0, 'f', 1);
+    QVERIFY(sent < edited.size() / 4);
+}
+
+QTEST_APPLESS_MAIN(TestContentChunker)
+#include "tst_contentchunker.moc"
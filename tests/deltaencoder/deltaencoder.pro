@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_deltaencoder
+
+SOURCES += \
+    tst_deltaencoder.cpp \
+    $$PWD/../../deltaencoder.cpp
+
+HEADERS += \
+    $$PWD/../../deltaencoder.h
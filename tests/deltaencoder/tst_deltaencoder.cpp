@@ -0,0 +1,321 @@
+#include "deltaencoder.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QtTest>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+/// Block size used for the round trips; small enough to give many blocks.
+constexpr size_t kBlockSize = 2048;
+
+QByteArray randomData(int size, quint32 seed)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    QRandomGenerator generator(seed);
+    for (char &byte : data)
+        byte = static_cast<char>(generator.bounded(256));
+    return data;
+}
+
+/// Size of the file used by the wire-bytes benchmark.
+constexpr int kBenchmarkSize = 32 * 1024 * 1024;
+
+/// Signature bytes per block on the wire: the weak checksum and the MD5.
+constexpr qint64 kSignatureEntrySize = 4 + 16;
+
+/**
+ * @brief Computes the server's signature of @p old: one entry per full block.
+ */
+std::vector<DeltaEncoder::Block> signatureOf(const QByteArray &old, size_t blockSize = kBlockSize)
+{
+    std::vector<DeltaEncoder::Block> blocks;
+    for (int offset = 0; offset + static_cast<int>(blockSize) <= old.size(); offset += static_cast<int>(blockSize)) {
+        QByteArray block = old.mid(offset, static_cast<int>(blockSize));
+        blocks.push_back({ DeltaEncoder::weakChecksum(reinterpret_cast<const uint8_t *>(block.constData()), blockSize),
+                           QCryptographicHash::hash(block, QCryptographicHash::Md5) });
+    }
+    return blocks;
+}
+
+/**
+ * @brief Reads the little-endian integers of a delta stream, failing on truncation.
+ */
+class DeltaReader {
+public:
+    explicit DeltaReader(const QByteArray &delta) : m_delta(delta) {}
+
+    bool bytes(int length, QByteArray &out)
+    {
+        if (length < 0 || m_pos + length > m_delta.size())
+            return false;
+        out = m_delta.mid(m_pos, length);
+        m_pos += length;
+        return true;
+    }
+
+    bool integer(int width, quint64 &value)
+    {
+        QByteArray raw;
+        if (!bytes(width, raw))
+            return false;
+        value = 0;
+        for (int i = width - 1; i >= 0; --i)
+            value = (value << 8) | static_cast<quint8>(raw[i]);
+        return true;
+    }
+
+    bool atEnd() const { return m_pos == m_delta.size(); }
+
+private:
+    const QByteArray &m_delta;
+    int m_pos = 0;
+};
+
+/**
+ * @brief Rebuilds the new file from @p old and @p delta, as the server does.
+ * @return false if the stream is malformed or its final MD5 does not match.
+ */
+bool applyDelta(const QByteArray &old, const QByteArray &delta, QByteArray &result)
+{
+    DeltaReader reader(delta);
+    QByteArray magic;
+    quint64 blockSize = 0;
+    quint64 targetSize = 0;
+    if (!reader.bytes(8, magic) || magic != "LDDELTA1" || !reader.integer(4, blockSize) ||
+        !reader.integer(8, targetSize))
+        return false;
+
+    result.clear();
+    for (;;) {
+        QByteArray op;
+        if (!reader.bytes(1, op))
+            return false;
+        if (op == "L") {
+            quint64 length = 0;
+            QByteArray literal;
+            if (!reader.integer(4, length) || !reader.bytes(static_cast<int>(length), literal))
+                return false;
+            result.append(literal);
+        } else if (op == "C") {
+            quint64 first = 0;
+            quint64 count = 0;
+            if (!reader.integer(4, first) || !reader.integer(4, count))
+                return false;
+            if ((first + count) * blockSize > static_cast<quint64>(old.size()))
+                return false;
+            result.append(old.mid(static_cast<int>(first * blockSize), static_cast<int>(count * blockSize)));
+        } else if (op == "E") {
+            QByteArray digest;
+            if (!reader.bytes(16, digest) || !reader.atEnd())
+                return false;
+            return static_cast<quint64>(result.size()) == targetSize &&
+                   digest == QCryptographicHash::hash(result, QCryptographicHash::Md5);
+        } else {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Encodes @p updated against @p old and checks that applying the delta gives it back.
+ */
+bool encodeAndApply(const QByteArray &old, const QByteArray &updated, DeltaEncoder::Stats &stats)
+{
+    DeltaEncoder encoder(kBlockSize, signatureOf(old));
+    QByteArray delta;
+    QBuffer out(&delta);
+    out.open(QIODevice::WriteOnly);
+    if (!encoder.encode(reinterpret_cast<const uint8_t *>(updated.constData()), updated.size(), out, nullptr, &stats))
+        return false;
+    QByteArray rebuilt;
+    return applyDelta(old, delta, rebuilt) && rebuilt == updated && stats.deltaBytes == delta.size();
+}
+
+} // namespace
+
+/**
+ * @class TestDeltaEncoder
+ * @brief Round-trips edited files through DeltaEncoder and a reference decoder.
+ */
+class TestDeltaEncoder : public QObject
+{
+    Q_OBJECT
+private slots:
+    void weakChecksumMatchesDefinition();
+    void blockSizeForFile();
+    void roundTrip_data();
+    void roundTrip();
+    void unchangedFileIsAllCopies();
+    void insertionOnlySendsTheEdit();
+    void cancelStopsEncoding();
+
+    void wireBytes_data();
+    void wireBytes();
+};
+
+/**
+ * @brief The weak checksum follows rsync's a/b definition.
+ */
+void TestDeltaEncoder::weakChecksumMatchesDefinition()
+{
+    const uint8_t data[] = { 1, 2, 3, 250 };
+    // a = 1 + 2 + 3 + 250, b = 4*1 + 3*2 + 2*3 + 1*250
+    const uint32_t expected = 256u | (266u << 16);
+    QCOMPARE(DeltaEncoder::weakChecksum(data, 4), expected);
+    QCOMPARE(DeltaEncoder::weakChecksum(data, 0), 0u);
+}
+
+/**
+ * @brief Block sizes are powers of two near the square root, within 2 KiB..128 KiB.
+ */
+void TestDeltaEncoder::blockSizeForFile()
+{
+    QCOMPARE(DeltaEncoder::blockSizeForFile(0), size_t(2048));
+    QCOMPARE(DeltaEncoder::blockSizeForFile(100 * 1000 * 1000), size_t(16384));
+    QCOMPARE(DeltaEncoder::blockSizeForFile(qint64(1) << 40), size_t(128 * 1024));
+}
+
+/**
+ * @brief Edits applied to a random old file.
+ */
+void TestDeltaEncoder::roundTrip_data()
+{
+    QTest::addColumn<QByteArray>("old");
+    QTest::addColumn<QByteArray>("updated");
+
+    const QByteArray old = randomData(200 * 1024 + 300, 1);
+    QByteArray inserted = old;
+    inserted.insert(50 * 1024 + 11, randomData(777, 2));
+    QByteArray removed = old;
+    removed.remove(20 * 1024 + 5, 9000);
+    QByteArray overwritten = old;
+    overwritten.replace(100 * 1024, 100, randomData(100, 3));
+
+    QTest::newRow("identical") << old << old;
+    QTest::newRow("insertion") << old << inserted;
+    QTest::newRow("deletion") << old << removed;
+    QTest::newRow("overwrite") << old << overwritten;
+    QTest::newRow("appended") << old << old + randomData(5000, 4);
+    QTest::newRow("truncated") << old << old.left(old.size() / 3);
+    QTest::newRow("reordered") << old << old.mid(old.size() / 2) + old.left(old.size() / 2);
+    QTest::newRow("unrelated") << old << randomData(old.size(), 5);
+    QTest::newRow("large literal") << old << randomData(3 * 1024 * 1024, 6);
+    QTest::newRow("empty new") << old << QByteArray();
+    QTest::newRow("empty old") << QByteArray() << randomData(10000, 7);
+    QTest::newRow("shorter than a block") << QByteArray("abc") << QByteArray("abcd");
+}
+
+/**
+ * @brief The decoder rebuilds the new file exactly and the final MD5 matches.
+ */
+void TestDeltaEncoder::roundTrip()
+{
+    QFETCH(QByteArray, old);
+    QFETCH(QByteArray, updated);
+    DeltaEncoder::Stats stats;
+    QVERIFY(encodeAndApply(old, updated, stats));
+    QCOMPARE(stats.literalBytes + stats.matchedBytes, qint64(updated.size()));
+}
+
+/**
+ * @brief An unchanged file is sent as block copies plus only its short tail.
+ */
+void TestDeltaEncoder::unchangedFileIsAllCopies()
+{
+    const QByteArray old = randomData(64 * kBlockSize + 100, 8);
+    DeltaEncoder::Stats stats;
+    QVERIFY(encodeAndApply(old, old, stats));
+    QCOMPARE(stats.literalBytes, qint64(100));
+    QVERIFY(stats.deltaBytes < 200 + 100);
+}
+
+/**
+ * @brief A small insertion costs about the inserted bytes plus at most a block, not the file.
+ */
+void TestDeltaEncoder::insertionOnlySendsTheEdit()
+{
+    const QByteArray old = randomData(256 * kBlockSize, 9);
+    QByteArray updated = old;
+    updated.insert(100 * kBlockSize + 17, QByteArray(500, 'x'));
+    DeltaEncoder::Stats stats;
+    QVERIFY(encodeAndApply(old, updated, stats));
+    QVERIFY(stats.literalBytes <= 500 + static_cast<qint64>(kBlockSize));
+    QVERIFY(stats.deltaBytes < 500 + 2 * static_cast<qint64>(kBlockSize));
+}
+
+/**
+ * @brief Returning false from the progress callback abandons the delta.
+ */
+void TestDeltaEncoder::cancelStopsEncoding()
+{
+    const QByteArray old = randomData(64 * kBlockSize, 10);
+    const QByteArray updated = randomData(4 * 1024 * 1024, 11);
+    DeltaEncoder encoder(kBlockSize, signatureOf(old));
+    QByteArray delta;
+    QBuffer out(&delta);
+    out.open(QIODevice::WriteOnly);
+    QVERIFY(!encoder.encode(reinterpret_cast<const uint8_t *>(updated.constData()), updated.size(), out,
+                            [](qint64, qint64) { return false; }));
+}
+
+/**
+ * @brief Kinds of change to a 32 MB file, and the most of the file the update may cost on the wire.
+ */
+void TestDeltaEncoder::wireBytes_data()
+{
+    QTest::addColumn<QByteArray>("updated");
+    QTest::addColumn<double>("maxShare");
+    const QByteArray old = randomData(kBenchmarkSize, 12);
+
+    QByteArray edited = old;
+    QRandomGenerator generator(13);
+    for (int i = 0; i < 10; ++i)
+        edited.replace(generator.bounded(kBenchmarkSize - 100), 100, randomData(100, quint32(20 + i)));
+    QTest::newRow("10 scattered edits") << edited << 0.02;
+    QTest::newRow("1 KB prepended") << randomData(1024, 14) + old << 0.02;
+    QTest::newRow("1 MB appended") << old + randomData(1024 * 1024, 15) << 0.05;
+    QTest::newRow("rewritten") << randomData(kBenchmarkSize, 16) << 1.05;
+}
+
+/**
+ * @brief Times encoding at the block size the client requests and prints signature plus delta bytes.
+ */
+void TestDeltaEncoder::wireBytes()
+{
+    QFETCH(QByteArray, updated);
+    QFETCH(double, maxShare);
+    const QByteArray old = randomData(kBenchmarkSize, 12);
+    const size_t blockSize = DeltaEncoder::blockSizeForFile(updated.size());
+    const std::vector<DeltaEncoder::Block> signature = signatureOf(old, blockSize);
+    const DeltaEncoder encoder(blockSize, signature);
+
+    DeltaEncoder::Stats stats;
+    QByteArray delta;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        delta.clear();
+        QBuffer out(&delta);
+        out.open(QIODevice::WriteOnly);
+        timer.start();
+        QVERIFY(encoder.encode(reinterpret_cast<const uint8_t *>(updated.constData()), updated.size(), out,
+                               nullptr, &stats));
+    }
+    const qint64 elapsedMs = std::max<qint64>(1, timer.elapsed());
+
+    const qint64 wire = qint64(signature.size()) * kSignatureEntrySize + stats.deltaBytes;
+    qInfo().noquote() << QString("%1: %2 of %3 bytes on the wire (%4%), %5 literal, encoded at %6 MB/s")
+                             .arg(QTest::currentDataTag())
+                             .arg(wire)
+                             .arg(updated.size())
+                             .arg(100.0 * wire / updated.size(), 0, 'f', 2)
+                             .arg(stats.literalBytes)
+                             .arg(updated.size() / 1048576.0 * 1000.0 / elapsedMs, 0, 'f', 0);
+    QVERIFY(wire < maxShare * updated.size());
+}
+
+QTEST_APPLESS_MAIN(TestDeltaEncoder)
+#include "tst_deltaencoder.moc"
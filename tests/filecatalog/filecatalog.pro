@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_filecatalog
+
+SOURCES += \
+    tst_filecatalog.cpp \
+    $$PWD/../../filecatalog.cpp
+
+HEADERS += \
+    $$PWD/../../filecatalog.h
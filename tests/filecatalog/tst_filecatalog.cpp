@@ -0,0 +1,179 @@
+#include "filecatalog.h"
+#include <QtTest>
+
+namespace {
+
+/**
+ * @brief Returns a listing entry with a size, so updates to it can be seen.
+ */
+APIClient::RemoteFile remote(const QString &name, qint64 size = 1)
+{
+    APIClient::RemoteFile file;
+    file.name = name;
+    file.size = size;
+    file.modified = 1700000000000LL;
+    return file;
+}
+
+APIClient::FileChange addition(const QString &name, qint64 size = 1)
+{
+    APIClient::FileChange change;
+    change.type = APIClient::FileChange::Type::Added;
+    change.file = remote(name, size);
+    return change;
+}
+
+APIClient::FileChange removal(const QString &name)
+{
+    APIClient::FileChange change;
+    change.type = APIClient::FileChange::Type::Removed;
+    change.file.name = name;
+    return change;
+}
+
+APIClient::FileChange renaming(const QString &from, const QString &to)
+{
+    APIClient::FileChange change;
+    change.type = APIClient::FileChange::Type::Renamed;
+    change.oldName = from;
+    change.file.name = to;
+    return change;
+}
+
+/**
+ * @brief Builds the list a full listing of @p names would produce.
+ */
+QList<FileData> listing(const QStringList &names)
+{
+    QList<FileData> files;
+    for (const QString &name : names)
+        files.append(FileCatalog::fileDataFor(remote(name), {}));
+    return files;
+}
+
+QStringList namesOf(const QList<FileData> &files)
+{
+    QStringList names;
+    for (const FileData &file : files)
+        names << file.fileName;
+    return names;
+}
+
+} // namespace
+
+/**
+ * @class TestFileCatalog
+ * @brief Checks how journal changes patch the file list, and the records built from listing entries.
+ */
+class TestFileCatalog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fileDataFor();
+    void addsAndRemoves();
+    void renameKeepsState();
+    void renameOntoExistingName();
+    void replayedChangesAreHarmless();
+    void unknownNamesIgnored();
+};
+
+/**
+ * @brief A listing entry becomes a record with extension, icon, metadata and favorite flag.
+ */
+void TestFileCatalog::fileDataFor()
+{
+    APIClient::RemoteFile file = remote("Report.PDF", 2048);
+    file.contentHash = "abcd";
+    file.mimeType = "application/pdf";
+    FileData data = FileCatalog::fileDataFor(file, { "Report.PDF" });
+
+    QCOMPARE(data.fileName, QString("Report.PDF"));
+    QCOMPARE(data.extension, QString(".pdf"));
+    QCOMPARE(data.iconName, QString("pdf.png"));
+    QCOMPARE(data.size, qint64(2048));
+    QCOMPARE(data.dateModified, QDateTime::fromMSecsSinceEpoch(1700000000000LL));
+    QCOMPARE(data.contentHash, QString("abcd"));
+    QCOMPARE(data.mimeType, QString("application/pdf"));
+    QVERIFY(data.isFavorite);
+    QVERIFY(!FileCatalog::fileDataFor(remote("other.txt"), { "Report.PDF" }).isFavorite);
+}
+
+/**
+ * @brief Added files are appended, favorites marked, and removed files dropped in order.
+ */
+void TestFileCatalog::addsAndRemoves()
+{
+    QList<FileData> files = listing({ "a.txt", "b.txt", "c.txt" });
+    FileCatalog::applyChanges(files, { removal("b.txt"), addition("d.mp3"), addition(".DS_Store"), removal("a.txt") },
+                              { "d.mp3" });
+
+    QCOMPARE(namesOf(files), QStringList({ "c.txt", "d.mp3" }));
+    QCOMPARE(files[1].iconName, QString("music.png"));
+    QVERIFY(files[1].isFavorite);
+}
+
+/**
+ * @brief A renamed file keeps its place, selection and favorite flag, with its type updated.
+ */
+void TestFileCatalog::renameKeepsState()
+{
+    QList<FileData> files = listing({ "a.txt", "b.txt" });
+    files[0].isSelected = true;
+    files[0].isFavorite = true;
+    FileCatalog::applyChanges(files, { renaming("a.txt", "a.jpg") }, {});
+
+    QCOMPARE(namesOf(files), QStringList({ "a.jpg", "b.txt" }));
+    QCOMPARE(files[0].extension, QString(".jpg"));
+    QCOMPARE(files[0].iconName, QString("image.png"));
+    QVERIFY(files[0].isSelected);
+    QVERIFY(files[0].isFavorite);
+}
+
+/**
+ * @brief Renaming onto an existing name replaces that file instead of leaving two with one name.
+ */
+void TestFileCatalog::renameOntoExistingName()
+{
+    QList<FileData> files = listing({ "a.txt", "b.txt", "c.txt" });
+    files[0].size = 10;
+    FileCatalog::applyChanges(files, { renaming("a.txt", "c.txt") }, {});
+
+    QCOMPARE(namesOf(files), QStringList({ "c.txt", "b.txt" }));
+    QCOMPARE(files[0].size, qint64(10));
+
+    // The replaced name can be reused later in the same set.
+    files = listing({ "a.txt", "b.txt" });
+    FileCatalog::applyChanges(files, { renaming("a.txt", "b.txt"), renaming("b.txt", "c.txt") }, {});
+    QCOMPARE(namesOf(files), QStringList({ "c.txt" }));
+}
+
+/**
+ * @brief Changes the listing already contains leave it as it was, apart from fresher metadata.
+ */
+void TestFileCatalog::replayedChangesAreHarmless()
+{
+    QList<FileData> files = listing({ "a.txt", "b.txt" });
+    files[0].isSelected = true;
+    const QList<APIClient::FileChange> changes = { addition("a.txt", 5), renaming("x.txt", "b.txt"), removal("gone.txt") };
+    FileCatalog::applyChanges(files, changes, {});
+    FileCatalog::applyChanges(files, changes, {});
+
+    QCOMPARE(namesOf(files), QStringList({ "a.txt", "b.txt" }));
+    QCOMPARE(files[0].size, qint64(5));
+    QVERIFY(files[0].isSelected);
+}
+
+/**
+ * @brief Removing or renaming a name that is not listed changes nothing.
+ */
+void TestFileCatalog::unknownNamesIgnored()
+{
+    QList<FileData> files = listing({ "a.txt" });
+    FileCatalog::applyChanges(files, { removal("missing.txt"), renaming("missing.txt", "a.txt") }, {});
+
+    QCOMPARE(namesOf(files), QStringList({ "a.txt" }));
+}
+
+QTEST_APPLESS_MAIN(TestFileCatalog)
+#include "tst_filecatalog.moc"
@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_filehasher
+
+SOURCES += \
+    tst_filehasher.cpp \
+    $$PWD/../../filehasher.cpp
+
+HEADERS += \
+    $$PWD/../../filehasher.h
@@ -0,0 +1,219 @@
+#include "filehasher.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+
+namespace {
+
+/// Seed used by the reference implementation's sanity checks (PRIME32_1).
+constexpr quint64 kPrimeSeed = 2654435761U;
+
+/// Bytes hashed per benchmark row.
+constexpr int kBenchmarkSize = 256 * 1024 * 1024;
+
+/**
+ * @brief Returns the xxHash sanity-check buffer: the top byte of successive PRIME64_1 powers.
+ */
+QByteArray sanityBuffer(int length)
+{
+    QByteArray buffer(length, Qt::Uninitialized);
+    quint64 generator = kPrimeSeed;
+    for (char &byte : buffer) {
+        byte = static_cast<char>(generator >> 56);
+        generator *= 11400714785074694797ULL;
+    }
+    return buffer;
+}
+
+quint64 hashOf(const QByteArray &data, quint64 seed = 0)
+{
+    FileHasher hasher(seed);
+    hasher.update(data.constData(), static_cast<size_t>(data.size()));
+    return quint64(hasher.digest());
+}
+
+} // namespace
+
+/**
+ * @class TestFileHasher
+ * @brief Checks FileHasher against the XXH64 reference vectors and its streaming behaviour.
+ */
+class TestFileHasher : public QObject
+{
+    Q_OBJECT
+private slots:
+    void referenceVectors_data();
+    void referenceVectors();
+    void incrementalMatchesOneShot();
+    void digestLeavesStateUnchanged();
+    void hexDigestIsCanonical();
+    void hashFileMatchesMemory();
+    void hashFileFailures();
+
+    void throughput_data();
+    void throughput();
+};
+
+/**
+ * @brief Published XXH64 values for short strings and the sanity buffer.
+ */
+void TestFileHasher::referenceVectors_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<quint64>("seed");
+    QTest::addColumn<quint64>("expected");
+
+    QTest::newRow("empty") << QByteArray() << quint64(0) << quint64(0xEF46DB3751D8E999ULL);
+    QTest::newRow("a") << QByteArray("a") << quint64(0) << quint64(0xD24EC4F1A98C6E5BULL);
+    QTest::newRow("abc") << QByteArray("abc") << quint64(0) << quint64(0x44BC2CF5AD770999ULL);
+    QTest::newRow("fox") << QByteArray("The quick brown fox jumps over the lazy dog") << quint64(0)
+                         << quint64(0x0B242D361FDA71BCULL);
+    QTest::newRow("sanity 1") << sanityBuffer(1) << quint64(0) << quint64(0xE934A84ADB052768ULL);
+    QTest::newRow("sanity 1 seeded") << sanityBuffer(1) << kPrimeSeed << quint64(0x5014607643A9B4C3ULL);
+    QTest::newRow("sanity 4") << sanityBuffer(4) << quint64(0) << quint64(0x9136A0DCA57457EEULL);
+    QTest::newRow("sanity 4 seeded") << sanityBuffer(4) << kPrimeSeed << quint64(0xCAAB286BD8E9FDB5ULL);
+    QTest::newRow("sanity 14") << sanityBuffer(14) << quint64(0) << quint64(0x8282DCC4994E35C8ULL);
+    QTest::newRow("sanity 14 seeded") << sanityBuffer(14) << kPrimeSeed << quint64(0xC3BD6BF63DEB6DF0ULL);
+    QTest::newRow("sanity 222") << sanityBuffer(222) << quint64(0) << quint64(0xB641AE8CB691C174ULL);
+    QTest::newRow("sanity 222 seeded") << sanityBuffer(222) << kPrimeSeed << quint64(0x20CB8AB7AE10C14AULL);
+}
+
+/**
+ * @brief The one-shot digest equals the reference value.
+ */
+void TestFileHasher::referenceVectors()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(quint64, seed);
+    QFETCH(quint64, expected);
+    QCOMPARE(hashOf(data, seed), expected);
+}
+
+/**
+ * @brief Feeding the same bytes in pieces of any size gives the same digest.
+ */
+void TestFileHasher::incrementalMatchesOneShot()
+{
+    const QByteArray data = sanityBuffer(2367);
+    const quint64 expected = hashOf(data);
+    for (int piece = 1; piece <= 65; ++piece) {
+        FileHasher hasher;
+        for (int offset = 0; offset < data.size(); offset += piece) {
+            int length = std::min(piece, data.size() - offset);
+            hasher.update(data.constData() + offset, static_cast<size_t>(length));
+        }
+        QCOMPARE(quint64(hasher.digest()), expected);
+    }
+}
+
+/**
+ * @brief Taking a digest part-way does not disturb the running hash.
+ */
+void TestFileHasher::digestLeavesStateUnchanged()
+{
+    const QByteArray data = sanityBuffer(100);
+    FileHasher hasher;
+    hasher.update(data.constData(), 40);
+    QCOMPARE(quint64(hasher.digest()), hashOf(data.left(40)));
+    hasher.update(data.constData() + 40, 60);
+    QCOMPARE(quint64(hasher.digest()), hashOf(data));
+}
+
+/**
+ * @brief The hex form is the big-endian value, as xxhsum prints it.
+ */
+void TestFileHasher::hexDigestIsCanonical()
+{
+    QCOMPARE(FileHasher().hexDigest(), QByteArray("ef46db3751d8e999"));
+    FileHasher fox;
+    fox.update("The quick brown fox jumps over the lazy dog", 43);
+    QCOMPARE(fox.hexDigest(), QByteArray("0b242d361fda71bc"));
+}
+
+/**
+ * @brief hashFile() over several read blocks agrees with hashing the bytes in memory.
+ */
+void TestFileHasher::hashFileMatchesMemory()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QByteArray data(3 * 1024 * 1024 + 7, Qt::Uninitialized);
+    QRandomGenerator generator(9);
+    for (char &byte : data)
+        byte = static_cast<char>(generator.bounded(256));
+    QFile file(dir.filePath("data.bin"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(data), qint64(data.size()));
+    file.close();
+
+    FileHasher hasher;
+    hasher.update(data.constData(), static_cast<size_t>(data.size()));
+    QCOMPARE(FileHasher::hashFile(file.fileName()), hasher.hexDigest());
+}
+
+/**
+ * @brief A missing file or a cancelled hash yields an empty digest.
+ */
+void TestFileHasher::hashFileFailures()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(FileHasher::hashFile(dir.filePath("missing.bin")).isEmpty());
+
+    QFile file(dir.filePath("data.bin"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(2 * 1024 * 1024, 'x'));
+    file.close();
+    QVERIFY(FileHasher::hashFile(file.fileName(), [](qint64, qint64) { return false; }).isEmpty());
+}
+
+/**
+ * @brief Hashing a buffer in memory, and a file that was just written and so sits in the page cache.
+ */
+void TestFileHasher::throughput_data()
+{
+    QTest::addColumn<bool>("fromFile");
+    QTest::newRow("memory") << false;
+    QTest::newRow("hashFile, page cache") << true;
+}
+
+/**
+ * @brief Hashes kBenchmarkSize bytes and prints GB/s.
+ */
+void TestFileHasher::throughput()
+{
+    QFETCH(bool, fromFile);
+    const QByteArray data = sanityBuffer(kBenchmarkSize);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QFile file(dir.filePath("data.bin"));
+    if (fromFile) {
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(data), qint64(data.size()));
+        file.close();
+    }
+
+    QByteArray digest;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        if (fromFile) {
+            digest = FileHasher::hashFile(file.fileName());
+        } else {
+            FileHasher hasher;
+            hasher.update(data.constData(), static_cast<size_t>(data.size()));
+            digest = hasher.hexDigest();
+        }
+    }
+    const qint64 elapsedNs = std::max<qint64>(1, timer.nsecsElapsed());
+    QCOMPARE(digest.size(), 16);
+    qInfo().noquote() << QString("%1: %2 GB/s")
+                             .arg(QTest::currentDataTag())
+                             .arg(double(kBenchmarkSize) / elapsedNs, 0, 'f', 2);
+}
+
+QTEST_APPLESS_MAIN(TestFileHasher)
+#include "tst_filehasher.moc"
@@ -0,0 +1,7 @@
+include(../tests.pri)
+include(../client.pri)
+
+TARGET = tst_listingbenchmark
+
+SOURCES += \
+    tst_listingbenchmark.cpp
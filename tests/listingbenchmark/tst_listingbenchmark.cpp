@@ -0,0 +1,180 @@
+#include "APIClient.h"
+#include "localserver.h"
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include "json/json.hpp"
+
+namespace {
+
+/// Entries generated per chunk of an unpaginated listing.
+constexpr int kChunkEntries = 1000;
+
+/**
+ * @brief Returns listing entry @p index with every field set, as the server describes a file.
+ */
+nlohmann::json entryAt(int index)
+{
+    return { { "name", QString("dir%1/file%2.dat").arg(index % 100).arg(index, 7, 10, QChar('0')).toStdString() },
+             { "size", qint64(index) * 37 },
+             { "mtime", 1700000000000LL + index },
+             { "hash", QString::number(index, 16).rightJustified(16, QChar('0')).toStdString() },
+             { "mime", "application/octet-stream" } };
+}
+
+/**
+ * @brief Serialises entries [@p first, @p last) as comma-separated JSON objects.
+ */
+std::string entriesText(int first, int last)
+{
+    std::string text;
+    for (int i = first; i < last; ++i) {
+        if (i > first)
+            text += ',';
+        text += entryAt(i).dump();
+    }
+    return text;
+}
+
+} // namespace
+
+/**
+ * @class TestListingBenchmark
+ * @brief Measures how soon listFilesPaged() delivers its first entries, and the whole walk, by listing size.
+ *
+ * The server either pages the listing or, like servers without pagination,
+ * sends it as one array generated while it streams.
+ */
+class TestListingBenchmark : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void timeToFirstPage_data();
+    void timeToFirstPage();
+
+private:
+    QTemporaryDir m_dir;
+    std::unique_ptr<LocalServer> m_server;
+    std::atomic<int> m_total{0};         ///< Entries in the served listing
+    std::atomic<bool> m_paginated{true}; ///< Page the listing, or send one plain array
+};
+
+/**
+ * @brief Keeps settings and the listing cache out of the user's configuration.
+ */
+void TestListingBenchmark::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+}
+
+/**
+ * @brief Starts a server whose /api/files builds pages, or the plain array, on demand.
+ */
+void TestListingBenchmark::init()
+{
+    m_server = std::make_unique<LocalServer>();
+    m_server->server().Get("/api/files", [this](const httplib::Request &req, httplib::Response &res) {
+        const int total = m_total;
+        if (!m_paginated) {
+            auto next = std::make_shared<int>(0);
+            res.set_chunked_content_provider("application/json",
+                [next, total](size_t, httplib::DataSink &sink) {
+                    const int first = *next;
+                    const int last = std::min(total, first + kChunkEntries);
+                    std::string text = (first == 0 ? "[" : ",") + entriesText(first, last);
+                    *next = last;
+                    if (last == total)
+                        text += ']';
+                    if (!sink.write(text.data(), text.size()))
+                        return false;
+                    if (last == total)
+                        sink.done();
+                    return true;
+                });
+            return;
+        }
+        const int limit = std::max(1, std::stoi(req.get_param_value("limit")));
+        const int first = req.has_param("cursor") ? std::stoi(req.get_param_value("cursor")) : 0;
+        const int last = std::min(total, first + limit);
+        const std::string next = last < total ? "\"" + std::to_string(last) + "\"" : "null";
+        res.set_content("{\"seq\":1,\"next\":" + next + ",\"files\":[" + entriesText(first, last) + "]}",
+                        "application/json");
+    });
+    QVERIFY(m_server->start());
+}
+
+void TestListingBenchmark::cleanup()
+{
+    m_server.reset();
+}
+
+/**
+ * @brief Listing sizes, paged and as one plain array.
+ */
+void TestListingBenchmark::timeToFirstPage_data()
+{
+    QTest::addColumn<int>("total");
+    QTest::addColumn<bool>("paginated");
+    for (int total : { 10000, 100000, 1000000 }) {
+        const QString size = QString("%1k").arg(total / 1000);
+        QTest::newRow(qPrintable(size + ", paged")) << total << true;
+        QTest::newRow(qPrintable(size + ", one array")) << total << false;
+    }
+}
+
+/**
+ * @brief Times the walk and prints when the first batch arrived; it must not wait for the whole listing.
+ */
+void TestListingBenchmark::timeToFirstPage()
+{
+    QFETCH(int, total);
+    QFETCH(bool, paginated);
+    m_total = total;
+    m_paginated = paginated;
+
+    APIClient client(m_server->url());
+    size_t received = 0;
+    qint64 firstBatchMs = -1;
+    QString lastName;
+    QElapsedTimer timer;
+    bool listed = false;
+    QBENCHMARK_ONCE {
+        timer.start();
+        listed = client.listFilesPaged([&](std::vector<APIClient::RemoteFile> &files) {
+            if (firstBatchMs < 0)
+                firstBatchMs = timer.elapsed();
+            received += files.size();
+            if (!files.empty())
+                lastName = files.back().name;
+            return true;
+        });
+    }
+    const qint64 elapsedMs = std::max<qint64>(1, timer.elapsed());
+
+    QVERIFY(listed);
+    QCOMPARE(received, size_t(total));
+    QCOMPARE(lastName, QString::fromStdString(entryAt(total - 1).at("name").get<std::string>()));
+    qInfo().noquote() << QString("%1: first batch after %2 ms, all %3 entries after %4 ms")
+                             .arg(QTest::currentDataTag())
+                             .arg(firstBatchMs)
+                             .arg(total)
+                             .arg(elapsedMs);
+    if (total >= 100000)
+        QVERIFY(firstBatchMs * 10 < elapsedMs);
+}
+
+QTEST_GUILESS_MAIN(TestListingBenchmark)
+#include "tst_listingbenchmark.moc"
@@ -0,0 +1,7 @@
+include(../tests.pri)
+include(../client.pri)
+
+TARGET = tst_listingcache
+
+SOURCES += \
+    tst_listingcache.cpp
@@ -0,0 +1,542 @@
+#include "listingcache.h"
+#include "APIClient.h"
+#include "localserver.h"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "json/json.hpp"
+
+namespace {
+
+/**
+ * @brief Returns @p count entries with every field set, so the round trip covers them all.
+ */
+std::vector<APIClient::RemoteFile> makeFiles(int count, const QString &prefix = "file")
+{
+    std::vector<APIClient::RemoteFile> files;
+    for (int i = 0; i < count; ++i) {
+        APIClient::RemoteFile file;
+        file.name = QString("%1%2.txt").arg(prefix).arg(i);
+        file.size = i * 100;
+        file.modified = 1700000000000LL + i;
+        file.contentHash = QString::number(i, 16).rightJustified(16, QLatin1Char('0'));
+        file.mimeType = "text/plain";
+        files.push_back(file);
+    }
+    return files;
+}
+
+/**
+ * @brief Replays @p cache into a list, recording the size of each batch.
+ */
+bool replayAll(const ListingCache &cache, std::vector<APIClient::RemoteFile> &files,
+               std::vector<size_t> *batches = nullptr)
+{
+    files.clear();
+    return cache.replay([&](std::vector<APIClient::RemoteFile> &batch) {
+        if (batches)
+            batches->push_back(batch.size());
+        files.insert(files.end(), batch.begin(), batch.end());
+        return true;
+    });
+}
+
+QStringList namesOf(const std::vector<APIClient::RemoteFile> &files)
+{
+    QStringList names;
+    for (const APIClient::RemoteFile &file : files)
+        names << file.name;
+    return names;
+}
+
+/**
+ * @brief Returns where ListingCache keeps the file for @p serverUrl, entries and ETag together.
+ */
+QString cachePath(const QString &serverUrl)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/listings/" +
+           QString::fromLatin1(QCryptographicHash::hash(serverUrl.toUtf8(), QCryptographicHash::Md5).toHex()) +
+           ".cbor";
+}
+
+/**
+ * @brief A cache key of its own for the running test function.
+ */
+QString testUrl()
+{
+    return QString("http://listing-cache.test/%1").arg(QTest::currentTestFunction());
+}
+
+} // namespace
+
+/**
+ * @class TestListingCache
+ * @brief Checks the on-disk listing cache and the conditional listing that replays it on 304.
+ */
+class TestListingCache : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void emptyCache();
+    void commitAndReplay();
+    void persistsAcrossInstances();
+    void partialWriteKeepsOldCopy();
+    void interleavedWritersStayPaired();
+    void truncatedFileIsNoCache();
+    void commitWithoutEtagForgets();
+    void clearForgets();
+    void callbackStopsReplay();
+
+    void notModifiedReplaysCache();
+    void changedListingReplacesCache();
+    void interruptedListingKeepsCache();
+    void unreadableCacheRefetches();
+
+private:
+    /**
+     * @brief One /api/files request as the server saw it.
+     */
+    struct Request {
+        std::string cursor;
+        std::string ifNoneMatch;
+        int status = 0;
+    };
+
+    /**
+     * @brief Lists every file through listFilesPaged().
+     * @param stopAfter Number of batches after which the callback asks to stop, or -1 to accept all.
+     */
+    bool list(QStringList &names, qint64 *sequence = nullptr, int stopAfter = -1);
+
+    std::vector<Request> requests();
+
+    QTemporaryDir m_dir;
+    std::unique_ptr<LocalServer> m_server;
+
+    std::mutex m_mutex;
+    QStringList m_files;               ///< Names the server lists
+    int m_version = 1;                 ///< Listing state; the ETag and change sequence derive from it
+    std::string m_failCursor;          ///< Page answered with 404, or empty
+    std::vector<Request> m_requests;
+};
+
+/**
+ * @brief Keeps settings and cache files out of the user's directories.
+ */
+void TestListingCache::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+}
+
+/**
+ * @brief Starts a paginating server whose pages carry an ETag and honour If-None-Match.
+ */
+void TestListingCache::init()
+{
+    m_files = QStringList({"a.txt", "b.txt", "c.txt", "d.txt", "e.txt"});
+    m_version = 1;
+    m_failCursor.clear();
+    m_requests.clear();
+
+    m_server = std::make_unique<LocalServer>();
+    m_server->server().Get("/api/files", [this](const httplib::Request &req, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Request request;
+        request.cursor = req.get_param_value("cursor");
+        request.ifNoneMatch = req.get_header_value("If-None-Match");
+
+        const std::string etag = "\"v" + std::to_string(m_version) + "\"";
+        res.set_header("ETag", etag);
+        if (request.ifNoneMatch == etag) {
+            res.status = 304;
+        } else if (!m_failCursor.empty() && request.cursor == m_failCursor) {
+            res.status = 404;
+        } else {
+            const int start = request.cursor.empty() ? 0 : std::stoi(request.cursor);
+            const int end = std::min(start + std::stoi(req.get_param_value("limit")), int(m_files.size()));
+            nlohmann::json page = { { "files", nlohmann::json::array() }, { "seq", m_version * 10 } };
+            for (int i = start; i < end; ++i)
+                page["files"].push_back(m_files[i].toStdString());
+            page["next"] = end < m_files.size() ? nlohmann::json(std::to_string(end)) : nlohmann::json();
+            res.set_content(page.dump(), "application/json");
+        }
+        request.status = res.status == -1 ? 200 : res.status;
+        m_requests.push_back(request);
+    });
+    QVERIFY(m_server->start());
+
+    ListingCache(testUrl()).clear();
+    ListingCache(m_server->url()).clear();
+}
+
+/**
+ * @brief Stops the server and removes what the test cached.
+ */
+void TestListingCache::cleanup()
+{
+    ListingCache(testUrl()).clear();
+    ListingCache(m_server->url()).clear();
+    m_server.reset();
+}
+
+bool TestListingCache::list(QStringList &names, qint64 *sequence, int stopAfter)
+{
+    names.clear();
+    int batches = 0;
+    return APIClient(m_server->url()).listFilesPaged([&](std::vector<APIClient::RemoteFile> &files) {
+        for (const APIClient::RemoteFile &file : files)
+            names << file.name;
+        return stopAfter < 0 || ++batches < stopAfter;
+    }, 2, sequence);
+}
+
+std::vector<TestListingCache::Request> TestListingCache::requests()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_requests;
+}
+
+/**
+ * @brief A server never listed has no ETag, no sequence and nothing to replay.
+ */
+void TestListingCache::emptyCache()
+{
+    ListingCache cache(testUrl());
+    QVERIFY(cache.etag().empty());
+    QCOMPARE(cache.sequence(), qint64(-1));
+    std::vector<APIClient::RemoteFile> files;
+    QVERIFY(!replayAll(cache, files));
+    QVERIFY(files.empty());
+}
+
+/**
+ * @brief Committed entries replay with every field intact, in replay-sized batches.
+ */
+void TestListingCache::commitAndReplay()
+{
+    const std::vector<APIClient::RemoteFile> written = makeFiles(2500);
+    ListingCache cache(testUrl());
+    QVERIFY(cache.beginWrite());
+    cache.append(std::vector<APIClient::RemoteFile>(written.begin(), written.begin() + 700));
+    cache.append(std::vector<APIClient::RemoteFile>(written.begin() + 700, written.end()));
+    QVERIFY(cache.commit("\"abc\"", 17));
+    QCOMPARE(cache.etag(), std::string("\"abc\""));
+    QCOMPARE(cache.sequence(), qint64(17));
+
+    std::vector<APIClient::RemoteFile> files;
+    std::vector<size_t> batches;
+    QVERIFY(replayAll(cache, files, &batches));
+    QCOMPARE(batches, std::vector<size_t>({1000, 1000, 500}));
+    QCOMPARE(files.size(), written.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        QCOMPARE(files[i].name, written[i].name);
+        QCOMPARE(files[i].size, written[i].size);
+        QCOMPARE(files[i].modified, written[i].modified);
+        QCOMPARE(files[i].contentHash, written[i].contentHash);
+        QCOMPARE(files[i].mimeType, written[i].mimeType);
+    }
+}
+
+/**
+ * @brief A new instance for the same server finds the committed listing.
+ */
+void TestListingCache::persistsAcrossInstances()
+{
+    {
+        ListingCache cache(testUrl());
+        QVERIFY(cache.beginWrite());
+        cache.append(makeFiles(3));
+        QVERIFY(cache.commit("\"v1\"", 5));
+    }
+    ListingCache reopened(testUrl());
+    QCOMPARE(reopened.etag(), std::string("\"v1\""));
+    QCOMPARE(reopened.sequence(), qint64(5));
+    std::vector<APIClient::RemoteFile> files;
+    QVERIFY(replayAll(reopened, files));
+    QCOMPARE(namesOf(files), namesOf(makeFiles(3)));
+
+    ListingCache other(testUrl() + "/other");
+    QVERIFY(other.etag().empty());
+}
+
+/**
+ * @brief A write that is never committed leaves the previous copy current, during and after it.
+ */
+void TestListingCache::partialWriteKeepsOldCopy()
+{
+    {
+        ListingCache cache(testUrl());
+        QVERIFY(cache.beginWrite());
+        cache.append(makeFiles(3, "old"));
+        QVERIFY(cache.commit("\"v1\"", 5));
+
+        QVERIFY(cache.beginWrite());
+        cache.append(makeFiles(4, "new"));
+        std::vector<APIClient::RemoteFile> files;
+        QVERIFY(replayAll(cache, files));
+        QCOMPARE(namesOf(files), namesOf(makeFiles(3, "old")));
+    }
+
+    ListingCache reopened(testUrl());
+    QCOMPARE(reopened.etag(), std::string("\"v1\""));
+    QCOMPARE(reopened.sequence(), qint64(5));
+    std::vector<APIClient::RemoteFile> files;
+    QVERIFY(replayAll(reopened, files));
+    QCOMPARE(namesOf(files), namesOf(makeFiles(3, "old")));
+}
+
+/**
+ * @brief Two writers for one server, as two clients listing at once, each replace the
+ *        ETag together with their own entries.
+ */
+void TestListingCache::interleavedWritersStayPaired()
+{
+    ListingCache first(testUrl());
+    ListingCache second(testUrl());
+    QVERIFY(first.beginWrite());
+    QVERIFY(second.beginWrite());
+    first.append(makeFiles(3, "first"));
+    second.append(makeFiles(4, "second"));
+
+    QVERIFY(second.commit("\"v2\"", 2));
+    {
+        ListingCache reopened(testUrl());
+        QCOMPARE(reopened.etag(), std::string("\"v2\""));
+        std::vector<APIClient::RemoteFile> files;
+        QVERIFY(replayAll(reopened, files));
+        QCOMPARE(namesOf(files), namesOf(makeFiles(4, "second")));
+    }
+
+    QVERIFY(first.commit("\"v1\"", 1));
+    ListingCache reopened(testUrl());
+    QCOMPARE(reopened.etag(), std::string("\"v1\""));
+    QCOMPARE(reopened.sequence(), qint64(1));
+    std::vector<APIClient::RemoteFile> files;
+    QVERIFY(replayAll(reopened, files));
+    QCOMPARE(namesOf(files), namesOf(makeFiles(3, "first")));
+}
+
+/**
+ * @brief A file cut short loses the ETag at its end, so it is never offered for revalidation.
+ */
+void TestListingCache::truncatedFileIsNoCache()
+{
+    ListingCache cache(testUrl());
+    QVERIFY(cache.beginWrite());
+    cache.append(makeFiles(3));
+    QVERIFY(cache.commit("\"v1\"", 1));
+
+    const QString path = cachePath(testUrl());
+    QVERIFY(QFile::resize(path, QFileInfo(path).size() - 1));
+    ListingCache reopened(testUrl());
+    QVERIFY(reopened.etag().empty());
+    QCOMPARE(reopened.sequence(), qint64(-1));
+    std::vector<APIClient::RemoteFile> files;
+    QVERIFY(!replayAll(reopened, files));
+}
+
+/**
+ * @brief A listing without an ETag could never be revalidated, so it is not kept.
+ */
+void TestListingCache::commitWithoutEtagForgets()
+{
+    ListingCache cache(testUrl());
+    QVERIFY(cache.beginWrite());
+    cache.append(makeFiles(1));
+    QVERIFY(cache.commit("\"v1\"", 1));
+
+    QVERIFY(cache.beginWrite());
+    cache.append(makeFiles(2));
+    QVERIFY(!cache.commit(std::string(), 2));
+    QVERIFY(cache.etag().empty());
+    QCOMPARE(cache.sequence(), qint64(-1));
+    QVERIFY(ListingCache(testUrl()).etag().empty());
+    QVERIFY(!cache.commit("\"v2\"", 3));
+}
+
+/**
+ * @brief clear() forgets the listing and drops a write in progress.
+ */
+void TestListingCache::clearForgets()
+{
+    ListingCache cache(testUrl());
+    QVERIFY(cache.beginWrite());
+    cache.append(makeFiles(2));
+    QVERIFY(cache.commit("\"v1\"", 1));
+
+    QVERIFY(cache.beginWrite());
+    cache.clear();
+    QVERIFY(cache.etag().empty());
+    QVERIFY(!QFile::exists(cachePath(testUrl())));
+    QVERIFY(!cache.commit("\"v2\"", 2));
+
+    ListingCache reopened(testUrl());
+    QVERIFY(reopened.etag().empty());
+    std::vector<APIClient::RemoteFile> files;
+    QVERIFY(!replayAll(reopened, files));
+}
+
+/**
+ * @brief A callback returning false ends the replay, which then reports failure.
+ */
+void TestListingCache::callbackStopsReplay()
+{
+    ListingCache cache(testUrl());
+    QVERIFY(cache.beginWrite());
+    cache.append(makeFiles(2500));
+    QVERIFY(cache.commit("\"v1\"", 1));
+
+    int batches = 0;
+    QVERIFY(!cache.replay([&](std::vector<APIClient::RemoteFile> &) { return ++batches < 2; }));
+    QCOMPARE(batches, 2);
+}
+
+/**
+ * @brief The second listing is conditional, gets a 304, and replays the cached pages.
+ */
+void TestListingCache::notModifiedReplaysCache()
+{
+    QStringList names;
+    qint64 sequence = 0;
+    QVERIFY(list(names, &sequence));
+    QCOMPARE(names, m_files);
+    QCOMPARE(sequence, qint64(10));
+
+    std::vector<Request> first = requests();
+    QCOMPARE(first.size(), size_t(3));
+    for (const Request &request : first)
+        QVERIFY(request.ifNoneMatch.empty());
+
+    QVERIFY(list(names, &sequence));
+    QCOMPARE(names, m_files);
+    QCOMPARE(sequence, qint64(10));
+
+    std::vector<Request> all = requests();
+    QCOMPARE(all.size(), size_t(4));
+    QCOMPARE(all[3].ifNoneMatch, std::string("\"v1\""));
+    QVERIFY(all[3].cursor.empty());
+    QCOMPARE(all[3].status, 304);
+}
+
+/**
+ * @brief A changed listing is downloaded in full and becomes the copy the next 304 replays.
+ */
+void TestListingCache::changedListingReplacesCache()
+{
+    QStringList names;
+    QVERIFY(list(names));
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_files = QStringList({"x.txt", "y.txt", "z.txt"});
+        m_version = 2;
+    }
+    qint64 sequence = 0;
+    QVERIFY(list(names, &sequence));
+    QCOMPARE(names, QStringList({"x.txt", "y.txt", "z.txt"}));
+    QCOMPARE(sequence, qint64(20));
+    std::vector<Request> all = requests();
+    QCOMPARE(all.size(), size_t(5));
+    QCOMPARE(all[3].ifNoneMatch, std::string("\"v1\""));
+    QCOMPARE(all[3].status, 200);
+
+    QVERIFY(list(names, &sequence));
+    QCOMPARE(names, QStringList({"x.txt", "y.txt", "z.txt"}));
+    QCOMPARE(sequence, qint64(20));
+    all = requests();
+    QCOMPARE(all.size(), size_t(6));
+    QCOMPARE(all[5].ifNoneMatch, std::string("\"v2\""));
+    QCOMPARE(all[5].status, 304);
+}
+
+/**
+ * @brief Listings that fail part-way, on the server or in the caller, leave the last complete copy cached.
+ */
+void TestListingCache::interruptedListingKeepsCache()
+{
+    QStringList names;
+    QVERIFY(list(names));
+    const QStringList original = m_files;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_files = QStringList({"p.txt", "q.txt", "r.txt", "s.txt"});
+        m_version = 2;
+        m_failCursor = "2";
+    }
+    QVERIFY(!list(names));
+    QCOMPARE(names, QStringList({"p.txt", "q.txt"}));
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_failCursor.clear();
+    }
+    QVERIFY(!list(names, nullptr, 1));
+    QCOMPARE(names, QStringList({"p.txt", "q.txt"}));
+
+    ListingCache cache(m_server->url());
+    QCOMPARE(cache.etag(), std::string("\"v1\""));
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_files = original;
+        m_version = 1;
+    }
+    const size_t before = requests().size();
+    qint64 sequence = 0;
+    QVERIFY(list(names, &sequence));
+    QCOMPARE(names, original);
+    QCOMPARE(sequence, qint64(10));
+    std::vector<Request> all = requests();
+    QCOMPARE(all.size(), before + 1);
+    QCOMPARE(all.back().status, 304);
+}
+
+/**
+ * @brief A damaged entry file is dropped and the listing fetched again without the condition.
+ */
+void TestListingCache::unreadableCacheRefetches()
+{
+    QStringList names;
+    QVERIFY(list(names));
+
+    // Break the entries map's header but keep the ETag at the end, so the server
+    // answers 304 and the replay fails before delivering anything.
+    QFile file(cachePath(m_server->url()));
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(1));
+    QCOMPARE(file.write(QByteArray(7, '\xff')), qint64(7));
+    file.close();
+
+    QVERIFY(list(names));
+    QCOMPARE(names, m_files);
+    std::vector<Request> all = requests();
+    QCOMPARE(all.size(), size_t(7));
+    QCOMPARE(all[3].status, 304);
+    QVERIFY(all[4].ifNoneMatch.empty());
+    QCOMPARE(all[4].status, 200);
+
+    QVERIFY(list(names));
+    QCOMPARE(names, m_files);
+    all = requests();
+    QCOMPARE(all.size(), size_t(8));
+    QCOMPARE(all.back().status, 304);
+}
+
+QTEST_GUILESS_MAIN(TestListingCache)
+#include "tst_listingcache.moc"
@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_listingparser
+
+SOURCES += \
+    tst_listingparser.cpp \
+    $$PWD/../../listingparser.cpp
+
+HEADERS += \
+    $$PWD/../../listingparser.h
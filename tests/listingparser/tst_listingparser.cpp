@@ -0,0 +1,387 @@
+#include "listingparser.h"
+#include <QtTest>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Format = nlohmann::json::input_format_t;
+
+/**
+ * @brief Everything one parse produced: the entries, how they were batched, and the page metadata.
+ */
+struct Listing {
+    std::vector<APIClient::RemoteFile> files;
+    std::vector<size_t> batches;   ///< Size of each batch handed to the callback
+    bool parsed = false;           ///< sax_parse() and flush() both succeeded
+    std::string next;
+    qint64 sequence = -1;
+    bool paginated = false;
+    size_t count = 0;
+};
+
+/**
+ * @brief Runs @p document through a ListingParser the way the client does, then flushes it.
+ * @param stopAfter Number of batches after which the callback asks to stop, or -1 to accept all.
+ */
+Listing parse(const std::string &document, size_t batchSize, Format format = Format::json, int stopAfter = -1)
+{
+    Listing listing;
+    ListingParser parser([&](std::vector<APIClient::RemoteFile> &files) {
+        listing.batches.push_back(files.size());
+        for (APIClient::RemoteFile &file : files)
+            listing.files.push_back(std::move(file));
+        return stopAfter < 0 || static_cast<int>(listing.batches.size()) < stopAfter;
+    }, batchSize);
+    listing.parsed = nlohmann::json::sax_parse(document, &parser, format) && parser.flush();
+    listing.next = parser.nextCursor();
+    listing.sequence = parser.sequence();
+    listing.paginated = parser.paginated();
+    listing.count = parser.count();
+    return listing;
+}
+
+std::string cbor(const nlohmann::json &document)
+{
+    std::vector<std::uint8_t> bytes = nlohmann::json::to_cbor(document);
+    return std::string(bytes.begin(), bytes.end());
+}
+
+/// Entries in the page used to compare the JSON and CBOR encodings.
+constexpr int kBenchmarkEntries = 100000;
+
+/**
+ * @brief Builds a page of kBenchmarkEntries full entries, as the server encodes it in either format.
+ * @param binaryHash Store each SHA-256 as a byte string, as CBOR replies do, instead of hex text.
+ */
+nlohmann::json benchmarkPage(bool binaryHash)
+{
+    nlohmann::json files = nlohmann::json::array();
+    for (int i = 0; i < kBenchmarkEntries; ++i) {
+        std::vector<std::uint8_t> digest(32);
+        for (size_t b = 0; b < digest.size(); ++b)
+            digest[b] = static_cast<std::uint8_t>((i * 2654435761u) >> (b % 24));
+        QByteArray hex = QByteArray(reinterpret_cast<const char *>(digest.data()), int(digest.size())).toHex();
+        files.push_back({{"name", "photos/2024/IMG_" + std::to_string(100000 + i) + ".jpg"},
+                         {"size", 1000000 + i * 37},
+                         {"mtime", 1700000000000LL + i * 1000},
+                         {"hash", binaryHash ? nlohmann::json::binary(digest) : nlohmann::json(hex.toStdString())},
+                         {"mime", "image/jpeg"}});
+    }
+    return {{"files", files}, {"next", nullptr}, {"seq", 1}};
+}
+
+QStringList namesOf(const std::vector<APIClient::RemoteFile> &files)
+{
+    QStringList names;
+    for (const APIClient::RemoteFile &file : files)
+        names << file.name;
+    return names;
+}
+
+} // namespace
+
+/**
+ * @class TestListingParser
+ * @brief Checks ListingParser on both listing shapes, in JSON and CBOR, and the change journal helpers.
+ */
+class TestListingParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void plainArray();
+    void paginatedPage();
+    void lastPage();
+    void batching_data();
+    void batching();
+    void unknownKeysSkipped();
+    void entriesWithoutNameDropped();
+    void callbackStops();
+    void malformedInput();
+    void cborInput();
+    void entryFromJson();
+    void changeFromJson();
+    void decodeCost_data();
+    void decodeCost();
+};
+
+/**
+ * @brief A plain array of names is a complete, unpaginated listing.
+ */
+void TestListingParser::plainArray()
+{
+    Listing listing = parse(R"(["a.txt", "b.txt", "c.txt"])", 10);
+
+    QVERIFY(listing.parsed);
+    QVERIFY(!listing.paginated);
+    QVERIFY(listing.next.empty());
+    QCOMPARE(listing.sequence, qint64(-1));
+    QCOMPARE(listing.count, size_t(3));
+    QCOMPARE(namesOf(listing.files), QStringList({"a.txt", "b.txt", "c.txt"}));
+    QCOMPARE(listing.files.front().size, qint64(-1));
+    QCOMPARE(listing.files.front().modified, qint64(0));
+}
+
+/**
+ * @brief A page carries full entries, the next cursor and the change sequence.
+ */
+void TestListingParser::paginatedPage()
+{
+    Listing listing = parse(R"({"files": [{"name": "photo.jpg", "size": 2048, "mtime": 1700000000123,
+                                            "hash": "0123abcd", "mime": "image/jpeg"},
+                                           "notes.txt"],
+                                "next": "cursor-2", "seq": 42})", 10);
+
+    QVERIFY(listing.parsed);
+    QVERIFY(listing.paginated);
+    QCOMPARE(QString::fromStdString(listing.next), QString("cursor-2"));
+    QCOMPARE(listing.sequence, qint64(42));
+    QCOMPARE(listing.files.size(), size_t(2));
+
+    const APIClient::RemoteFile &photo = listing.files[0];
+    QCOMPARE(photo.name, QString("photo.jpg"));
+    QCOMPARE(photo.size, qint64(2048));
+    QCOMPARE(photo.modified, qint64(1700000000123LL));
+    QCOMPARE(photo.contentHash, QString("0123abcd"));
+    QCOMPARE(photo.mimeType, QString("image/jpeg"));
+
+    const APIClient::RemoteFile &notes = listing.files[1];
+    QCOMPARE(notes.name, QString("notes.txt"));
+    QCOMPARE(notes.size, qint64(-1));
+    QVERIFY(notes.contentHash.isEmpty());
+}
+
+/**
+ * @brief A null cursor marks the last page, wherever the key appears.
+ */
+void TestListingParser::lastPage()
+{
+    Listing listing = parse(R"({"next": null, "seq": 7, "files": ["only"]})", 10);
+
+    QVERIFY(listing.parsed);
+    QVERIFY(listing.paginated);
+    QVERIFY(listing.next.empty());
+    QCOMPARE(listing.sequence, qint64(7));
+    QCOMPARE(namesOf(listing.files), QStringList({"only"}));
+}
+
+/**
+ * @brief Rows: batch size, entry count, and the batch sizes the callback should see.
+ */
+void TestListingParser::batching_data()
+{
+    QTest::addColumn<int>("batchSize");
+    QTest::addColumn<int>("entries");
+    QTest::addColumn<QList<int>>("expected");
+
+    QTest::newRow("exact multiple") << 2 << 4 << QList<int>({2, 2});
+    QTest::newRow("remainder flushed") << 3 << 7 << QList<int>({3, 3, 1});
+    QTest::newRow("one batch") << 10 << 4 << QList<int>({4});
+    QTest::newRow("zero means one") << 0 << 3 << QList<int>({1, 1, 1});
+    QTest::newRow("empty") << 5 << 0 << QList<int>();
+}
+
+/**
+ * @brief Entries are delivered every batchSize files, and flush() hands over the rest.
+ */
+void TestListingParser::batching()
+{
+    QFETCH(int, batchSize);
+    QFETCH(int, entries);
+    QFETCH(QList<int>, expected);
+
+    nlohmann::json files = nlohmann::json::array();
+    for (int i = 0; i < entries; ++i)
+        files.push_back({{"name", "file" + std::to_string(i)}, {"size", i}});
+    Listing listing = parse(nlohmann::json{{"files", files}, {"next", nullptr}}.dump(),
+                            static_cast<size_t>(batchSize));
+
+    QVERIFY(listing.parsed);
+    QList<int> batches;
+    for (size_t batch : listing.batches)
+        batches << static_cast<int>(batch);
+    QCOMPARE(batches, expected);
+    QCOMPARE(listing.count, static_cast<size_t>(entries));
+    for (int i = 0; i < entries; ++i) {
+        QCOMPARE(listing.files[i].name, QString("file%1").arg(i));
+        QCOMPARE(listing.files[i].size, qint64(i));
+    }
+}
+
+/**
+ * @brief Unknown members, including nested ones that reuse known key names, do not leak into the listing.
+ */
+void TestListingParser::unknownKeysSkipped()
+{
+    Listing listing = parse(R"({"meta": {"files": ["decoy"], "next": "decoy", "seq": 99},
+                                "files": [{"owner": {"name": "decoy", "size": 1}, "name": "real",
+                                           "tags": ["a", 1, true, null, 2.5], "size": 5, "shared": false}],
+                                "stats": [["decoy"], {"files": []}],
+                                "next": "page-2"})", 10);
+
+    QVERIFY(listing.parsed);
+    QCOMPARE(namesOf(listing.files), QStringList({"real"}));
+    QCOMPARE(listing.files.front().size, qint64(5));
+    QCOMPARE(QString::fromStdString(listing.next), QString("page-2"));
+    QCOMPARE(listing.sequence, qint64(-1));
+}
+
+/**
+ * @brief Object entries without a name are skipped rather than delivered blank.
+ */
+void TestListingParser::entriesWithoutNameDropped()
+{
+    Listing listing = parse(R"([{"size": 1}, {"name": "kept", "size": 2}, {"name": ""}])", 10);
+
+    QVERIFY(listing.parsed);
+    QCOMPARE(namesOf(listing.files), QStringList({"kept"}));
+    QCOMPARE(listing.count, size_t(1));
+}
+
+/**
+ * @brief A callback returning false stops the parse after that batch.
+ */
+void TestListingParser::callbackStops()
+{
+    Listing listing = parse(R"(["a", "b", "c", "d", "e"])", 2, Format::json, 1);
+
+    QVERIFY(!listing.parsed);
+    QCOMPARE(listing.batches.size(), size_t(1));
+    QCOMPARE(namesOf(listing.files), QStringList({"a", "b"}));
+}
+
+/**
+ * @brief Truncated input fails the parse; full batches already delivered stay delivered.
+ */
+void TestListingParser::malformedInput()
+{
+    Listing listing = parse(R"({"files": ["a", "b", "c")", 2);
+
+    QVERIFY(!listing.parsed);
+    QCOMPARE(namesOf(listing.files), QStringList({"a", "b"}));
+}
+
+/**
+ * @brief The same page in CBOR parses identically, with a byte-string hash stored as hex.
+ */
+void TestListingParser::cborInput()
+{
+    nlohmann::json page = {
+        {"files", {{{"name", "blob.bin"}, {"size", 70000}, {"mtime", 1700000000000LL},
+                    {"hash", nlohmann::json::binary({0xde, 0xad, 0xbe, 0xef})}, {"mime", "application/octet-stream"}},
+                   {{"name", "text.txt"}, {"hash", "cafe"}, {"size", 1.0}},
+                   "bare"}},
+        {"next", "c2"},
+        {"seq", 12},
+    };
+    Listing listing = parse(cbor(page), 2, Format::cbor);
+
+    QVERIFY(listing.parsed);
+    QVERIFY(listing.paginated);
+    QCOMPARE(QString::fromStdString(listing.next), QString("c2"));
+    QCOMPARE(listing.sequence, qint64(12));
+    QCOMPARE(listing.batches, std::vector<size_t>({2, 1}));
+    QCOMPARE(namesOf(listing.files), QStringList({"blob.bin", "text.txt", "bare"}));
+
+    const APIClient::RemoteFile &blob = listing.files[0];
+    QCOMPARE(blob.size, qint64(70000));
+    QCOMPARE(blob.modified, qint64(1700000000000LL));
+    QCOMPARE(blob.contentHash, QString("deadbeef"));
+    QCOMPARE(blob.mimeType, QString("application/octet-stream"));
+    QCOMPARE(listing.files[1].contentHash, QString("cafe"));
+    QCOMPARE(listing.files[1].size, qint64(1));
+}
+
+/**
+ * @brief A DOM entry maps onto RemoteFile, leaving absent fields unknown.
+ */
+void TestListingParser::entryFromJson()
+{
+    APIClient::RemoteFile full = ListingParser::entryFromJson(
+        {{"name", "a.txt"}, {"size", 10}, {"mtime", 5}, {"hash", "ff"}, {"mime", "text/plain"}});
+    QCOMPARE(full.name, QString("a.txt"));
+    QCOMPARE(full.size, qint64(10));
+    QCOMPARE(full.modified, qint64(5));
+    QCOMPARE(full.contentHash, QString("ff"));
+    QCOMPARE(full.mimeType, QString("text/plain"));
+
+    APIClient::RemoteFile sparse = ListingParser::entryFromJson({{"name", "b.txt"}});
+    QCOMPARE(sparse.name, QString("b.txt"));
+    QCOMPARE(sparse.size, qint64(-1));
+    QCOMPARE(sparse.modified, qint64(0));
+    QVERIFY(sparse.contentHash.isEmpty());
+    QVERIFY(sparse.mimeType.isEmpty());
+}
+
+/**
+ * @brief Journal entries decode by operation; unknown operations and nameless entries are rejected.
+ */
+void TestListingParser::changeFromJson()
+{
+    APIClient::FileChange change;
+    QVERIFY(ListingParser::changeFromJson({{"op", "add"}, {"file", {{"name", "new.txt"}, {"size", 3}}}}, change));
+    QCOMPARE(change.type, APIClient::FileChange::Type::Added);
+    QCOMPARE(change.file.name, QString("new.txt"));
+    QCOMPARE(change.file.size, qint64(3));
+
+    change = APIClient::FileChange();
+    QVERIFY(ListingParser::changeFromJson({{"op", "remove"}, {"name", "old.txt"}}, change));
+    QCOMPARE(change.type, APIClient::FileChange::Type::Removed);
+    QCOMPARE(change.file.name, QString("old.txt"));
+
+    change = APIClient::FileChange();
+    QVERIFY(ListingParser::changeFromJson({{"op", "rename"}, {"from", "a.txt"}, {"to", "b.txt"}}, change));
+    QCOMPARE(change.type, APIClient::FileChange::Type::Renamed);
+    QCOMPARE(change.oldName, QString("a.txt"));
+    QCOMPARE(change.file.name, QString("b.txt"));
+
+    change = APIClient::FileChange();
+    QVERIFY(!ListingParser::changeFromJson({{"op", "chmod"}, {"name", "a.txt"}}, change));
+    QVERIFY(!ListingParser::changeFromJson({{"op", "add"}, {"file", {{"size", 1}}}}, change));
+}
+
+/**
+ * @brief The benchmark page in each format the client accepts.
+ */
+void TestListingParser::decodeCost_data()
+{
+    QTest::addColumn<QByteArray>("encoded");
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("JSON") << QByteArray::fromStdString(benchmarkPage(false).dump()) << int(Format::json);
+    QTest::newRow("CBOR") << QByteArray::fromStdString(cbor(benchmarkPage(true))) << int(Format::cbor);
+}
+
+/**
+ * @brief Prints the encoded size of a 100k-entry page and times parsing it with the client's batch size.
+ */
+void TestListingParser::decodeCost()
+{
+    QFETCH(QByteArray, encoded);
+    QFETCH(int, format);
+    const std::string document = encoded.toStdString();
+
+    size_t entries = 0;
+    bool parsed = false;
+    QBENCHMARK {
+        entries = 0;
+        ListingParser parser([&entries](std::vector<APIClient::RemoteFile> &files) {
+            entries += files.size();
+            return true;
+        }, 1000);
+        parsed = nlohmann::json::sax_parse(document, &parser, static_cast<Format>(format)) && parser.flush();
+    }
+
+    QVERIFY(parsed);
+    QCOMPARE(entries, size_t(kBenchmarkEntries));
+    qInfo().noquote() << QString("%1: %2 bytes for %3 entries (%4 bytes each)")
+                             .arg(QTest::currentDataTag())
+                             .arg(document.size())
+                             .arg(kBenchmarkEntries)
+                             .arg(double(document.size()) / kBenchmarkEntries, 0, 'f', 1);
+}
+
+QTEST_APPLESS_MAIN(TestListingParser)
+#include "tst_listingparser.moc"
@@ -0,0 +1,61 @@
+#ifndef LOCALSERVER_H
+#define LOCALSERVER_H
+
+#include <QString>
+#include <thread>
+#include "cpp-httplib/httplib.h"
+
+/**
+ * @class LocalServer
+ * @brief An httplib::Server on a free loopback port, run on its own thread.
+ *
+ * Tests register their handlers on server() and then call start(); the server
+ * is stopped when the object goes out of scope.
+ */
+class LocalServer {
+public:
+    LocalServer() = default;
+    ~LocalServer() { stop(); }
+
+    LocalServer(const LocalServer &) = delete;
+    LocalServer &operator=(const LocalServer &) = delete;
+
+    httplib::Server &server() { return m_server; }
+
+    /**
+     * @brief Binds to any free port and starts serving.
+     * @return false if no port could be bound.
+     */
+    bool start()
+    {
+        m_port = m_server.bind_to_any_port("127.0.0.1");
+        if (m_port <= 0)
+            return false;
+        m_thread = std::thread([this]() { m_server.listen_after_bind(); });
+        m_server.wait_until_ready();
+        return true;
+    }
+
+    /**
+     * @brief Stops serving and waits for the server thread.
+     */
+    void stop()
+    {
+        if (m_thread.joinable()) {
+            m_server.stop();
+            m_thread.join();
+        }
+    }
+
+    /**
+     * @brief Returns the base URL to hand to APIClient.
+     */
+    QString url() const { return QString("http://127.0.0.1:%1").arg(m_port); }
+
+private:
+    httplib::Server m_server;
+    std::thread m_thread;
+    int m_port = -1;
+};
+
+#endif // LOCALSERVER_H
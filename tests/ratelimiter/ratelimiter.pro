@@ -0,0 +1,7 @@
+include(../tests.pri)
+include(../client.pri)
+
+TARGET = tst_ratelimiter
+
+SOURCES += \
+    tst_ratelimiter.cpp
@@ -0,0 +1,260 @@
+#include "ratelimiter.h"
+#include "APIClient.h"
+#include "localserver.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Rate used by the timing tests.
+constexpr qint64 kRate = 1024 * 1024;
+
+/// Block size a transfer hands to consume().
+constexpr qint64 kBlock = 64 * 1024;
+
+/// Bytes that take one second at kRate once the initial quarter-second burst is used up.
+constexpr qint64 kOneSecondOfBytes = kRate + kRate / 4;
+
+/// Allowed lateness; sleeping can overshoot on a loaded machine but never undershoots.
+constexpr qint64 kSlackMs = 300;
+
+/**
+ * @brief Writes @p size random bytes, which CompressionPolicy sends uncompressed.
+ */
+bool writeRandomFile(const QString &path, qint64 size)
+{
+    QByteArray data(static_cast<int>(size), Qt::Uninitialized);
+    QRandomGenerator generator(7);
+    for (char &byte : data)
+        byte = static_cast<char>(generator.bounded(256));
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+/**
+ * @brief Starts @p server with an upload endpoint that drops every body and a download of @p content.
+ */
+bool startTransferServer(LocalServer &server, const std::string &content = std::string())
+{
+    server.server().Post("/api/upload", [](const httplib::Request &, httplib::Response &res) {
+        res.status = 200;
+    });
+    server.server().Get("/api/download/limited.bin", [content](const httplib::Request &, httplib::Response &res) {
+        res.set_content(content, "application/octet-stream");
+    });
+    return server.start();
+}
+
+} // namespace
+
+/**
+ * @class TestRateLimiter
+ * @brief Times the token bucket against its configured rate, alone and under real transfers.
+ */
+class TestRateLimiter : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void unlimitedDoesNotWait();
+    void holdsTheRate();
+    void sharedAcrossThreads();
+    void raisingTheRateTakesEffect();
+    void globalBucketsFollowSetRate();
+    void interactiveScopesAreCounted();
+    void firstBlockIsCharged();
+    void perTransferCapHoldsTheRate_data();
+    void perTransferCapHoldsTheRate();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+/**
+ * @brief Keeps the global buckets from reading limits out of the user's configuration.
+ */
+void TestRateLimiter::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+}
+
+/**
+ * @brief A zero rate never sleeps, however much is consumed.
+ */
+void TestRateLimiter::unlimitedDoesNotWait()
+{
+    RateLimiter limiter;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 1000; ++i)
+        limiter.consume(kRate);
+    QVERIFY(timer.elapsed() < 100);
+}
+
+/**
+ * @brief A single stream is paced to the rate, after the initial burst.
+ */
+void TestRateLimiter::holdsTheRate()
+{
+    RateLimiter limiter(kRate);
+    QElapsedTimer timer;
+    timer.start();
+    for (qint64 sent = 0; sent < kOneSecondOfBytes; sent += kBlock)
+        limiter.consume(kBlock);
+    const qint64 elapsed = timer.elapsed();
+    QVERIFY2(elapsed >= 1000 - 1000 * kBlock / kRate && elapsed <= 1000 + kSlackMs,
+             qPrintable(QString("took %1 ms").arg(elapsed)));
+}
+
+/**
+ * @brief Several threads on one bucket share the rate rather than each getting it.
+ */
+void TestRateLimiter::sharedAcrossThreads()
+{
+    RateLimiter limiter(kRate);
+    constexpr int kThreads = 4;
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&limiter]() {
+            for (qint64 sent = 0; sent < kOneSecondOfBytes / kThreads; sent += kBlock / 4)
+                limiter.consume(kBlock / 4);
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+    const qint64 elapsed = timer.elapsed();
+    QVERIFY2(elapsed >= 1000 - 1000 * kBlock / kRate && elapsed <= 1000 + kSlackMs,
+             qPrintable(QString("took %1 ms").arg(elapsed)));
+}
+
+/**
+ * @brief Raising the rate speeds a running stream up at once.
+ */
+void TestRateLimiter::raisingTheRateTakesEffect()
+{
+    RateLimiter limiter(kRate / 4);
+    limiter.consume(kRate / 16);
+    limiter.setRate(0);
+    QCOMPARE(limiter.rate(), qint64(0));
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 100; ++i)
+        limiter.consume(kRate);
+    QVERIFY(timer.elapsed() < 100);
+}
+
+/**
+ * @brief The shared buckets change rate while the process runs.
+ */
+void TestRateLimiter::globalBucketsFollowSetRate()
+{
+    QCOMPARE(RateLimiter::globalUpload().rate(), qint64(0));
+    RateLimiter::globalUpload().setRate(kRate);
+    RateLimiter::globalDownload().setRate(2 * kRate);
+    QCOMPARE(RateLimiter::globalUpload().rate(), kRate);
+    QCOMPARE(RateLimiter::globalDownload().rate(), 2 * kRate);
+    RateLimiter::globalUpload().setRate(0);
+    RateLimiter::globalDownload().setRate(0);
+    QCOMPARE(RateLimiter::globalUpload().rate(), qint64(0));
+}
+
+/**
+ * @brief Interactive requests in flight are counted for background transfers to yield to.
+ */
+void TestRateLimiter::interactiveScopesAreCounted()
+{
+    QCOMPARE(RateLimiter::interactiveCount(), 0);
+    {
+        RateLimiter::InteractiveScope first;
+        QCOMPARE(RateLimiter::interactiveCount(), 1);
+        {
+            RateLimiter::InteractiveScope second;
+            QCOMPARE(RateLimiter::interactiveCount(), 2);
+        }
+        QCOMPARE(RateLimiter::interactiveCount(), 1);
+    }
+    QCOMPARE(RateLimiter::interactiveCount(), 0);
+}
+
+/**
+ * @brief The first progress report of an upload is paced like the rest, not taken as free.
+ *
+ * The file goes out as a single block, so an uncharged first report would let
+ * it through without any wait.
+ */
+void TestRateLimiter::firstBlockIsCharged()
+{
+    LocalServer server;
+    QVERIFY(startTransferServer(server));
+    const QString path = m_dir.filePath("first-block.bin");
+    constexpr qint64 kFileSize = 256 * 1024;
+    QVERIFY(writeRandomFile(path, kFileSize));
+
+    constexpr qint64 kUploadRate = kRate / 4;
+    RateLimiter::globalUpload().setRate(kUploadRate);
+    QElapsedTimer timer;
+    timer.start();
+    const bool uploaded = APIClient(server.url()).uploadFile(path);
+    const qint64 elapsed = timer.elapsed();
+    RateLimiter::globalUpload().setRate(0);
+
+    QVERIFY(uploaded);
+    // At most a quarter second of burst is free; the rest of the block has to wait.
+    const qint64 minimumMs = 1000 * (kFileSize - kUploadRate / 4) / kUploadRate - 50;
+    QVERIFY2(elapsed >= minimumMs, qPrintable(QString("took %1 ms").arg(elapsed)));
+}
+
+/**
+ * @brief Rows: transfer direction.
+ */
+void TestRateLimiter::perTransferCapHoldsTheRate_data()
+{
+    QTest::addColumn<bool>("upload");
+    QTest::newRow("upload") << true;
+    QTest::newRow("download") << false;
+}
+
+/**
+ * @brief A client's own cap paces its transfer to the rate while the global buckets are unlimited.
+ */
+void TestRateLimiter::perTransferCapHoldsTheRate()
+{
+    QFETCH(bool, upload);
+    QCOMPARE(RateLimiter::globalUpload().rate(), qint64(0));
+    QCOMPARE(RateLimiter::globalDownload().rate(), qint64(0));
+
+    const QString path = m_dir.filePath("limited.bin");
+    QVERIFY(writeRandomFile(path, kOneSecondOfBytes));
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    LocalServer server;
+    QVERIFY(startTransferServer(server, file.readAll().toStdString()));
+    file.close();
+
+    APIClient client(server.url());
+    client.setRateLimits(upload ? kRate : 0, upload ? 0 : kRate);
+    QElapsedTimer timer;
+    timer.start();
+    const bool done = upload ? client.uploadFile(path)
+                             : client.downloadFile("limited.bin", m_dir.filePath("limited.out"));
+    const qint64 elapsed = timer.elapsed();
+
+    QVERIFY(done);
+    QVERIFY2(elapsed >= 1000 - 1000 * kBlock / kRate && elapsed <= 1000 + kSlackMs,
+             qPrintable(QString("took %1 ms").arg(elapsed)));
+}
+
+QTEST_GUILESS_MAIN(TestRateLimiter)
+#include "tst_ratelimiter.moc"
@@ -0,0 +1,202 @@
+#include "APIClient.h"
+#include "localserver.h"
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Size of the served file; several reads long, well under the journal interval.
+constexpr qint64 kPayloadSize = 3 * 1024 * 1024 + 123;
+
+/// Remote name; a .zip is never compressed, so every request may carry a Range.
+const char *const kFileName = "archive.zip";
+
+QByteArray randomPayload(quint32 seed)
+{
+    QByteArray data(static_cast<int>(kPayloadSize), Qt::Uninitialized);
+    QRandomGenerator generator(seed);
+    for (char &byte : data)
+        byte = static_cast<char>(generator.bounded(256));
+    return data;
+}
+
+QByteArray readAll(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+} // namespace
+
+/**
+ * @class TestResumableDownload
+ * @brief Cuts downloads at chosen offsets and checks that APIClient resumes them with Range requests.
+ */
+class TestResumableDownload : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void resumesAfterDroppedConnection_data();
+    void resumesAfterDroppedConnection();
+    void resumesInLaterCall();
+    void restartsWhenRemoteFileChanged();
+
+private:
+    QTemporaryDir m_dir;
+    QString m_destination;
+    std::unique_ptr<LocalServer> m_server;
+
+    std::mutex m_mutex;
+    QByteArray m_payload;                 ///< Content currently served
+    std::string m_etag;                   ///< ETag currently served
+    std::vector<qint64> m_rangeStarts;    ///< First byte asked for by each request, 0 without Range
+    std::atomic<qint64> m_cutAt{-1};      ///< Drop the next response at this offset, or -1
+};
+
+/**
+ * @brief Keeps settings written by the client out of the user's configuration.
+ */
+void TestResumableDownload::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+}
+
+/**
+ * @brief Starts a server whose download handler honours Range and can drop one response part-way.
+ */
+void TestResumableDownload::init()
+{
+    m_destination = m_dir.filePath("download.zip");
+    QFile::remove(m_destination);
+    QFile::remove(m_destination + ".part");
+    QFile::remove(m_destination + ".part.json");
+    m_payload = randomPayload(1);
+    m_etag = "\"v1\"";
+    m_rangeStarts.clear();
+    m_cutAt = -1;
+
+    m_server = std::make_unique<LocalServer>();
+    m_server->server().Get(R"(/api/download/(.+))", [this](const httplib::Request &req, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rangeStarts.push_back(req.ranges.empty() ? 0 : static_cast<qint64>(req.ranges.front().first));
+        res.set_header("ETag", m_etag);
+        QByteArray payload = m_payload;
+        // httplib slices the provider to the requested range and answers 206 by itself.
+        res.set_content_provider(static_cast<size_t>(payload.size()), "application/zip",
+            [this, payload](size_t offset, size_t length, httplib::DataSink &sink) {
+                qint64 cut = m_cutAt.load();
+                if (cut >= 0 && static_cast<qint64>(offset + length) > cut) {
+                    m_cutAt = -1;
+                    if (cut > static_cast<qint64>(offset))
+                        sink.write(payload.constData() + offset, static_cast<size_t>(cut) - offset);
+                    return false;
+                }
+                return sink.write(payload.constData() + offset, length);
+            });
+    });
+    QVERIFY(m_server->start());
+}
+
+/**
+ * @brief Stops the server so the next test gets a fresh port and connection pool entry.
+ */
+void TestResumableDownload::cleanup()
+{
+    m_server.reset();
+}
+
+/**
+ * @brief Offsets at which the first response is dropped.
+ */
+void TestResumableDownload::resumesAfterDroppedConnection_data()
+{
+    QTest::addColumn<qint64>("cut");
+    QTest::newRow("first byte") << qint64(1);
+    QTest::newRow("inside first read") << qint64(1000);
+    QTest::newRow("middle") << kPayloadSize / 2 + 17;
+    QTest::newRow("random") << qint64(QRandomGenerator(7).bounded(2, static_cast<int>(kPayloadSize) - 1));
+    QTest::newRow("last byte") << kPayloadSize - 1;
+}
+
+/**
+ * @brief A dropped connection is retried within the same call, asking only for the missing bytes.
+ */
+void TestResumableDownload::resumesAfterDroppedConnection()
+{
+    QFETCH(qint64, cut);
+    m_cutAt = cut;
+
+    QVERIFY(APIClient(m_server->url()).downloadFile(kFileName, m_destination));
+
+    QCOMPARE(readAll(m_destination), m_payload);
+    QVERIFY(!QFile::exists(m_destination + ".part"));
+    QVERIFY(!QFile::exists(m_destination + ".part.json"));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_rangeStarts.size(), size_t(2));
+    QCOMPARE(m_rangeStarts[0], qint64(0));
+    // Bytes that reached the client before the drop are not fetched again.
+    QVERIFY(m_rangeStarts[1] > 0);
+    QVERIFY(m_rangeStarts[1] <= cut);
+}
+
+/**
+ * @brief A cancelled download leaves a part file and journal that a later call continues from.
+ */
+void TestResumableDownload::resumesInLaterCall()
+{
+    const qint64 stopAfter = kPayloadSize / 3;
+    bool finished = APIClient(m_server->url()).downloadFile(kFileName, m_destination,
+        [stopAfter](qint64 received, qint64) { return received < stopAfter; });
+    QVERIFY(!finished);
+    QVERIFY(QFile::exists(m_destination + ".part"));
+    QVERIFY(QFile::exists(m_destination + ".part.json"));
+    QVERIFY(!QFile::exists(m_destination));
+
+    QVERIFY(APIClient(m_server->url()).downloadFile(kFileName, m_destination));
+    QCOMPARE(readAll(m_destination), m_payload);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_rangeStarts.size(), size_t(2));
+    QVERIFY(m_rangeStarts[1] >= stopAfter);
+}
+
+/**
+ * @brief A part file is thrown away when the server's copy changed since it was written.
+ */
+void TestResumableDownload::restartsWhenRemoteFileChanged()
+{
+    QVERIFY(!APIClient(m_server->url()).downloadFile(kFileName, m_destination,
+        [](qint64 received, qint64) { return received < kPayloadSize / 2; }));
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_payload = randomPayload(2);
+        m_etag = "\"v2\"";
+    }
+
+    QVERIFY(APIClient(m_server->url()).downloadFile(kFileName, m_destination));
+    QCOMPARE(readAll(m_destination), m_payload);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QVERIFY(m_rangeStarts.size() >= 3);
+    QCOMPARE(m_rangeStarts.back(), qint64(0));
+}
+
+QTEST_GUILESS_MAIN(TestResumableDownload)
+#include "tst_resumabledownload.moc"
@@ -0,0 +1,7 @@
+include(../tests.pri)
+include(../client.pri)
+
+TARGET = tst_retrypolicy
+
+SOURCES += \
+    tst_retrypolicy.cpp
@@ -0,0 +1,353 @@
+#include "retrypolicy.h"
+#include "APIClient.h"
+#include "apimetrics.h"
+#include "localserver.h"
+#include <QSet>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <QFile>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::chrono::milliseconds;
+
+/**
+ * @class TestRetryPolicy
+ * @brief Checks backoff and budgets, and that retried requests keep their Idempotency-Key.
+ */
+class TestRetryPolicy : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void transientStatuses_data();
+    void transientStatuses();
+    void delaysStayUnderCeiling();
+    void retryAfterIsAMinimum();
+    void budgetAndAttemptsLimit();
+    void parseRetryAfter_data();
+    void parseRetryAfter();
+    void idempotencyKeysAreUnique();
+
+    void retriesReuseIdempotencyKey();
+    void separateCallsUseNewKeys();
+    void finalStatusIsNotRetried();
+    void givesUpAfterMaxAttempts();
+    void batchRetriesReuseIdempotencyKey();
+    void lostReplyDoesNotCreateTwice();
+    void closedIdleConnectionIsNotReused();
+
+private:
+    QTemporaryDir m_dir;
+    std::unique_ptr<LocalServer> m_server;
+
+    std::mutex m_mutex;
+    std::vector<std::string> m_keys;  ///< Idempotency-Key of every request received
+    std::atomic<int> m_failures{0};   ///< Requests still to be answered with m_failStatus
+    int m_failStatus = 503;
+    std::atomic<int> m_drops{0};      ///< Uploads still to be committed and then cut off before the reply
+    std::map<std::string, std::string> m_uploads;  ///< Stored file content by the Idempotency-Key that created it
+};
+
+/**
+ * @brief Keeps settings read by the client out of the user's configuration.
+ */
+void TestRetryPolicy::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+}
+
+/**
+ * @brief Starts a server that fails the first m_failures mutating requests and records their keys.
+ */
+void TestRetryPolicy::init()
+{
+    m_keys.clear();
+    m_failures = 0;
+    m_failStatus = 503;
+    m_drops = 0;
+    m_uploads.clear();
+
+    m_server = std::make_unique<LocalServer>();
+    // Close idle keep-alive connections well inside the pool's own idle timeout.
+    m_server->server().set_keep_alive_timeout(1);
+    auto handler = [this](const httplib::Request &req, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_keys.push_back(req.get_header_value("Idempotency-Key"));
+        if (m_failures > 0) {
+            --m_failures;
+            res.status = m_failStatus;
+            res.set_header("Retry-After", "0");
+            return;
+        }
+        if (req.path == "/api/batch/delete") {
+            res.set_content(R"({"results":[{"ok":true},{"ok":true}]})", "application/json");
+        } else {
+            res.status = 200;
+        }
+    };
+    m_server->server().Post("/api/rename", handler);
+    m_server->server().Post("/api/batch/delete", handler);
+    // Applies each upload once per key and replays the outcome for repeats. With
+    // m_drops set, the connection is cut after the file is stored, as if the
+    // server crashed or the network failed before the reply got out.
+    m_server->server().Post("/api/upload", [this](const httplib::Request &req, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::string key = req.get_header_value("Idempotency-Key");
+        m_keys.push_back(key);
+        if (m_uploads.count(key) == 0)
+            m_uploads[key] = req.get_file_value("file").content;
+        if (m_drops > 0) {
+            --m_drops;
+            res.set_content_provider(2, "text/plain", [](size_t, size_t, httplib::DataSink &) { return false; });
+        }
+    });
+    QVERIFY(m_server->start());
+}
+
+/**
+ * @brief Stops the server so the next test gets a fresh port and connection pool entry.
+ */
+void TestRetryPolicy::cleanup()
+{
+    m_server.reset();
+}
+
+/**
+ * @brief HTTP statuses and whether they are worth another attempt.
+ */
+void TestRetryPolicy::transientStatuses_data()
+{
+    QTest::addColumn<int>("status");
+    QTest::addColumn<bool>("transient");
+    for (int status : { 408, 425, 429, 500, 502, 503, 504 })
+        QTest::newRow(qPrintable(QString::number(status))) << status << true;
+    for (int status : { 200, 206, 304, 400, 401, 403, 404, 405, 409, 416, 501 })
+        QTest::newRow(qPrintable(QString::number(status))) << status << false;
+}
+
+/**
+ * @brief Only timeouts, throttling and gateway errors are retried.
+ */
+void TestRetryPolicy::transientStatuses()
+{
+    QFETCH(int, status);
+    QFETCH(bool, transient);
+    QCOMPARE(RetryPolicy::isTransientStatus(status), transient);
+}
+
+/**
+ * @brief Jittered delays never exceed the doubling ceiling or the cap, and do not all collapse to zero.
+ */
+void TestRetryPolicy::delaysStayUnderCeiling()
+{
+    const RetryPolicy policy(10, milliseconds(100), milliseconds(1000), milliseconds(60000));
+    for (int attempt = 1; attempt <= 8; ++attempt) {
+        const milliseconds ceiling(std::min<long long>(1000, 100LL << (attempt - 1)));
+        milliseconds longest(0);
+        for (int sample = 0; sample < 500; ++sample) {
+            milliseconds delay = policy.delayFor(attempt);
+            QVERIFY(delay >= milliseconds(0));
+            QVERIFY(delay <= ceiling);
+            longest = std::max(longest, delay);
+        }
+        QVERIFY(longest > ceiling / 2);
+    }
+}
+
+/**
+ * @brief A server's Retry-After is honoured even when the drawn delay is shorter.
+ */
+void TestRetryPolicy::retryAfterIsAMinimum()
+{
+    const RetryPolicy policy(5, milliseconds(10), milliseconds(20), milliseconds(60000));
+    for (int sample = 0; sample < 100; ++sample)
+        QCOMPARE(policy.delayFor(1, milliseconds(3000)), milliseconds(3000));
+}
+
+/**
+ * @brief Retries stop at the attempt limit or when the time budget would be exceeded.
+ */
+void TestRetryPolicy::budgetAndAttemptsLimit()
+{
+    const RetryPolicy policy(3, milliseconds(100), milliseconds(1000), milliseconds(1000));
+    QVERIFY(policy.allows(1, milliseconds(0), milliseconds(100)));
+    QVERIFY(policy.allows(2, milliseconds(500), milliseconds(500)));
+    QVERIFY(!policy.allows(3, milliseconds(0), milliseconds(0)));
+    QVERIFY(!policy.allows(1, milliseconds(900), milliseconds(101)));
+
+    QCOMPARE(RetryPolicy::forOperation(RetryPolicy::Operation::Metadata).maxAttempts(), 4);
+    QCOMPARE(RetryPolicy::forOperation(RetryPolicy::Operation::Batch).maxAttempts(), 3);
+    QCOMPARE(RetryPolicy::forOperation(RetryPolicy::Operation::Transfer).maxAttempts(), 5);
+    QCOMPARE(RetryPolicy(0, milliseconds(0), milliseconds(0), milliseconds(0)).maxAttempts(), 1);
+}
+
+/**
+ * @brief Retry-After header values and the wait they give.
+ */
+void TestRetryPolicy::parseRetryAfter_data()
+{
+    QTest::addColumn<QString>("value");
+    QTest::addColumn<qint64>("expectedMs");
+    QTest::newRow("empty") << QString() << qint64(0);
+    QTest::newRow("zero") << QString("0") << qint64(0);
+    QTest::newRow("seconds") << QString("5") << qint64(5000);
+    QTest::newRow("http date") << QString("Wed, 21 Oct 2026 07:28:00 GMT") << qint64(0);
+    QTest::newRow("negative") << QString("-1") << qint64(0);
+    QTest::newRow("fraction") << QString("1.5") << qint64(0);
+    QTest::newRow("huge") << QString("99999999999") << qint64(86400000);
+}
+
+/**
+ * @brief Only whole seconds are accepted, and absurd values are clamped to a day.
+ */
+void TestRetryPolicy::parseRetryAfter()
+{
+    QFETCH(QString, value);
+    QFETCH(qint64, expectedMs);
+    QCOMPARE(qint64(RetryPolicy::parseRetryAfter(value.toStdString()).count()), expectedMs);
+}
+
+/**
+ * @brief Fresh keys are non-empty and never repeat.
+ */
+void TestRetryPolicy::idempotencyKeysAreUnique()
+{
+    QSet<QString> keys;
+    for (int i = 0; i < 1000; ++i) {
+        QString key = QString::fromStdString(RetryPolicy::newIdempotencyKey());
+        QVERIFY(!key.isEmpty());
+        QVERIFY(!keys.contains(key));
+        keys.insert(key);
+    }
+}
+
+/**
+ * @brief Every attempt of one rename carries the same Idempotency-Key.
+ */
+void TestRetryPolicy::retriesReuseIdempotencyKey()
+{
+    m_failures = 2;
+    QVERIFY(APIClient(m_server->url()).renameFile("a.txt", "b.txt"));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_keys.size(), size_t(3));
+    QVERIFY(!m_keys[0].empty());
+    QCOMPARE(m_keys[1], m_keys[0]);
+    QCOMPARE(m_keys[2], m_keys[0]);
+}
+
+/**
+ * @brief Two separate renames are distinct operations with distinct keys.
+ */
+void TestRetryPolicy::separateCallsUseNewKeys()
+{
+    APIClient client(m_server->url());
+    QVERIFY(client.renameFile("a.txt", "b.txt"));
+    QVERIFY(client.renameFile("a.txt", "b.txt"));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_keys.size(), size_t(2));
+    QVERIFY(m_keys[0] != m_keys[1]);
+}
+
+/**
+ * @brief A status that will not change on retry is reported after one attempt.
+ */
+void TestRetryPolicy::finalStatusIsNotRetried()
+{
+    m_failures = 1;
+    m_failStatus = 409;
+    QVERIFY(!APIClient(m_server->url()).renameFile("a.txt", "b.txt"));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_keys.size(), size_t(1));
+}
+
+/**
+ * @brief A server that keeps failing gets exactly the attempts the policy allows.
+ */
+void TestRetryPolicy::givesUpAfterMaxAttempts()
+{
+    m_failures = 100;
+    QVERIFY(!APIClient(m_server->url()).renameFile("a.txt", "b.txt"));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_keys.size(), size_t(RetryPolicy::forOperation(RetryPolicy::Operation::Metadata).maxAttempts()));
+}
+
+/**
+ * @brief A retried batch request repeats its key, so the server can answer it from its record.
+ */
+void TestRetryPolicy::batchRetriesReuseIdempotencyKey()
+{
+    m_failures = 1;
+    std::vector<APIClient::BatchResult> results = APIClient(m_server->url()).deleteFiles({ "a.txt", "b.txt" });
+    QCOMPARE(results.size(), size_t(2));
+    QVERIFY(results[0].success && results[1].success);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_keys.size(), size_t(2));
+    QVERIFY(!m_keys[0].empty());
+    QCOMPARE(m_keys[1], m_keys[0]);
+}
+
+/**
+ * @brief An upload whose reply is lost after the server stored it is retried under the same key
+ *        and stored only once.
+ */
+void TestRetryPolicy::lostReplyDoesNotCreateTwice()
+{
+    const QByteArray content(4096, 'x');
+    QFile file(m_dir.filePath("committed.txt"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(content), qint64(content.size()));
+    file.close();
+
+    m_drops = 1;
+    QVERIFY(APIClient(m_server->url()).uploadFile(file.fileName()));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_keys.size(), size_t(2));
+    QVERIFY(!m_keys[0].empty());
+    QCOMPARE(m_keys[1], m_keys[0]);
+    QCOMPARE(m_uploads.size(), size_t(1));
+    QCOMPARE(m_uploads.begin()->second, content.toStdString());
+}
+
+/**
+ * @brief A pooled connection the server closed while it sat idle is replaced before the request
+ *        is sent, so the request neither fails once nor spends the retry budget.
+ */
+void TestRetryPolicy::closedIdleConnectionIsNotReused()
+{
+    APIClient client(m_server->url());
+    QVERIFY(client.renameFile("a.txt", "b.txt"));
+    std::this_thread::sleep_for(milliseconds(1500));
+
+    APIMetrics::instance().reset();
+    QVERIFY(client.renameFile("a.txt", "b.txt"));
+
+    const nlohmann::json metrics = APIMetrics::instance().toJson();
+    QCOMPARE(metrics.at("connections").at("reused").get<quint64>(), quint64(0));
+    QCOMPARE(metrics.at("connections").at("opened").get<quint64>(), quint64(1));
+    QCOMPARE(metrics.at("endpoints").at("/api/rename").at("retries").get<quint64>(), quint64(0));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QCOMPARE(m_keys.size(), size_t(2));
+}
+
+QTEST_GUILESS_MAIN(TestRetryPolicy)
+#include "tst_retrypolicy.moc"
@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_tarstream
+
+SOURCES += \
+    tst_tarstream.cpp \
+    $$PWD/../../tarstream.cpp
+
+HEADERS += \
+    $$PWD/../../tarstream.h
@@ -0,0 +1,332 @@
+#include "tarstream.h"
+#include "cpp-httplib/httplib.h"
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief One member read back from an archive.
+ */
+struct Member {
+    QByteArray name;
+    QByteArray data;
+    bool pax = false;  ///< true if the name came from a pax header
+};
+
+QByteArray randomData(int size, quint32 seed)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    QRandomGenerator generator(seed);
+    for (char &byte : data)
+        byte = static_cast<char>(generator.bounded(256));
+    return data;
+}
+
+/**
+ * @brief Pulls the whole archive out of @p tar the way httplib does, in increasing offsets.
+ * @return false if provide() failed.
+ */
+bool drain(TarStream &tar, QByteArray &archive)
+{
+    archive.clear();
+    httplib::DataSink sink;
+    sink.write = [&archive](const char *data, size_t length) {
+        archive.append(data, static_cast<int>(length));
+        return true;
+    };
+    while (archive.size() < tar.contentLength()) {
+        if (!tar.provide(archive.size(), sink))
+            return false;
+    }
+    return archive.size() == tar.contentLength();
+}
+
+/**
+ * @brief Checks a header's checksum and magic the way tar does.
+ */
+bool validHeader(const char *block)
+{
+    unsigned int sum = 0;
+    for (int i = 0; i < 512; ++i)
+        sum += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(block[i]);
+    return std::strtoul(block + 148, nullptr, 8) == sum && std::memcmp(block + 257, "ustar\0" "00", 8) == 0;
+}
+
+/**
+ * @brief Reads the members of a ustar/pax archive.
+ * @return false if a header is damaged or the archive does not end with two zero blocks.
+ */
+bool readArchive(const QByteArray &archive, std::vector<Member> &members)
+{
+    if (archive.size() % 512 != 0)
+        return false;
+    QByteArray paxName;
+    int pos = 0;
+    while (pos + 512 <= archive.size()) {
+        const char *block = archive.constData() + pos;
+        if (QByteArray(block, 512) == QByteArray(512, '\0'))
+            return pos + 1024 == archive.size() && archive.mid(pos) == QByteArray(1024, '\0');
+        if (!validHeader(block))
+            return false;
+        const int size = static_cast<int>(std::strtoll(block + 124, nullptr, 8));
+        const QByteArray data = archive.mid(pos + 512, size);
+        pos += 512 + (size + 511) / 512 * 512;
+
+        if (block[156] == 'x') {
+            // Records are "<length> key=value\n"; only the path is used here.
+            for (const QByteArray &record : data.split('\n')) {
+                int equals = record.indexOf('=');
+                int space = record.indexOf(' ');
+                if (space > 0 && equals > space && record.mid(space + 1, equals - space - 1) == "path")
+                    paxName = record.mid(equals + 1);
+            }
+            continue;
+        }
+        Member member;
+        member.pax = !paxName.isEmpty();
+        member.name = member.pax ? paxName : QByteArray(block, static_cast<int>(qstrnlen(block, 100)));
+        member.data = data;
+        members.push_back(member);
+        paxName.clear();
+    }
+    return false;
+}
+
+} // namespace
+
+/**
+ * @class TestTarStream
+ * @brief Reads back archives produced by TarStream and checks them against the source files.
+ */
+class TestTarStream : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+
+    void roundTrip();
+    void longNamesUsePax();
+    void paxRecordLengthCountsItself();
+    void rejectsMissingFiles();
+    void emptyArchiveIsTrailerOnly();
+    void shrunkFileIsPadded();
+    void restartsFromTheBeginning();
+    void restartForgetsUnreadable();
+    void progressCanCancel();
+
+private:
+    QString writeFile(const QString &name, const QByteArray &data);
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+/**
+ * @brief Gives each test an empty directory.
+ */
+void TestTarStream::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+}
+
+/**
+ * @brief Writes @p data to a file in the test directory and returns its path.
+ */
+QString TestTarStream::writeFile(const QString &name, const QByteArray &data)
+{
+    QString path = m_dir->filePath(name);
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        file.write(data);
+    return path;
+}
+
+/**
+ * @brief Files of assorted sizes come back with their names and contents, and the length matches.
+ */
+void TestTarStream::roundTrip()
+{
+    const std::vector<std::pair<QString, QByteArray>> files = {
+        { "empty.txt", QByteArray() },
+        { "one.bin", QByteArray("x") },
+        { "block.bin", randomData(512, 1) },
+        { "sub/dir/odd.bin", randomData(1000, 2) },
+        { "large.bin", randomData(200 * 1024 + 3, 3) },
+    };
+    TarStream tar;
+    for (size_t i = 0; i < files.size(); ++i)
+        QVERIFY(tar.addFile(writeFile(QString("file%1").arg(i), files[i].second), files[i].first));
+
+    QByteArray archive;
+    QVERIFY(drain(tar, archive));
+    std::vector<Member> members;
+    QVERIFY(readArchive(archive, members));
+    QCOMPARE(members.size(), files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        QCOMPARE(members[i].name, files[i].first.toUtf8());
+        QCOMPARE(members[i].data, files[i].second);
+        QVERIFY(!members[i].pax);
+    }
+    QVERIFY(tar.unreadable().empty());
+}
+
+/**
+ * @brief Names over 100 bytes are carried in a pax header and survive intact.
+ */
+void TestTarStream::longNamesUsePax()
+{
+    const QString longName = QString("deep/").repeated(30) + QString::fromUtf8("f\xc3\xa9ichier.txt");
+    TarStream tar;
+    QVERIFY(tar.addFile(writeFile("a", "payload"), longName));
+    QVERIFY(tar.addFile(writeFile("b", "short"), "short.txt"));
+
+    QByteArray archive;
+    QVERIFY(drain(tar, archive));
+    std::vector<Member> members;
+    QVERIFY(readArchive(archive, members));
+    QCOMPARE(members.size(), size_t(2));
+    QVERIFY(members[0].pax);
+    QCOMPARE(members[0].name, longName.toUtf8());
+    QCOMPARE(members[0].data, QByteArray("payload"));
+    QVERIFY(!members[1].pax);
+    QCOMPARE(members[1].name, QByteArray("short.txt"));
+}
+
+/**
+ * @brief The decimal length at the start of a pax record counts its own digits.
+ */
+void TestTarStream::paxRecordLengthCountsItself()
+{
+    // Name lengths around the point where the record length gains a digit.
+    for (int nameLength = 101; nameLength <= 1000; nameLength += 99) {
+        TarStream tar;
+        QVERIFY(tar.addFile(writeFile("f", "x"), QString(nameLength, QLatin1Char('n'))));
+        QByteArray archive;
+        QVERIFY(drain(tar, archive));
+        const int size = static_cast<int>(std::strtoll(archive.constData() + 124, nullptr, 8));
+        const QByteArray record = archive.mid(512, size);
+        QCOMPARE(record.left(record.indexOf(' ')).toInt(), record.size());
+        QVERIFY(record.endsWith('\n'));
+    }
+}
+
+/**
+ * @brief Missing paths and directories are refused.
+ */
+void TestTarStream::rejectsMissingFiles()
+{
+    TarStream tar;
+    QVERIFY(!tar.addFile(m_dir->filePath("missing"), "missing"));
+    QVERIFY(!tar.addFile(m_dir->path(), "dir"));
+    QCOMPARE(tar.contentLength(), qint64(1024));
+}
+
+/**
+ * @brief An archive without entries is just the end-of-archive blocks.
+ */
+void TestTarStream::emptyArchiveIsTrailerOnly()
+{
+    TarStream tar;
+    QByteArray archive;
+    QVERIFY(drain(tar, archive));
+    QCOMPARE(archive, QByteArray(1024, '\0'));
+}
+
+/**
+ * @brief A file that shrank after addFile() is zero-padded so the announced length holds.
+ */
+void TestTarStream::shrunkFileIsPadded()
+{
+    const QByteArray original = randomData(100 * 1024, 4);
+    const QString path = writeFile("shrinks", original);
+    TarStream tar;
+    QVERIFY(tar.addFile(writeFile("first", "first"), "first"));
+    QVERIFY(tar.addFile(path, "shrinks"));
+    const qint64 announced = tar.contentLength();
+    writeFile("shrinks", original.left(1000));
+
+    QByteArray archive;
+    QVERIFY(drain(tar, archive));
+    QCOMPARE(qint64(archive.size()), announced);
+    std::vector<Member> members;
+    QVERIFY(readArchive(archive, members));
+    QCOMPARE(members[1].data.size(), original.size());
+    QCOMPARE(members[1].data.left(1000), original.left(1000));
+    QCOMPARE(members[1].data.mid(1000), QByteArray(original.size() - 1000, '\0'));
+    QCOMPARE(tar.unreadable(), std::vector<size_t>{ 1 });
+}
+
+/**
+ * @brief After a retried request asks for offset 0 again, the same bytes are produced.
+ */
+void TestTarStream::restartsFromTheBeginning()
+{
+    TarStream tar;
+    QVERIFY(tar.addFile(writeFile("a", randomData(70 * 1024, 5)), "a"));
+    QVERIFY(tar.addFile(writeFile("b", randomData(3000, 6)), "b"));
+
+    QByteArray partial;
+    httplib::DataSink sink;
+    sink.write = [&partial](const char *data, size_t length) {
+        partial.append(data, static_cast<int>(length));
+        return true;
+    };
+    while (partial.size() < tar.contentLength() / 2)
+        QVERIFY(tar.provide(partial.size(), sink));
+
+    QByteArray first;
+    QVERIFY(drain(tar, first));
+    QVERIFY(first.startsWith(partial));
+    QByteArray second;
+    QVERIFY(drain(tar, second));
+    QCOMPARE(second, first);
+}
+
+/**
+ * @brief A retry reports only the files it could not read itself, not those of the pass before.
+ */
+void TestTarStream::restartForgetsUnreadable()
+{
+    const QByteArray original = randomData(100 * 1024, 8);
+    const QString path = writeFile("flaky", original);
+    TarStream tar;
+    QVERIFY(tar.addFile(writeFile("first", "first"), "first"));
+    QVERIFY(tar.addFile(path, "flaky"));
+    writeFile("flaky", original.left(1000));
+
+    QByteArray archive;
+    QVERIFY(drain(tar, archive));
+    QVERIFY(drain(tar, archive));
+    QCOMPARE(tar.unreadable(), std::vector<size_t>{ 1 });
+
+    writeFile("flaky", original);
+    QVERIFY(drain(tar, archive));
+    QVERIFY(tar.unreadable().empty());
+    std::vector<Member> members;
+    QVERIFY(readArchive(archive, members));
+    QCOMPARE(members[1].data, original);
+}
+
+/**
+ * @brief Returning false from the progress callback fails provide().
+ */
+void TestTarStream::progressCanCancel()
+{
+    TarStream tar;
+    QVERIFY(tar.addFile(writeFile("a", randomData(10000, 7)), "a"));
+    qint64 reportedTotal = 0;
+    tar.setProgress([&reportedTotal](qint64, qint64 total) {
+        reportedTotal = total;
+        return false;
+    });
+    QByteArray archive;
+    QVERIFY(!drain(tar, archive));
+    QCOMPARE(reportedTotal, tar.contentLength());
+}
+
+QTEST_APPLESS_MAIN(TestTarStream)
+#include "tst_tarstream.moc"
@@ -0,0 +1,12 @@
+# Settings shared by every unit test. Each test is its own Qt Test executable
+# that compiles the client sources it needs straight from the repository root.
+
+QT       += testlib
+QT       -= gui
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD/..
+INCLUDEPATH += $$PWD/../cpp-httplib
+INCLUDEPATH += $$PWD/../json
@@ -0,0 +1,21 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    apimetrics \
+    archiveupload \
+    batchoperations \
+    changenotifier \
+    compressionpolicy \
+    contentchunker \
+    deltaencoder \
+    filecatalog \
+    filehasher \
+    listingbenchmark \
+    listingcache \
+    listingparser \
+    ratelimiter \
+    resumabledownload \
+    retrypolicy \
+    tarstream \
+    transferbenchmark \
+    uploadsession
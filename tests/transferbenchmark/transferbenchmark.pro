@@ -0,0 +1,7 @@
+include(../tests.pri)
+include(../client.pri)
+
+TARGET = tst_transferbenchmark
+
+SOURCES += \
+    tst_transferbenchmark.cpp
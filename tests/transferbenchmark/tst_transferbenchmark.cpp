@@ -0,0 +1,338 @@
+#include "APIClient.h"
+#include "connectionpool.h"
+#include "localserver.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr qint64 kMiB = 1024 * 1024;
+
+/// Most the process's anonymous memory may grow during one upload, whatever the file size.
+constexpr qint64 kMaxRssGrowth = 32 * kMiB;
+
+/// Size of the file served for segmented downloads.
+constexpr qint64 kDownloadSize = 64 * kMiB;
+
+/// Pace of each download connection, so parallel segments have something to win on loopback.
+constexpr qint64 kConnectionRate = 32 * kMiB;
+
+/// Renames sent per row of the connection pool benchmark.
+constexpr int kMetadataRequests = 500;
+
+/**
+ * @brief Returns the byte at @p position of the served download; cheap to check without storing it.
+ */
+char patternByte(qint64 position)
+{
+    return static_cast<char>((position * 2654435761u) >> 24);
+}
+
+/**
+ * @brief Returns the process's anonymous resident memory, or -1 where /proc is not available.
+ *
+ * File-backed pages are left out, so a memory-mapped upload source does not count.
+ */
+qint64 anonymousRss()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly))
+        return -1;
+    for (const QByteArray &line : status.readAll().split('\n')) {
+        if (line.startsWith("RssAnon:"))
+            return line.mid(8).simplified().split(' ').first().toLongLong() * 1024;
+    }
+    return -1;
+}
+
+/**
+ * @brief Creates a sparse file of @p size bytes, so gigabyte rows cost no disk space.
+ */
+bool createFile(const QString &path, qint64 size)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.resize(size);
+}
+
+/**
+ * @brief Returns true if the 1 GB and 4 GB rows should run (LOCALDRIVE_LARGE_BENCHMARKS is set).
+ */
+bool largeBenchmarks()
+{
+    return qEnvironmentVariableIsSet("LOCALDRIVE_LARGE_BENCHMARKS");
+}
+
+} // namespace
+
+/**
+ * @class TestTransferBenchmark
+ * @brief Measures transfer throughput and memory against a LocalServer on loopback.
+ *
+ * Run with -tickcounter instead of the default wall clock for CPU cycles. Rows of a
+ * gigabyte and more only run with LOCALDRIVE_LARGE_BENCHMARKS set.
+ */
+class TestTransferBenchmark : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void uploadMemoryAndThroughput_data();
+    void uploadMemoryAndThroughput();
+    void segmentedDownload_data();
+    void segmentedDownload();
+    void metadataRequests_data();
+    void metadataRequests();
+    void uploadCpuPerGigabyte_data();
+    void uploadCpuPerGigabyte();
+
+private:
+    QTemporaryDir m_dir;
+    std::unique_ptr<LocalServer> m_server;
+    std::atomic<qint64> m_uploadedBytes{0};  ///< File bytes received by the last upload
+};
+
+/**
+ * @brief Keeps settings read by the client out of the user's configuration.
+ */
+void TestTransferBenchmark::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+}
+
+/**
+ * @brief Starts a server that counts uploaded file bytes as they stream in and keeps none of them,
+ *        serves a generated download at kConnectionRate per connection, and accepts renames.
+ */
+void TestTransferBenchmark::init()
+{
+    m_uploadedBytes = 0;
+    m_server = std::make_unique<LocalServer>();
+    m_server->server().Post("/api/upload", [this](const httplib::Request &, httplib::Response &,
+                                                  const httplib::ContentReader &reader) {
+        qint64 bytes = 0;
+        reader([](const httplib::MultipartFormData &) { return true; },
+               [&bytes](const char *, size_t length) {
+                   bytes += static_cast<qint64>(length);
+                   return true;
+               });
+        m_uploadedBytes = bytes;
+    });
+    m_server->server().Get(R"(/api/download/(.+))", [](const httplib::Request &, httplib::Response &res) {
+        res.set_header("ETag", "\"bench\"");
+        // httplib slices the provider to the requested range and answers 206 by itself.
+        res.set_content_provider(static_cast<size_t>(kDownloadSize), "application/zip",
+            [](size_t offset, size_t length, httplib::DataSink &sink) {
+                std::vector<char> piece(std::min<size_t>(length, 256 * 1024));
+                for (size_t i = 0; i < piece.size(); ++i)
+                    piece[i] = patternByte(static_cast<qint64>(offset + i));
+                std::this_thread::sleep_for(std::chrono::microseconds(piece.size() * 1000000 / kConnectionRate));
+                return sink.write(piece.data(), piece.size());
+            });
+    });
+    m_server->server().Post("/api/rename", [](const httplib::Request &, httplib::Response &) {});
+    QVERIFY(m_server->start());
+}
+
+void TestTransferBenchmark::cleanup()
+{
+    m_server.reset();
+}
+
+/**
+ * @brief Upload sizes; a .zip is never compressed, so the body is the file itself.
+ */
+void TestTransferBenchmark::uploadMemoryAndThroughput_data()
+{
+    QTest::addColumn<qint64>("size");
+    QTest::newRow("100 MB") << 100 * kMiB;
+    if (largeBenchmarks()) {
+        QTest::newRow("1 GB") << 1024 * kMiB;
+        QTest::newRow("4 GB") << 4096 * kMiB;
+    }
+}
+
+/**
+ * @brief Times one uploadFile() and checks that anonymous memory stays flat while it streams.
+ */
+void TestTransferBenchmark::uploadMemoryAndThroughput()
+{
+    QFETCH(qint64, size);
+    const QString path = m_dir.filePath("upload.zip");
+    QVERIFY(createFile(path, size));
+
+    APIClient client(m_server->url());
+    const qint64 rssBefore = anonymousRss();
+    qint64 rssPeak = rssBefore;
+    qint64 sampledAt = 0;
+    auto progress = [&](qint64 sent, qint64) {
+        if (sent - sampledAt >= 16 * kMiB) {
+            rssPeak = std::max(rssPeak, anonymousRss());
+            sampledAt = sent;
+        }
+        return true;
+    };
+
+    bool uploaded = false;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        uploaded = client.uploadFile(path, progress);
+    }
+    const qint64 elapsedMs = std::max<qint64>(1, timer.elapsed());
+    QFile::remove(path);
+
+    QVERIFY(uploaded);
+    QCOMPARE(m_uploadedBytes.load(), size);
+    qInfo().noquote() << QString("%1: %2 MB/s, anonymous RSS +%3 KB")
+                             .arg(QTest::currentDataTag())
+                             .arg(double(size) / kMiB * 1000.0 / elapsedMs, 0, 'f', 0)
+                             .arg((rssPeak - rssBefore) / 1024);
+    if (rssBefore >= 0)
+        QVERIFY(rssPeak - rssBefore < kMaxRssGrowth);
+}
+
+/**
+ * @brief Parallel connection counts to compare; 1 is a plain downloadFile().
+ */
+void TestTransferBenchmark::segmentedDownload_data()
+{
+    QTest::addColumn<int>("segments");
+    QTest::newRow("1 segment") << 1;
+    QTest::newRow("2 segments") << 2;
+    QTest::newRow("4 segments") << 4;
+    QTest::newRow("8 segments") << 8;
+}
+
+/**
+ * @brief Times a 64 MB download split over the given number of connections and checks every byte.
+ */
+void TestTransferBenchmark::segmentedDownload()
+{
+    QFETCH(int, segments);
+    const QString destination = m_dir.filePath("download.zip");
+    for (const char *suffix : { "", ".part", ".part.json", ".segments", ".segments.json" })
+        QFile::remove(destination + suffix);
+
+    APIClient client(m_server->url());
+    bool downloaded = false;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        downloaded = client.downloadFileSegmented("download.zip", destination, segments);
+    }
+    const qint64 elapsedMs = std::max<qint64>(1, timer.elapsed());
+    QVERIFY(downloaded);
+
+    QFile file(destination);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.size(), kDownloadSize);
+    for (qint64 position = 0; position < kDownloadSize;) {
+        const QByteArray block = file.read(kMiB);
+        QVERIFY(!block.isEmpty());
+        for (int i = 0; i < block.size(); ++i) {
+            if (block[i] != patternByte(position + i))
+                QFAIL(qPrintable(QString("Byte %1 differs").arg(position + i)));
+        }
+        position += block.size();
+    }
+    file.close();
+    QFile::remove(destination);
+
+    qInfo().noquote() << QString("%1: %2 MB/s (%3 MB/s per connection)")
+                             .arg(QTest::currentDataTag())
+                             .arg(double(kDownloadSize) / kMiB * 1000.0 / elapsedMs, 0, 'f', 0)
+                             .arg(kConnectionRate / kMiB);
+}
+
+/**
+ * @brief Whether idle connections are kept for reuse.
+ */
+void TestTransferBenchmark::metadataRequests_data()
+{
+    QTest::addColumn<bool>("pooled");
+    QTest::newRow("pooled") << true;
+    QTest::newRow("new connection per request") << false;
+}
+
+/**
+ * @brief Times kMetadataRequests small renames with and without the connection pool.
+ */
+void TestTransferBenchmark::metadataRequests()
+{
+    QFETCH(bool, pooled);
+    ConnectionPool::instance().clear();
+    ConnectionPool::instance().setMaxIdlePerHost(pooled ? 4 : 0);
+
+    APIClient client(m_server->url());
+    int succeeded = 0;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        for (int i = 0; i < kMetadataRequests; ++i)
+            succeeded += client.renameFile("a.txt", "b.txt") ? 1 : 0;
+    }
+    const qint64 elapsedMs = std::max<qint64>(1, timer.elapsed());
+    ConnectionPool::instance().setMaxIdlePerHost(4);
+
+    QCOMPARE(succeeded, kMetadataRequests);
+    qInfo().noquote() << QString("%1: %2 requests/s")
+                             .arg(QTest::currentDataTag())
+                             .arg(kMetadataRequests * 1000.0 / elapsedMs, 0, 'f', 0);
+}
+
+/**
+ * @brief Upload sizes for the CPU cost benchmark.
+ */
+void TestTransferBenchmark::uploadCpuPerGigabyte_data()
+{
+    QTest::addColumn<qint64>("size");
+    QTest::newRow("256 MB") << 256 * kMiB;
+    if (largeBenchmarks())
+        QTest::newRow("1 GB") << 1024 * kMiB;
+}
+
+/**
+ * @brief Prints the CPU time the uploading thread spends per GB sent from a memory-mapped file.
+ *
+ * The figure comes from CompressionReport::cpuMicros, which covers only the
+ * client's thread; the in-process server's reads are not counted. Run with
+ * -tickcounter for cycles instead of wall time.
+ */
+void TestTransferBenchmark::uploadCpuPerGigabyte()
+{
+    QFETCH(qint64, size);
+    const QString path = m_dir.filePath("cpu.zip");
+    QVERIFY(createFile(path, size));
+
+    APIClient client(m_server->url());
+    bool uploaded = false;
+    QBENCHMARK_ONCE {
+        uploaded = client.uploadFile(path);
+    }
+    QFile::remove(path);
+    QVERIFY(uploaded);
+    QCOMPARE(m_uploadedBytes.load(), size);
+
+    const double gigabytes = double(size) / (1024 * kMiB);
+    qInfo().noquote() << QString("%1: %2 ms CPU per GB")
+                             .arg(QTest::currentDataTag())
+                             .arg(client.lastCompression().cpuMicros / 1000.0 / gigabytes, 0, 'f', 1);
+}
+
+QTEST_GUILESS_MAIN(TestTransferBenchmark)
+#include "tst_transferbenchmark.moc"
@@ -0,0 +1,218 @@
+#include "APIClient.h"
+#include "localserver.h"
+#include "json/json.hpp"
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Chunk size used by APIClient::uploadFileChunked().
+constexpr qint64 kChunkSize = 4 * 1024 * 1024;
+
+/// Local file size: two full chunks and a short last one.
+constexpr qint64 kFileSize = 2 * kChunkSize + 5000;
+
+} // namespace
+
+/**
+ * @class TestUploadSession
+ * @brief Interrupts chunked upload sessions and checks that only unacknowledged bytes are sent again.
+ *
+ * The local server keeps one session in memory, appends each PUT whose offset
+ * matches what it holds, and reports its offset the way the real server does.
+ */
+class TestUploadSession : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void uploadsInChunks();
+    void resumesInLaterCall();
+    void rereadsOffsetAfterLostAcknowledgement();
+    void fallsBackWithoutSessionSupport();
+
+private:
+    bool writeFile(const QString &path);
+
+    QTemporaryDir m_dir;
+    QString m_filePath;
+    QByteArray m_contents;
+    std::unique_ptr<LocalServer> m_server;
+
+    std::mutex m_mutex;
+    int m_sessionsOpened = 0;
+    QByteArray m_received;            ///< Bytes the session holds so far
+    std::vector<qint64> m_putOffsets; ///< Offset named by every chunk PUT, in order
+    bool m_committed = false;
+    int m_failPut = -1;               ///< Store this PUT but answer 500, or -1
+    bool m_sessionsSupported = true;
+    QByteArray m_plainUpload;         ///< Body of a fallback /api/upload
+};
+
+/**
+ * @brief Keeps the remembered session ids out of the user's configuration.
+ */
+void TestUploadSession::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_dir.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_dir.path());
+}
+
+/**
+ * @brief Writes a fresh local file and starts a server with the session endpoints.
+ */
+void TestUploadSession::init()
+{
+    m_filePath = m_dir.filePath(QString("upload-%1.bin").arg(QTest::currentTestFunction()));
+    QVERIFY(writeFile(m_filePath));
+    m_sessionsOpened = 0;
+    m_received.clear();
+    m_putOffsets.clear();
+    m_committed = false;
+    m_failPut = -1;
+    m_sessionsSupported = true;
+    m_plainUpload.clear();
+
+    m_server = std::make_unique<LocalServer>();
+    httplib::Server &server = m_server->server();
+    auto offsetBody = [this]() { return nlohmann::json{ { "offset", m_received.size() } }.dump(); };
+
+    server.Post("/api/upload/session", [this](const httplib::Request &, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_sessionsSupported) {
+            res.status = 404;
+            return;
+        }
+        ++m_sessionsOpened;
+        m_received.clear();
+        res.set_content(nlohmann::json{ { "id", "s1" }, { "offset", 0 } }.dump(), "application/json");
+    });
+    server.Get(R"(/api/upload/session/([^/]+))", [this, offsetBody](const httplib::Request &, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        res.set_content(offsetBody(), "application/json");
+    });
+    server.Put(R"(/api/upload/session/([^/]+))", [this, offsetBody](const httplib::Request &req, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        qint64 offset = std::stoll(req.get_param_value("offset"));
+        m_putOffsets.push_back(offset);
+        if (offset == m_received.size())
+            m_received.append(req.body.data(), static_cast<int>(req.body.size()));
+        if (static_cast<int>(m_putOffsets.size()) - 1 == m_failPut) {
+            res.status = 500;
+            return;
+        }
+        res.set_content(offsetBody(), "application/json");
+    });
+    server.Post(R"(/api/upload/session/([^/]+)/commit)", [this](const httplib::Request &, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_committed = m_received.size() == kFileSize;
+        res.status = m_committed ? 200 : 409;
+    });
+    server.Post("/api/upload", [this](const httplib::Request &req, httplib::Response &res) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (req.has_file("file"))
+            m_plainUpload = QByteArray::fromStdString(req.get_file_value("file").content);
+        res.status = 200;
+    });
+    QVERIFY(m_server->start());
+}
+
+/**
+ * @brief Stops the server so the next test gets a fresh port and connection pool entry.
+ */
+void TestUploadSession::cleanup()
+{
+    m_server.reset();
+}
+
+/**
+ * @brief Fills @p path with kFileSize random bytes and keeps a copy in m_contents.
+ */
+bool TestUploadSession::writeFile(const QString &path)
+{
+    m_contents = QByteArray(static_cast<int>(kFileSize), Qt::Uninitialized);
+    QRandomGenerator generator(42);
+    for (char &byte : m_contents)
+        byte = static_cast<char>(generator.bounded(256));
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(m_contents) == kFileSize;
+}
+
+/**
+ * @brief An uninterrupted upload sends each chunk once, in order, and commits.
+ */
+void TestUploadSession::uploadsInChunks()
+{
+    QVERIFY(APIClient(m_server->url()).uploadFileChunked(m_filePath));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QVERIFY(m_committed);
+    QCOMPARE(m_received, m_contents);
+    QCOMPARE(m_putOffsets, (std::vector<qint64>{ 0, kChunkSize, 2 * kChunkSize }));
+}
+
+/**
+ * @brief A cancelled upload is continued by the next call from the server's offset, in the same session.
+ */
+void TestUploadSession::resumesInLaterCall()
+{
+    QVERIFY(!APIClient(m_server->url()).uploadFileChunked(m_filePath,
+        [](qint64 sent, qint64) { return sent < kChunkSize; }));
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        QVERIFY(!m_committed);
+        QVERIFY(m_received.size() == kChunkSize);
+    }
+
+    QVERIFY(APIClient(m_server->url()).uploadFileChunked(m_filePath));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QVERIFY(m_committed);
+    QCOMPARE(m_sessionsOpened, 1);
+    QCOMPARE(m_received, m_contents);
+    QCOMPARE(m_putOffsets, (std::vector<qint64>{ 0, kChunkSize, 2 * kChunkSize }));
+}
+
+/**
+ * @brief When a stored chunk's reply is lost, the client asks for the offset instead of resending it.
+ */
+void TestUploadSession::rereadsOffsetAfterLostAcknowledgement()
+{
+    m_failPut = 1;
+
+    QVERIFY(APIClient(m_server->url()).uploadFileChunked(m_filePath));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QVERIFY(m_committed);
+    QCOMPARE(m_received, m_contents);
+    QCOMPARE(m_putOffsets, (std::vector<qint64>{ 0, kChunkSize, 2 * kChunkSize }));
+}
+
+/**
+ * @brief A server without session endpoints still gets the file as a plain upload.
+ */
+void TestUploadSession::fallsBackWithoutSessionSupport()
+{
+    m_sessionsSupported = false;
+
+    QVERIFY(APIClient(m_server->url()).uploadFileChunked(m_filePath));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QVERIFY(m_putOffsets.empty());
+    QCOMPARE(m_plainUpload, m_contents);
+}
+
+QTEST_GUILESS_MAIN(TestUploadSession)
+#include "tst_uploadsession.moc"
@@ -0,0 +1,7 @@
+include(../tests.pri)
+include(../client.pri)
+
+TARGET = tst_uploadsession
+
+SOURCES += \
+    tst_uploadsession.cpp
@@ -110,6 +110,18 @@ Toolbar::Toolbar(QWidget *parent)
     });
     layout->addWidget(uploadBtn);
 
+    // Upload Folder Button
+    uploadFolderBtn = new QPushButton("Upload Folder", this);
+    uploadFolderBtn->setStyleSheet(
+        "QPushButton { background-color: #14bcfb; color: #000000; padding: 8px 16px; border-radius: 4px; }"
+        "QPushButton:hover:!disabled { background-color: #0056b3; }"
+        "QPushButton:disabled { background-color: #F0F0F0; color: #AAAAAA; }"
+        );
+    connect(uploadFolderBtn, &QPushButton::clicked, this, [this]() {
+        emit uploadFolderRequested();
+    });
+    layout->addWidget(uploadFolderBtn);
+
     // Download Button
     downloadBtn = new QPushButton("Download", this);
     downloadBtn->setStyleSheet(
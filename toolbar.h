@@ -52,6 +52,11 @@ signals:
      */
     void uploadRequested();
 
+    /**
+     * @brief Emitted when the upload folder button is clicked.
+     */
+    void uploadFolderRequested();
+
     /**
      * @brief Emitted when the download button is clicked
      */
@@ -77,6 +82,7 @@ private:
     QPushButton *deleteBtn;     ///< Button to delete selected files
     QPushButton *sortBtn;       ///< Button to open sort menu
     QPushButton *uploadBtn;     ///< Button to upload a new file
+    QPushButton *uploadFolderBtn; ///< Button to upload a whole folder
     QPushButton *downloadBtn;   ///< Button to download selected file
     QPushButton *selectAllBtn;  ///< Button to toggle all file selections
 
@@ -0,0 +1,511 @@
+#include "transfermanager.h"
+#include "APIClient.h"
+#include "filehasher.h"
+#include "ratelimiter.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QSettings>
+#include <QThreadPool>
+#include <QTimer>
+#include <QtConcurrent>
+#include <algorithm>
+#include <limits>
+#include "json/json.hpp"
+
+namespace {
+
+/// Files at least this large are uploaded as deduplicated chunks (falling back to a resumable session).
+constexpr qint64 kChunkedUploadThreshold = 8 * 1024 * 1024;
+
+/// Uploads at least this large are hashed first so the server can skip content it already has.
+constexpr qint64 kPreflightThreshold = 256 * 1024;
+
+/// Replacement uploads at least this large are sent as an rsync-style delta.
+constexpr qint64 kDeltaUploadThreshold = 1024 * 1024;
+
+/// Downloads at least this large are fetched as parallel segments.
+constexpr qint64 kSegmentedDownloadThreshold = 2 * APIClient::kMinSegmentSize;
+
+/// Jobs with fewer remaining bytes than this count as small and get a reserved slot.
+constexpr qint64 kSmallTransferThreshold = 16 * 1024 * 1024;
+
+/// How often running jobs are sampled for progress and throughput.
+constexpr int kSampleIntervalMs = 500;
+
+/// Weight of the newest sample in the smoothed throughput.
+constexpr double kThroughputSmoothing = 0.3;
+
+const char *const kQueueSettingsKey = "transfers/queue";
+
+qint64 remainingBytes(const TransferJob &job) {
+    // Unknown sizes sort after every known one.
+    return job.size > 0 ? job.size - job.transferred : std::numeric_limits<qint64>::max();
+}
+
+bool isSmall(const TransferJob &job) {
+    return remainingBytes(job) < kSmallTransferThreshold;
+}
+
+} // namespace
+
+/**
+ * @brief Estimates the remaining time from the smoothed throughput.
+ */
+qint64 TransferJob::etaSeconds() const
+{
+    if (state != State::Running || size <= 0 || bytesPerSecond <= 0.0)
+        return -1;
+    return static_cast<qint64>((size - transferred) / bytesPerSecond);
+}
+
+/**
+ * @brief Constructs the manager, restores the saved queue, and starts sampling progress.
+ */
+TransferManager::TransferManager(const QString &serverUrl, QObject *parent)
+    : QObject(parent), m_serverUrl(serverUrl), m_pool(new QThreadPool(this)), m_sampleTimer(new QTimer(this))
+{
+    m_pool->setMaxThreadCount(kMaxConcurrentTransfers);
+    connect(m_sampleTimer, &QTimer::timeout, this, &TransferManager::sampleProgress);
+    m_sampleTimer->start(kSampleIntervalMs);
+
+    load();
+    schedule();
+}
+
+/**
+ * @brief Pauses running transfers so they can resume on the next launch.
+ *
+ * Workers stop at their next chunk boundary; waiting for them here means none
+ * outlives the manager or reports back to it afterwards.
+ */
+TransferManager::~TransferManager()
+{
+    for (auto &entry : m_entries) {
+        if (entry.control)
+            entry.control->request = Control::Pause;
+    }
+    m_pool->waitForDone();
+    for (auto &entry : m_entries) {
+        if (entry.control) {
+            entry.job.transferred = entry.control->transferred;
+            entry.job.state = TransferJob::State::Paused;
+            entry.control.reset();
+        }
+    }
+    save();
+}
+
+int TransferManager::enqueueUpload(const QString &localPath, int priority, bool replacesRemote)
+{
+    TransferJob job;
+    job.type = TransferJob::Type::Upload;
+    job.localPath = localPath;
+    job.remoteName = QFileInfo(localPath).fileName();
+    job.size = QFileInfo(localPath).size();
+    job.priority = priority;
+    job.replacesRemote = replacesRemote;
+    return add(job);
+}
+
+int TransferManager::enqueueDownload(const QString &remoteName, const QString &localPath, qint64 size, int priority)
+{
+    TransferJob job;
+    job.type = TransferJob::Type::Download;
+    job.localPath = localPath;
+    job.remoteName = remoteName;
+    job.size = size;
+    job.priority = priority;
+    return add(job);
+}
+
+/**
+ * @brief Pauses a job. A running transfer stops at its next chunk boundary.
+ */
+void TransferManager::pause(int id)
+{
+    Entry *entry = find(id);
+    if (!entry)
+        return;
+    if (entry->control) {
+        entry->control->request = Control::Pause;
+    } else if (entry->job.state == TransferJob::State::Queued) {
+        entry->job.state = TransferJob::State::Paused;
+        save();
+        emit jobChanged(id);
+    }
+}
+
+/**
+ * @brief Requeues a paused or failed job; it continues from where it stopped.
+ */
+void TransferManager::resume(int id)
+{
+    Entry *entry = find(id);
+    if (!entry || entry->control)
+        return;
+    if (entry->job.state == TransferJob::State::Paused || entry->job.state == TransferJob::State::Failed) {
+        entry->job.state = TransferJob::State::Queued;
+        save();
+        emit jobChanged(id);
+        schedule();
+    }
+}
+
+/**
+ * @brief Cancels a job and discards any partial download.
+ */
+void TransferManager::cancel(int id)
+{
+    Entry *entry = find(id);
+    if (!entry || entry->job.isFinished())
+        return;
+    if (entry->control) {
+        entry->control->request = Control::Cancel;
+        return;
+    }
+    entry->job.state = TransferJob::State::Cancelled;
+    discardPartialData(entry->job);
+    save();
+    emit jobChanged(id);
+}
+
+void TransferManager::setPriority(int id, int priority)
+{
+    Entry *entry = find(id);
+    if (!entry)
+        return;
+    entry->job.priority = priority;
+    save();
+    emit jobChanged(id);
+    schedule();
+}
+
+void TransferManager::setRateLimit(int id, qint64 bytesPerSecond)
+{
+    Entry *entry = find(id);
+    if (!entry)
+        return;
+    entry->job.rateLimit = std::max<qint64>(0, bytesPerSecond);
+    if (entry->control)
+        entry->control->limiter->setRate(entry->job.rateLimit);
+    save();
+    emit jobChanged(id);
+}
+
+void TransferManager::setMaxConcurrent(int count)
+{
+    m_maxConcurrent = std::clamp(count, 1, kMaxConcurrentTransfers);
+    schedule();
+}
+
+void TransferManager::clearFinished()
+{
+    for (int i = m_entries.size() - 1; i >= 0; --i) {
+        if (m_entries[i].job.isFinished()) {
+            int id = m_entries[i].job.id;
+            m_entries.removeAt(i);
+            emit jobRemoved(id);
+        }
+    }
+}
+
+QList<TransferJob> TransferManager::jobs() const
+{
+    QList<TransferJob> result;
+    for (const auto &entry : m_entries)
+        result.append(entry.job);
+    return result;
+}
+
+TransferJob TransferManager::job(int id) const
+{
+    const Entry *entry = find(id);
+    return entry ? entry->job : TransferJob();
+}
+
+TransferManager::Entry *TransferManager::find(int id)
+{
+    for (auto &entry : m_entries) {
+        if (entry.job.id == id)
+            return &entry;
+    }
+    return nullptr;
+}
+
+const TransferManager::Entry *TransferManager::find(int id) const
+{
+    for (const auto &entry : m_entries) {
+        if (entry.job.id == id)
+            return &entry;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Assigns an id, stores the job, and starts it if a slot is free.
+ */
+int TransferManager::add(TransferJob job)
+{
+    job.id = m_nextId++;
+    job.state = TransferJob::State::Queued;
+    Entry entry;
+    entry.job = job;
+    m_entries.append(entry);
+    save();
+    emit jobAdded(job.id);
+    schedule();
+    return job.id;
+}
+
+/**
+ * @brief Starts queued jobs until the concurrency limit is reached.
+ *
+ * Order is priority first, then fewest remaining bytes, then queue order. When
+ * more than one slot exists, large jobs may use all but one of them so a small
+ * file can always start.
+ */
+void TransferManager::schedule()
+{
+    int running = 0;
+    int runningLarge = 0;
+    QList<int> queued;
+    for (int i = 0; i < m_entries.size(); ++i) {
+        const TransferJob &job = m_entries[i].job;
+        if (job.state == TransferJob::State::Running) {
+            running++;
+            if (!isSmall(job))
+                runningLarge++;
+        } else if (job.state == TransferJob::State::Queued) {
+            queued.append(i);
+        }
+    }
+
+    std::sort(queued.begin(), queued.end(), [this](int a, int b) {
+        const TransferJob &ja = m_entries[a].job;
+        const TransferJob &jb = m_entries[b].job;
+        if (ja.priority != jb.priority)
+            return ja.priority > jb.priority;
+        if (remainingBytes(ja) != remainingBytes(jb))
+            return remainingBytes(ja) < remainingBytes(jb);
+        return ja.id < jb.id;
+    });
+
+    const int largeSlots = (m_maxConcurrent > 1) ? m_maxConcurrent - 1 : 1;
+    for (int index : queued) {
+        if (running >= m_maxConcurrent)
+            break;
+        Entry &entry = m_entries[index];
+        bool small = isSmall(entry.job);
+        if (!small && runningLarge >= largeSlots)
+            continue;
+        start(entry);
+        running++;
+        if (!small)
+            runningLarge++;
+    }
+}
+
+/**
+ * @brief Runs a job on the transfer pool.
+ *
+ * The worker reports progress through the shared Control block and stops at
+ * the next chunk once a pause or cancel is requested.
+ */
+void TransferManager::start(Entry &entry)
+{
+    auto control = std::make_shared<Control>();
+    control->transferred = entry.job.transferred;
+    control->total = entry.job.size;
+    control->limiter = std::make_shared<RateLimiter>(entry.job.rateLimit);
+    entry.control = control;
+    entry.sampledBytes = entry.job.transferred;
+    entry.job.state = TransferJob::State::Running;
+    entry.job.bytesPerSecond = 0.0;
+    emit jobChanged(entry.job.id);
+
+    const TransferJob job = entry.job;
+    const QString serverUrl = m_serverUrl;
+    auto work = [serverUrl, job, control]() {
+        auto progress = [control](qint64 transferred, qint64 total) {
+            control->transferred = transferred;
+            if (total > 0)
+                control->total = total;
+            return control->request == Control::Run;
+        };
+        APIClient apiClient(serverUrl);
+        // Queued transfers are bulk traffic and give way to interactive requests.
+        apiClient.setTransferClass(APIClient::TransferClass::Background);
+        if (job.type == TransferJob::Type::Upload)
+            apiClient.setRateLimiters(control->limiter, nullptr);
+        else
+            apiClient.setRateLimiters(nullptr, control->limiter);
+        auto finish = [&apiClient, control](bool success) {
+            control->compression = apiClient.lastCompression();
+            return success;
+        };
+        if (job.type == TransferJob::Type::Download) {
+            // Large files, and any segmented download already under way, use parallel ranges.
+            if (job.size >= kSegmentedDownloadThreshold || QFile::exists(job.localPath + ".segments.json"))
+                return finish(apiClient.downloadFileSegmented(job.remoteName, job.localPath, 0, progress));
+            return finish(apiClient.downloadFile(job.remoteName, job.localPath, progress));
+        }
+        if (job.size >= kPreflightThreshold) {
+            QByteArray hash = FileHasher::hashFile(job.localPath, [control](qint64, qint64) {
+                return control->request == Control::Run;
+            });
+            if (control->request != Control::Run)
+                return false;
+            if (!hash.isEmpty() && apiClient.linkExistingContent(job.localPath, hash)) {
+                progress(job.size, job.size);
+                return true;
+            }
+        }
+        if (job.replacesRemote && job.size >= kDeltaUploadThreshold)
+            return finish(apiClient.uploadFileDelta(job.localPath, progress));
+        if (job.size >= kChunkedUploadThreshold)
+            return finish(apiClient.uploadFileDeduplicated(job.localPath, progress));
+        return finish(apiClient.uploadFile(job.localPath, progress));
+    };
+
+    auto *watcher = new QFutureWatcher<bool>(this);
+    const int id = entry.job.id;
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher, id]() {
+        onWorkerDone(id, watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(m_pool, work));
+}
+
+/**
+ * @brief Records the outcome of a worker and starts the next job.
+ */
+void TransferManager::onWorkerDone(int id, bool success)
+{
+    Entry *entry = find(id);
+    if (!entry || !entry->control)
+        return;
+
+    std::shared_ptr<Control> control = entry->control;
+    entry->control.reset();
+    entry->job.transferred = control->transferred;
+    if (control->total > 0)
+        entry->job.size = control->total;
+    entry->job.bytesPerSecond = 0.0;
+    entry->job.compression = control->compression;
+
+    if (success) {
+        entry->job.state = TransferJob::State::Completed;
+        entry->job.transferred = entry->job.size;
+    } else if (control->request == Control::Pause) {
+        entry->job.state = TransferJob::State::Paused;
+    } else if (control->request == Control::Cancel) {
+        entry->job.state = TransferJob::State::Cancelled;
+        discardPartialData(entry->job);
+    } else {
+        entry->job.state = TransferJob::State::Failed;
+    }
+
+    save();
+    emit jobChanged(id);
+    emit jobFinished(id, success);
+    schedule();
+}
+
+/**
+ * @brief Copies worker progress into the jobs and updates smoothed throughput.
+ */
+void TransferManager::sampleProgress()
+{
+    const double seconds = kSampleIntervalMs / 1000.0;
+    for (auto &entry : m_entries) {
+        if (!entry.control)
+            continue;
+        qint64 transferred = entry.control->transferred;
+        qint64 total = entry.control->total;
+        double rate = (transferred - entry.sampledBytes) / seconds;
+        entry.sampledBytes = transferred;
+        entry.job.transferred = transferred;
+        if (total > 0)
+            entry.job.size = total;
+        entry.job.bytesPerSecond = (entry.job.bytesPerSecond <= 0.0)
+                                       ? rate
+                                       : kThroughputSmoothing * rate + (1.0 - kThroughputSmoothing) * entry.job.bytesPerSecond;
+        emit jobChanged(entry.job.id);
+    }
+}
+
+/**
+ * @brief Removes the resume data of a cancelled download.
+ */
+void TransferManager::discardPartialData(const TransferJob &job) const
+{
+    if (job.type != TransferJob::Type::Download)
+        return;
+    QFile::remove(job.localPath + ".part");
+    QFile::remove(job.localPath + ".part.json");
+    QFile::remove(job.localPath + ".segments");
+    QFile::remove(job.localPath + ".segments.json");
+}
+
+/**
+ * @brief Persists every unfinished job to QSettings.
+ */
+void TransferManager::save() const
+{
+    nlohmann::json queue = nlohmann::json::array();
+    for (const auto &entry : m_entries) {
+        const TransferJob &job = entry.job;
+        if (job.isFinished())
+            continue;
+        queue.push_back({
+            { "id", job.id },
+            { "type", job.type == TransferJob::Type::Upload ? "upload" : "download" },
+            { "local", job.localPath.toStdString() },
+            { "remote", job.remoteName.toStdString() },
+            { "priority", job.priority },
+            { "size", job.size },
+            { "transferred", job.transferred },
+            { "replaces", job.replacesRemote },
+            { "limit", job.rateLimit },
+            { "paused", job.state == TransferJob::State::Paused }
+        });
+    }
+    QSettings settings("YourCompany", "LocalDrive");
+    settings.setValue(kQueueSettingsKey, QString::fromStdString(queue.dump()));
+}
+
+/**
+ * @brief Restores unfinished jobs saved by a previous session.
+ *
+ * Jobs that were running or failed are queued again; paused jobs stay paused.
+ */
+void TransferManager::load()
+{
+    QSettings settings("YourCompany", "LocalDrive");
+    std::string saved = settings.value(kQueueSettingsKey).toString().toStdString();
+    if (saved.empty())
+        return;
+
+    try {
+        for (const auto &item : nlohmann::json::parse(saved)) {
+            Entry entry;
+            TransferJob &job = entry.job;
+            job.id = item.value("id", 0);
+            job.type = item.value("type", "") == "download" ? TransferJob::Type::Download : TransferJob::Type::Upload;
+            job.localPath = QString::fromStdString(item.value("local", ""));
+            job.remoteName = QString::fromStdString(item.value("remote", ""));
+            job.priority = item.value("priority", 0);
+            job.size = item.value("size", qint64(0));
+            job.transferred = item.value("transferred", qint64(0));
+            job.replacesRemote = item.value("replaces", false);
+            job.rateLimit = item.value("limit", qint64(0));
+            job.state = item.value("paused", false) ? TransferJob::State::Paused : TransferJob::State::Queued;
+            m_nextId = std::max(m_nextId, job.id + 1);
+            m_entries.append(entry);
+        }
+    } catch (...) {
+        // A corrupt queue is dropped rather than blocking startup.
+        m_entries.clear();
+    }
+}
@@ -0,0 +1,182 @@
+#ifndef TRANSFERMANAGER_H
+#define TRANSFERMANAGER_H
+
+#include "compressionpolicy.h"
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <atomic>
+#include <memory>
+
+class QThreadPool;
+class RateLimiter;
+class QTimer;
+
+/**
+ * @struct TransferJob
+ * @brief One queued upload or download and its current progress.
+ */
+struct TransferJob {
+    enum class Type { Upload, Download };
+    enum class State { Queued, Running, Paused, Completed, Failed, Cancelled };
+
+    int id = 0;                     ///< Identifier unique within the queue
+    Type type = Type::Upload;       ///< Direction of the transfer
+    QString localPath;              ///< Source (upload) or destination (download) on disk
+    QString remoteName;             ///< File name on the server
+    int priority = 0;               ///< Higher values are started first
+    qint64 size = 0;                ///< Total bytes, or 0 while unknown
+    qint64 transferred = 0;         ///< Bytes transferred so far
+    State state = State::Queued;    ///< Current lifecycle state
+    double bytesPerSecond = 0.0;    ///< Smoothed throughput while running
+    bool replacesRemote = false;    ///< Upload overwrites an existing server file, so a delta is tried first
+    qint64 rateLimit = 0;           ///< Cap for this transfer in bytes per second, or 0 for none
+    CompressionReport compression;  ///< What wire compression did for the last run
+
+    /**
+     * @brief Returns true once the job will not run again without user action.
+     */
+    bool isFinished() const { return state == State::Completed || state == State::Cancelled; }
+
+    /**
+     * @brief Estimated seconds until completion, or -1 if unknown.
+     */
+    qint64 etaSeconds() const;
+};
+
+/**
+ * @class TransferManager
+ * @brief Background queue of uploads and downloads with a concurrency limit.
+ *
+ * Jobs are started in priority order; among equal priorities the job with the
+ * fewest remaining bytes goes first, and one slot is kept free for small files
+ * so they are never stuck behind large ones. Paused jobs resume where they
+ * stopped (resumable downloads and chunked upload sessions), and unfinished
+ * jobs are saved to QSettings so the queue survives an application restart.
+ * Queued transfers run as background traffic and yield to interactive requests.
+ * They have a thread pool of their own, so bulk transfers never hold up the
+ * listings, renames and deletes on AsyncAPIClient::networkPool().
+ */
+class TransferManager : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the manager and restores any saved queue.
+     * @param serverUrl The base URL of the API server.
+     * @param parent Optional parent QObject.
+     */
+    explicit TransferManager(const QString &serverUrl = "http://localhost:8080", QObject *parent = nullptr);
+
+    /**
+     * @brief Stops running transfers, waits for their workers, and saves the queue.
+     */
+    ~TransferManager() override;
+
+    /// Upper bound for setMaxConcurrent().
+    static constexpr int kMaxConcurrentTransfers = 4;
+
+    /**
+     * @brief Queues a local file for upload.
+     * @param replacesRemote true if the server already has a file with this name;
+     *        only the differences from that copy are then sent.
+     * @return The new job's id.
+     */
+    int enqueueUpload(const QString &localPath, int priority = 0, bool replacesRemote = false);
+
+    /**
+     * @brief Queues a server file for download.
+     * @param size Expected size if already known, or 0.
+     * @return The new job's id.
+     */
+    int enqueueDownload(const QString &remoteName, const QString &localPath, qint64 size = 0, int priority = 0);
+
+    void pause(int id);
+    void resume(int id);
+    void cancel(int id);
+
+    /**
+     * @brief Changes a queued job's priority.
+     */
+    void setPriority(int id, int priority);
+
+    /**
+     * @brief Caps one job's throughput, on top of the global limits; 0 removes the cap.
+     *
+     * A running transfer picks up the new cap at its next block.
+     */
+    void setRateLimit(int id, qint64 bytesPerSecond);
+
+    /**
+     * @brief Sets how many transfers may run at once, clamped to 1..kMaxConcurrentTransfers.
+     */
+    void setMaxConcurrent(int count);
+    int maxConcurrent() const { return m_maxConcurrent; }
+
+    /**
+     * @brief Drops completed and cancelled jobs from the list.
+     */
+    void clearFinished();
+
+    QList<TransferJob> jobs() const;
+    TransferJob job(int id) const;
+
+signals:
+    /**
+     * @brief Emitted when a job is added to the queue.
+     */
+    void jobAdded(int id);
+
+    /**
+     * @brief Emitted when a job's state or progress changes.
+     */
+    void jobChanged(int id);
+
+    /**
+     * @brief Emitted when a job is removed by clearFinished().
+     */
+    void jobRemoved(int id);
+
+    /**
+     * @brief Emitted when a running transfer stops for any reason.
+     * @param success true if the transfer completed.
+     */
+    void jobFinished(int id, bool success);
+
+private:
+    /// State shared with the worker thread running a job.
+    struct Control {
+        enum Request { Run, Pause, Cancel };
+        std::atomic<int> request{ Run };
+        std::atomic<qint64> transferred{ 0 };
+        std::atomic<qint64> total{ 0 };
+        std::shared_ptr<RateLimiter> limiter;  ///< The job's own cap, shared with its APIClient
+        CompressionReport compression;         ///< Written by the worker before it returns
+    };
+
+    struct Entry {
+        TransferJob job;
+        std::shared_ptr<Control> control;  ///< Set while the job is running
+        qint64 sampledBytes = 0;           ///< Bytes seen at the last throughput sample
+    };
+
+    Entry *find(int id);
+    const Entry *find(int id) const;
+    int add(TransferJob job);
+    void schedule();
+    void start(Entry &entry);
+    void onWorkerDone(int id, bool success);
+    void sampleProgress();
+    void discardPartialData(const TransferJob &job) const;
+    void save() const;
+    void load();
+
+    QString m_serverUrl;
+    QList<Entry> m_entries;
+    int m_nextId = 1;
+    int m_maxConcurrent = 2;
+    QThreadPool *m_pool;             ///< Runs transfer workers, separate from the interactive network pool
+    QTimer *m_sampleTimer;
+};
+
+#endif // TRANSFERMANAGER_H
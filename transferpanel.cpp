@@ -0,0 +1,187 @@
+#include "transferpanel.h"
+#include "transfermanager.h"
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QInputDialog>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+enum Column { NameColumn, DirectionColumn, ProgressColumn, SpeedColumn, EtaColumn, StateColumn, ColumnCount };
+
+QString formatBytes(double bytes)
+{
+    const char *units[] = { "B", "KB", "MB", "GB", "TB" };
+    int unit = 0;
+    while (bytes >= 1024.0 && unit < 4) {
+        bytes /= 1024.0;
+        unit++;
+    }
+    return QString::number(bytes, 'f', unit == 0 ? 0 : 1) + " " + units[unit];
+}
+
+QString formatEta(qint64 seconds)
+{
+    if (seconds < 0)
+        return "";
+    return QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+}
+
+QString stateName(TransferJob::State state)
+{
+    switch (state) {
+    case TransferJob::State::Queued:    return "Queued";
+    case TransferJob::State::Running:   return "Running";
+    case TransferJob::State::Paused:    return "Paused";
+    case TransferJob::State::Completed: return "Done";
+    case TransferJob::State::Failed:    return "Failed";
+    case TransferJob::State::Cancelled: return "Cancelled";
+    }
+    return "";
+}
+
+} // namespace
+
+/**
+ * @brief Builds the job table and control buttons and loads the current queue.
+ */
+TransferPanel::TransferPanel(TransferManager *manager, QWidget *parent)
+    : QWidget(parent), m_manager(manager)
+{
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(10, 0, 10, 10);
+    layout->setSpacing(6);
+
+    m_table = new QTableWidget(0, ColumnCount, this);
+    m_table->setHorizontalHeaderLabels({ "File", "Direction", "Progress", "Speed", "ETA", "State" });
+    m_table->horizontalHeader()->setSectionResizeMode(NameColumn, QHeaderView::Stretch);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->setFixedHeight(140);
+    layout->addWidget(m_table);
+
+    QHBoxLayout *buttons = new QHBoxLayout();
+    QPushButton *pauseBtn = new QPushButton("Pause", this);
+    QPushButton *resumeBtn = new QPushButton("Resume", this);
+    QPushButton *cancelBtn = new QPushButton("Cancel", this);
+    QPushButton *limitBtn = new QPushButton("Limit Speed...", this);
+    QPushButton *clearBtn = new QPushButton("Clear Finished", this);
+    buttons->addStretch();
+    buttons->addWidget(pauseBtn);
+    buttons->addWidget(resumeBtn);
+    buttons->addWidget(cancelBtn);
+    buttons->addWidget(limitBtn);
+    buttons->addWidget(clearBtn);
+    layout->addLayout(buttons);
+    setLayout(layout);
+
+    connect(pauseBtn, &QPushButton::clicked, this, [this]() { m_manager->pause(selectedJobId()); });
+    connect(resumeBtn, &QPushButton::clicked, this, [this]() { m_manager->resume(selectedJobId()); });
+    connect(cancelBtn, &QPushButton::clicked, this, [this]() { m_manager->cancel(selectedJobId()); });
+    connect(limitBtn, &QPushButton::clicked, this, &TransferPanel::editRateLimit);
+    connect(clearBtn, &QPushButton::clicked, m_manager, &TransferManager::clearFinished);
+
+    connect(m_manager, &TransferManager::jobAdded, this, &TransferPanel::onJobAdded);
+    connect(m_manager, &TransferManager::jobChanged, this, &TransferPanel::onJobChanged);
+    connect(m_manager, &TransferManager::jobRemoved, this, &TransferPanel::onJobRemoved);
+
+    for (const TransferJob &job : m_manager->jobs())
+        onJobAdded(job.id);
+    updateVisibility();
+}
+
+/**
+ * @brief Appends a row for a newly queued job.
+ */
+void TransferPanel::onJobAdded(int id)
+{
+    int row = m_table->rowCount();
+    m_table->insertRow(row);
+    for (int column = 0; column < ColumnCount; ++column)
+        m_table->setItem(row, column, new QTableWidgetItem());
+    m_rowIds.append(id);
+    updateRow(row);
+    updateVisibility();
+}
+
+/**
+ * @brief Refreshes the row of a job whose state or progress changed.
+ */
+void TransferPanel::onJobChanged(int id)
+{
+    int row = m_rowIds.indexOf(id);
+    if (row >= 0)
+        updateRow(row);
+}
+
+/**
+ * @brief Removes the row of a job dropped from the queue.
+ */
+void TransferPanel::onJobRemoved(int id)
+{
+    int row = m_rowIds.indexOf(id);
+    if (row < 0)
+        return;
+    m_table->removeRow(row);
+    m_rowIds.removeAt(row);
+    updateVisibility();
+}
+
+/**
+ * @brief Asks for a speed cap for the selected job, in KB/s (0 = unlimited).
+ */
+void TransferPanel::editRateLimit()
+{
+    int id = selectedJobId();
+    if (id < 0)
+        return;
+    bool ok = false;
+    int kilobytes = QInputDialog::getInt(this, "Limit Speed", "Maximum speed for this transfer in KB/s (0 = unlimited):",
+                                         static_cast<int>(m_manager->job(id).rateLimit / 1024), 0, 1024 * 1024, 1, &ok);
+    if (ok)
+        m_manager->setRateLimit(id, static_cast<qint64>(kilobytes) * 1024);
+}
+
+int TransferPanel::selectedJobId() const
+{
+    int row = m_table->currentRow();
+    return (row >= 0 && row < m_rowIds.size()) ? m_rowIds[row] : -1;
+}
+
+void TransferPanel::updateRow(int row)
+{
+    TransferJob job = m_manager->job(m_rowIds[row]);
+
+    QString progress = formatBytes(job.transferred);
+    if (job.size > 0)
+        progress += QString(" / %1 (%2%)").arg(formatBytes(job.size)).arg(job.transferred * 100 / job.size);
+
+    QString details;
+    if (job.compression.compressed) {
+        const CompressionReport &report = job.compression;
+        progress += QString(", %1 sent (gzip %2x)").arg(formatBytes(report.wireBytes)).arg(report.ratio(), 0, 'f', 1);
+        details = QString("Compressed %1 to %2 on the wire, %3 ms of CPU time")
+                      .arg(formatBytes(report.rawBytes))
+                      .arg(formatBytes(report.wireBytes))
+                      .arg(report.cpuMicros / 1000);
+    }
+
+    QString speed = job.state == TransferJob::State::Running ? formatBytes(job.bytesPerSecond) + "/s" : "";
+    if (job.rateLimit > 0)
+        speed = (speed + QString(" (max %1/s)").arg(formatBytes(job.rateLimit))).trimmed();
+
+    m_table->item(row, NameColumn)->setText(job.remoteName);
+    m_table->item(row, DirectionColumn)->setText(job.type == TransferJob::Type::Upload ? "Upload" : "Download");
+    m_table->item(row, ProgressColumn)->setText(progress);
+    m_table->item(row, ProgressColumn)->setToolTip(details);
+    m_table->item(row, SpeedColumn)->setText(speed);
+    m_table->item(row, EtaColumn)->setText(formatEta(job.etaSeconds()));
+    m_table->item(row, StateColumn)->setText(stateName(job.state));
+}
+
+void TransferPanel::updateVisibility()
+{
+    setVisible(!m_rowIds.isEmpty());
+}
@@ -0,0 +1,56 @@
+#ifndef TRANSFERPANEL_H
+#define TRANSFERPANEL_H
+
+#include <QWidget>
+#include <QList>
+
+class QPushButton;
+class QTableWidget;
+class TransferManager;
+
+/**
+ * @class TransferPanel
+ * @brief Lists queued and running transfers with their progress, throughput, and ETA.
+ *
+ * Offers pause, resume, cancel, and a speed cap for the selected job and hides
+ * itself while the queue is empty.
+ */
+class TransferPanel : public QWidget
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the panel for the given manager.
+     * @param manager The transfer queue to display.
+     * @param parent Optional parent widget.
+     */
+    explicit TransferPanel(TransferManager *manager, QWidget *parent = nullptr);
+
+private slots:
+    void onJobAdded(int id);
+    void onJobChanged(int id);
+    void onJobRemoved(int id);
+    void editRateLimit();
+
+private:
+    TransferManager *m_manager;   ///< Source of job state
+    QTableWidget *m_table;        ///< One row per job
+    QList<int> m_rowIds;          ///< Job id shown in each table row
+
+    /**
+     * @brief Returns the id of the job in the selected row, or -1.
+     */
+    int selectedJobId() const;
+
+    /**
+     * @brief Refreshes the cells of one row from the manager.
+     */
+    void updateRow(int row);
+
+    /**
+     * @brief Shows the panel only while it has rows.
+     */
+    void updateVisibility();
+};
+
+#endif // TRANSFERPANEL_H